@@ -5,6 +5,7 @@
 #include <irrpoly.h>
 
 #include <iostream>
+#include <string>
 #include <thread>
 
 using namespace irrpoly;
@@ -17,7 +18,8 @@ auto generate_irreducible(
     const uintmax_t degree,
     const typename multithread::irreducible_method irr_meth,
     const typename multithread::primitive_method prim_meth,
-    const unsigned threads_num
+    const unsigned threads_num,
+    const uint64_t seed
 ) -> std::vector<gfpoly> {
     std::vector<gfpoly> arr;
     arr.reserve(num);
@@ -25,11 +27,14 @@ auto generate_irreducible(
     multithread::polychecker ch(threads_num);
 
     auto field = make_gf(base);
+    // candidates depend only on the seed and their index, so they are the same for the same seed
+    uint64_t index = 0;
     auto input = [&]() -> gfpoly {
-        return gfpoly::random(field, degree);
+        return random_indexed(field, degree, seed, index++);
     };
 
-    auto check = multithread::make_check_func(irr_meth, prim_meth);
+    // checks are cheap for small degrees, so polynomials are passed to workers by chunks
+    auto check = multithread::make_batch_check_func(irr_meth, prim_meth);
 
     auto callback = [&](const gfpoly &poly, const typename multithread::check_result &res) -> bool {
         if (res.irreducible) {
@@ -39,20 +44,23 @@ auto generate_irreducible(
         return !num;
     };
 
-    ch.chain(input, check, callback);
+    ch.chain_batch(input, check, callback);
 
     return arr;
 }
 
-auto main() -> int {
+/// Optional argument is the seed of candidates printed by the previous run, so it could be replayed.
+auto main(int argc, char *argv[]) -> int {
     const uintmax_t base = 2; //< Galois field base
     const uintmax_t num = 3; //< number of polynomials to find
     const uintmax_t degree = 5; // degree of polynomials to find
     const auto irr_meth = multithread::irreducible_method::benor; // irreducibility test to use
     const auto prim_meth = multithread::primitive_method::nil; // primitivity test to use
     const unsigned threads_num = std::thread::hardware_concurrency(); // number of threads to use
+    const uint64_t seed = (argc > 1) ? std::stoull(argv[1]) : std::random_device{}(); // seed of candidates
 
-    auto poly = generate_irreducible(base, num, degree, irr_meth, prim_meth, threads_num);
+    std::cout << "seed " << seed << std::endl;
+    auto poly = generate_irreducible(base, num, degree, irr_meth, prim_meth, threads_num, seed);
     for (const auto &p : poly) {
         std::cout << p << std::endl;
     }
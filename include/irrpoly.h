@@ -9,3 +9,10 @@
 #pragma once
 
 #include "irrpoly/gfcheck.hpp"
+#include "irrpoly/gfenum.hpp"
+#include "irrpoly/gftable.hpp"
+#include "irrpoly/gfio.hpp"
+#include "irrpoly/gfeval.hpp"
+#include "irrpoly/gfcost.hpp"
+#include "irrpoly/gfext.hpp"
+#include "irrpoly/stats.hpp"
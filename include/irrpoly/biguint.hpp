@@ -0,0 +1,775 @@
+/**
+ * @file    biguint.hpp
+ * @author  Vadim Piven <vadim@piven.tech>
+ * @license Free use of this library is permitted under the
+ * guidelines and in accordance with the MIT License (MIT).
+ * @url     https://github.com/irreducible-polynoms/irrpoly
+ */
+
+#pragma once
+
+#include "stop.hpp"
+
+#include <vector>
+#include <cstdint>
+#include <string>
+#include <ostream>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+#include <mutex>
+
+namespace irrpoly::detail {
+
+class montgomery;
+
+/**
+ * biguint represents arbitrary precision unsigned integer. It implements only the
+ * operations required for exponents like P^n - 1 and their factorization.
+ * Number is stored as little-endian sequence of 32-bit limbs, highest limb is non-zero.
+ */
+class biguint final {
+private:
+    std::vector<uint32_t> m_data; ///< limbs, zero has no limbs
+
+    friend class montgomery;
+
+    /**
+     * Removes leading zero limbs.
+     */
+    auto reduce() -> biguint & {
+        while (!m_data.empty() && m_data.back() == 0) {
+            m_data.pop_back();
+        }
+        return *this;
+    }
+
+    [[nodiscard]]
+    static
+    auto compare(const biguint &a, const biguint &b) -> int {
+        if (a.m_data.size() != b.m_data.size()) {
+            return a.m_data.size() < b.m_data.size() ? -1 : 1;
+        }
+        for (auto i = a.m_data.size(); i > 0; --i) {
+            if (a.m_data[i - 1] != b.m_data[i - 1]) {
+                return a.m_data[i - 1] < b.m_data[i - 1] ? -1 : 1;
+            }
+        }
+        return 0;
+    }
+
+public:
+    biguint(uintmax_t val = 0) : m_data() { // NOLINT(google-explicit-constructor)
+        while (val) {
+            m_data.push_back(static_cast<uint32_t>(val));
+            val >>= 32U;
+        }
+    }
+
+    /**
+     * Parses decimal number, throws std::invalid_argument if str has other characters.
+     */
+    [[nodiscard]]
+    static
+    auto parse(const std::string &str) -> biguint {
+        if (str.empty()) {
+            throw std::invalid_argument("empty number");
+        }
+        biguint res;
+        const biguint ten(10);
+        for (const auto c : str) {
+            if (c < '0' || c > '9') {
+                throw std::invalid_argument("not a decimal number: " + str);
+            }
+            res *= ten;
+            res += biguint(static_cast<uintmax_t>(c - '0'));
+        }
+        return res;
+    }
+
+    /**
+     * Calculates base^exp.
+     */
+    [[nodiscard]]
+    static
+    auto power(const biguint &base, uintmax_t exp) -> biguint {
+        biguint res(1), b(base);
+        for (; exp; exp >>= 1U) {
+            if (exp & 1U) {
+                res *= b;
+            }
+            if (exp > 1) {
+                b *= b;
+            }
+        }
+        return res;
+    }
+
+    [[nodiscard]]
+    auto is_zero() const -> bool {
+        return m_data.empty();
+    }
+
+    explicit operator bool() const {
+        return !is_zero();
+    }
+
+    /**
+     * Returns the number of significant bits, zero for zero.
+     */
+    [[nodiscard]]
+    auto bit_length() const -> uintmax_t {
+        if (m_data.empty()) {
+            return 0;
+        }
+        uintmax_t top = 32;
+        while (!(m_data.back() >> (top - 1))) {
+            --top;
+        }
+        return (m_data.size() - 1) * 32 + top;
+    }
+
+    [[nodiscard]]
+    auto bit(const uintmax_t i) const -> bool {
+        return (i / 32 < m_data.size()) && ((m_data[i / 32] >> (i % 32)) & 1U);
+    }
+
+    /**
+     * Returns true if number fits uintmax_t.
+     */
+    [[nodiscard]]
+    auto is_small() const -> bool {
+        return m_data.size() <= 2;
+    }
+
+    /**
+     * Converts number to uintmax_t, throws if it doesn't fit.
+     */
+    [[nodiscard]]
+    auto value() const -> uintmax_t {
+        if (!is_small()) {
+            throw std::overflow_error("number doesn't fit uintmax_t");
+        }
+        uintmax_t res = 0;
+        for (auto i = m_data.size(); i > 0; --i) {
+            res = (res << 32U) | m_data[i - 1];
+        }
+        return res;
+    }
+
+    auto operator+=(const biguint &other) -> biguint & {
+        if (m_data.size() < other.m_data.size()) {
+            m_data.resize(other.m_data.size(), 0);
+        }
+        uint64_t carry = 0;
+        for (uintmax_t i = 0; i < m_data.size(); ++i) {
+            carry += m_data[i];
+            if (i < other.m_data.size()) {
+                carry += other.m_data[i];
+            }
+            m_data[i] = static_cast<uint32_t>(carry);
+            carry >>= 32U;
+        }
+        if (carry) {
+            m_data.push_back(static_cast<uint32_t>(carry));
+        }
+        return *this;
+    }
+
+    /**
+     * Requires other to be not greater than this.
+     */
+    auto operator-=(const biguint &other) -> biguint & {
+        if (compare(*this, other) < 0) {
+            throw std::underflow_error("negative result");
+        }
+        int64_t borrow = 0;
+        for (uintmax_t i = 0; i < m_data.size(); ++i) {
+            int64_t t = static_cast<int64_t>(m_data[i]) - borrow;
+            if (i < other.m_data.size()) {
+                t -= other.m_data[i];
+            }
+            borrow = t < 0 ? 1 : 0;
+            m_data[i] = static_cast<uint32_t>(t + (borrow << 32U));
+        }
+        return reduce();
+    }
+
+    auto operator*=(const biguint &other) -> biguint & {
+        if (is_zero() || other.is_zero()) {
+            m_data.clear();
+            return *this;
+        }
+        std::vector<uint32_t> prod(m_data.size() + other.m_data.size(), 0);
+        for (uintmax_t i = 0; i < m_data.size(); ++i) {
+            uint64_t carry = 0;
+            for (uintmax_t j = 0; j < other.m_data.size(); ++j) {
+                carry += static_cast<uint64_t>(m_data[i]) * other.m_data[j] + prod[i + j];
+                prod[i + j] = static_cast<uint32_t>(carry);
+                carry >>= 32U;
+            }
+            prod[i + other.m_data.size()] = static_cast<uint32_t>(carry);
+        }
+        m_data.swap(prod);
+        return reduce();
+    }
+
+    /**
+     * Divides this by small divisor in place, returns remainder.
+     */
+    auto divmod(const uint32_t d) -> uint32_t {
+        if (d == 0) {
+            throw std::invalid_argument("division by zero");
+        }
+        uint64_t rem = 0;
+        for (auto i = m_data.size(); i > 0; --i) {
+            rem = (rem << 32U) | m_data[i - 1];
+            m_data[i - 1] = static_cast<uint32_t>(rem / d);
+            rem %= d;
+        }
+        reduce();
+        return static_cast<uint32_t>(rem);
+    }
+
+    /**
+     * Calculates quotient and remainder using Knuth's algorithm D
+     * (as given in Warren's "Hacker's Delight").
+     */
+    [[nodiscard]]
+    static
+    auto divmod(const biguint &u, const biguint &v) -> std::pair<biguint, biguint> {
+        if (v.is_zero()) {
+            throw std::invalid_argument("division by zero");
+        }
+        if (compare(u, v) < 0) {
+            return std::make_pair(biguint(), u);
+        }
+        if (v.m_data.size() == 1) {
+            biguint q(u);
+            const auto r = q.divmod(v.m_data[0]);
+            return std::make_pair(std::move(q), biguint(r));
+        }
+
+        const auto m = u.m_data.size(), n = v.m_data.size();
+        unsigned s = 0;
+        while (!((v.m_data.back() << s) & 0x80000000U)) {
+            ++s;
+        }
+        // normalized copies, un has one extra limb
+        std::vector<uint32_t> vn(n), un(m + 1);
+        for (auto i = n - 1; i > 0; --i) {
+            vn[i] = (v.m_data[i] << s) |
+                (s ? static_cast<uint32_t>(static_cast<uint64_t>(v.m_data[i - 1]) >> (32U - s)) : 0);
+        }
+        vn[0] = v.m_data[0] << s;
+        un[m] = s ? static_cast<uint32_t>(static_cast<uint64_t>(u.m_data[m - 1]) >> (32U - s)) : 0;
+        for (auto i = m - 1; i > 0; --i) {
+            un[i] = (u.m_data[i] << s) |
+                (s ? static_cast<uint32_t>(static_cast<uint64_t>(u.m_data[i - 1]) >> (32U - s)) : 0);
+        }
+        un[0] = u.m_data[0] << s;
+
+        biguint q;
+        q.m_data.assign(m - n + 1, 0);
+        constexpr uint64_t b = uint64_t(1) << 32U;
+        for (auto j = m - n + 1; j > 0;) {
+            --j;
+            const uint64_t num = (static_cast<uint64_t>(un[j + n]) << 32U) | un[j + n - 1];
+            uint64_t qhat = num / vn[n - 1];
+            uint64_t rhat = num % vn[n - 1];
+            while (qhat >= b || qhat * vn[n - 2] > ((rhat << 32U) | un[j + n - 2])) {
+                --qhat;
+                rhat += vn[n - 1];
+                if (rhat >= b) {
+                    break;
+                }
+            }
+            // multiply and subtract
+            int64_t k = 0, t = 0;
+            for (uintmax_t i = 0; i < n; ++i) {
+                const uint64_t p = qhat * vn[i];
+                t = static_cast<int64_t>(un[i + j]) - k - static_cast<int64_t>(p & 0xFFFFFFFFU);
+                un[i + j] = static_cast<uint32_t>(t);
+                k = static_cast<int64_t>(p >> 32U) - (t >> 32);
+            }
+            t = static_cast<int64_t>(un[j + n]) - k;
+            un[j + n] = static_cast<uint32_t>(t);
+            q.m_data[j] = static_cast<uint32_t>(qhat);
+            if (t < 0) {
+                // subtracted too much, add back
+                q.m_data[j] -= 1;
+                uint64_t c = 0;
+                for (uintmax_t i = 0; i < n; ++i) {
+                    c += static_cast<uint64_t>(un[i + j]) + vn[i];
+                    un[i + j] = static_cast<uint32_t>(c);
+                    c >>= 32U;
+                }
+                un[j + n] = static_cast<uint32_t>(un[j + n] + c);
+            }
+        }
+
+        biguint r;
+        r.m_data.resize(n);
+        for (uintmax_t i = 0; i < n; ++i) {
+            r.m_data[i] = (un[i] >> s) |
+                (s ? static_cast<uint32_t>(static_cast<uint64_t>(un[i + 1]) << (32U - s)) : 0);
+        }
+        q.reduce();
+        r.reduce();
+        return std::make_pair(std::move(q), std::move(r));
+    }
+
+    auto operator/=(const biguint &other) -> biguint & {
+        return *this = divmod(*this, other).first;
+    }
+
+    auto operator%=(const biguint &other) -> biguint & {
+        return *this = divmod(*this, other).second;
+    }
+
+    friend
+    auto operator+(biguint a, const biguint &b) -> biguint {
+        a += b;
+        return a;
+    }
+
+    friend
+    auto operator-(biguint a, const biguint &b) -> biguint {
+        a -= b;
+        return a;
+    }
+
+    friend
+    auto operator*(biguint a, const biguint &b) -> biguint {
+        a *= b;
+        return a;
+    }
+
+    friend
+    auto operator/(const biguint &a, const biguint &b) -> biguint {
+        return divmod(a, b).first;
+    }
+
+    friend
+    auto operator%(const biguint &a, const biguint &b) -> biguint {
+        return divmod(a, b).second;
+    }
+
+#define BIGUINT_COMPARISON_OPERATORS(op) \
+    friend \
+    auto operator op(const biguint &a, const biguint &b) -> bool { \
+        return compare(a, b) op 0; \
+    }
+
+    BIGUINT_COMPARISON_OPERATORS(==)
+    BIGUINT_COMPARISON_OPERATORS(!=)
+    BIGUINT_COMPARISON_OPERATORS(<)
+    BIGUINT_COMPARISON_OPERATORS(<=)
+    BIGUINT_COMPARISON_OPERATORS(>)
+    BIGUINT_COMPARISON_OPERATORS(>=)
+
+#undef BIGUINT_COMPARISON_OPERATORS
+
+    [[nodiscard]]
+    auto to_string() const -> std::string {
+        if (is_zero()) {
+            return "0";
+        }
+        std::string res;
+        biguint tmp(*this);
+        while (!tmp.is_zero()) {
+            res.push_back(static_cast<char>('0' + tmp.divmod(10)));
+        }
+        std::reverse(res.begin(), res.end());
+        return res;
+    }
+
+    template<class charT, class traits>
+    friend
+    auto operator<<(std::basic_ostream<charT, traits> &os, const biguint &val)
+    -> std::basic_ostream<charT, traits> & {
+        return os << val.to_string();
+    }
+};
+
+/**
+ * Calculates greatest common divisor of two numbers.
+ */
+[[nodiscard]]
+inline
+auto gcd(biguint a, biguint b) -> biguint {
+    while (b) {
+        a %= b;
+        std::swap(a, b);
+    }
+    return a;
+}
+
+/**
+ * Checks if val is prime using Miller-Rabin test with first 12 primes as witnesses.
+ * The answer is exact for all numbers below 3.3 * 10^24 and probable for larger ones.
+ */
+[[nodiscard]]
+inline
+auto is_prime(const biguint &val) -> bool {
+    if (val < 2) {
+        return false;
+    }
+    const std::vector<uint32_t> witnesses = {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37};
+    for (auto p : witnesses) {
+        biguint tmp(val);
+        if (tmp.divmod(p) == 0) {
+            return val == p;
+        }
+    }
+    const biguint one(1), n1 = val - one;
+    biguint d = n1;
+    uintmax_t s = 0;
+    while (!d.bit(0)) {
+        d.divmod(2);
+        ++s;
+    }
+    for (auto a : witnesses) {
+        biguint x(1), b(a);
+        for (uintmax_t i = 0, len = d.bit_length(); i < len; ++i) {
+            if (d.bit(i)) {
+                x = x * b % val;
+            }
+            b = b * b % val;
+        }
+        if (x == one || x == n1) {
+            continue;
+        }
+        bool composite = true;
+        for (uintmax_t r = 1; r < s && composite; ++r) {
+            x = x * x % val;
+            composite = (x != n1);
+        }
+        if (composite) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Montgomery arithmetic modulo odd n on fixed-size limb vectors, so Pollard's rho
+ * makes no allocations and no long divisions per step. Numbers are kept below n,
+ * mul returns a * b / 2^(32k) mod n for n of k limbs.
+ */
+class montgomery final {
+public:
+    using limbs = std::vector<uint32_t>;
+
+private:
+    limbs m_mod;
+    uint32_t m_inv; ///< -n^(-1) mod 2^32
+    limbs m_tmp; ///< k + 2 limbs of product being reduced
+
+    /**
+     * Subtracts n from a if a >= n, hi is the limb above the top one of a.
+     */
+    void normalize(uint32_t *a, const uint32_t hi) const {
+        const auto k = m_mod.size();
+        if (!hi) {
+            for (auto i = k; i > 0; --i) {
+                if (a[i - 1] != m_mod[i - 1]) {
+                    if (a[i - 1] < m_mod[i - 1]) {
+                        return;
+                    }
+                    break;
+                }
+            }
+        }
+        int64_t borrow = 0;
+        for (std::size_t i = 0; i < k; ++i) {
+            const int64_t t = static_cast<int64_t>(a[i]) - m_mod[i] - borrow;
+            borrow = t < 0 ? 1 : 0;
+            a[i] = static_cast<uint32_t>(t);
+        }
+    }
+
+public:
+    explicit
+    montgomery(const biguint &n) : m_mod(n.m_data), m_inv(0), m_tmp(n.m_data.size() + 2) {
+        if (!n.bit(0)) {
+            throw std::invalid_argument("Montgomery modulus must be odd");
+        }
+        uint32_t x = m_mod[0]; // inverse modulo 2^3, Newton's step doubles the precision
+        for (int i = 0; i < 4; ++i) {
+            x *= 2 - m_mod[0] * x;
+        }
+        m_inv = 0 - x;
+    }
+
+    /**
+     * Returns limbs of v < n.
+     */
+    [[nodiscard]]
+    auto to_limbs(const biguint &v) const -> limbs {
+        limbs res(v.m_data);
+        res.resize(m_mod.size(), 0);
+        return res;
+    }
+
+    [[nodiscard]]
+    static
+    auto from_limbs(const limbs &a) -> biguint {
+        biguint res;
+        res.m_data = a;
+        res.reduce();
+        return res;
+    }
+
+    /**
+     * a = a * b / 2^(32k) mod n, coarsely integrated operand scanning.
+     */
+    void mul(limbs &a, const limbs &b) {
+        const auto k = m_mod.size();
+        std::fill(m_tmp.begin(), m_tmp.end(), 0);
+        for (std::size_t i = 0; i < k; ++i) {
+            uint64_t c = 0;
+            for (std::size_t j = 0; j < k; ++j) {
+                c += m_tmp[j] + static_cast<uint64_t>(a[j]) * b[i];
+                m_tmp[j] = static_cast<uint32_t>(c);
+                c >>= 32U;
+            }
+            c += m_tmp[k];
+            m_tmp[k] = static_cast<uint32_t>(c);
+            m_tmp[k + 1] = static_cast<uint32_t>(c >> 32U);
+
+            const uint32_t m = m_tmp[0] * m_inv;
+            c = (m_tmp[0] + static_cast<uint64_t>(m) * m_mod[0]) >> 32U;
+            for (std::size_t j = 1; j < k; ++j) {
+                c += m_tmp[j] + static_cast<uint64_t>(m) * m_mod[j];
+                m_tmp[j - 1] = static_cast<uint32_t>(c);
+                c >>= 32U;
+            }
+            c += m_tmp[k];
+            m_tmp[k - 1] = static_cast<uint32_t>(c);
+            m_tmp[k] = m_tmp[k + 1] + static_cast<uint32_t>(c >> 32U);
+        }
+        normalize(m_tmp.data(), m_tmp[k]);
+        std::copy(m_tmp.begin(), m_tmp.begin() + static_cast<std::ptrdiff_t>(k), a.begin());
+    }
+
+    /**
+     * a = a + c mod n, requires c < n.
+     */
+    void add(limbs &a, const uint32_t c) const {
+        uint64_t carry = c;
+        for (std::size_t i = 0; i < a.size() && carry; ++i) {
+            carry += a[i];
+            a[i] = static_cast<uint32_t>(carry);
+            carry >>= 32U;
+        }
+        normalize(a.data(), static_cast<uint32_t>(carry));
+    }
+
+    /**
+     * res = |a - b|.
+     */
+    static
+    void diff(const limbs &a, const limbs &b, limbs &res) {
+        auto i = a.size();
+        while (i > 0 && a[i - 1] == b[i - 1]) {
+            --i;
+        }
+        const bool swap = i > 0 && a[i - 1] < b[i - 1];
+        const auto &x = swap ? b : a, &y = swap ? a : b;
+        int64_t borrow = 0;
+        for (std::size_t j = 0; j < a.size(); ++j) {
+            const int64_t t = static_cast<int64_t>(x[j]) - y[j] - borrow;
+            borrow = t < 0 ? 1 : 0;
+            res[j] = static_cast<uint32_t>(t);
+        }
+    }
+};
+
+/**
+ * Finds non-trivial divisor of composite n using Brent's variant of Pollard's rho.
+ * Iterates y -> y^2 / R + c in Montgomery arithmetic, it's as good pseudo-random
+ * map as y^2 + c, and differences are accumulated the same way as R is a unit.
+ * Throws operation_cancelled between batches of steps once stop is requested.
+ */
+[[nodiscard]]
+inline
+auto pollard_brent(const biguint &n) -> biguint {
+    if (!n.bit(0)) {
+        return biguint(2);
+    }
+    constexpr uintmax_t batch = 128;
+    montgomery mont(n);
+    using limbs = montgomery::limbs;
+    for (uint32_t c = 1;; ++c) {
+        auto f = [&](limbs &x) {
+            mont.mul(x, x);
+            mont.add(x, c);
+        };
+        limbs y = mont.to_limbs(2), x, ys, q = mont.to_limbs(1), d(y.size());
+        biguint g(1);
+        for (uintmax_t r = 1; g == 1; r <<= 1U) {
+            x = y;
+            for (uintmax_t i = 0; i < r; ++i) {
+                f(y);
+            }
+            for (uintmax_t k = 0; k < r && g == 1; k += batch) {
+                ys = y;
+                for (uintmax_t i = 0; i < std::min(batch, r - k); ++i) {
+                    f(y);
+                    montgomery::diff(x, y, d);
+                    mont.mul(q, d);
+                }
+                g = gcd(montgomery::from_limbs(q), n);
+                throw_if_stopped();
+            }
+        }
+        if (g == n) {
+            // product of differences vanished, repeat step by step
+            do {
+                f(ys);
+                montgomery::diff(x, ys, d);
+                g = gcd(montgomery::from_limbs(d), n);
+            } while (g == 1);
+        }
+        if (g != n) {
+            return g;
+        }
+    }
+}
+
+/**
+ * Primes which are registered as known divisors: prime_divisors takes them out
+ * before Pollard's rho, so numbers with large factors (Cunningham tables list them
+ * for P^n +- 1) are factored at once.
+ */
+class known_primes final {
+    std::mutex m_mutex;
+    std::vector<biguint> m_primes;
+
+    known_primes() : m_mutex(), m_primes() {
+        // divisors rho doesn't find in a second: of 2^n - 1 for n <= 256, 512 and 1024,
+        // of 3^n - 1 for n <= 128 (Fermat numbers factors, others found by ECM)
+        const char *const table[] = {
+            "59649589127497217", "5704689200685129054721", // 2^128 + 1
+            "1238926361552897", // 2^256 + 1
+            "93461639715357977769163558199606896584051237541638188580280321",
+            "2424833", "7455602825647884208337395736200454918783366342657", // 2^512 + 1
+            "741640062627530801524787141901937474059940781097519023905821316144415759504705008092818711693940737",
+            "32032215596496435569", "5439042183600204290159", // 2^137 - 1
+            "5625767248687", "123876132205208335762278423601", // 2^139 - 1
+            "86656268566282183151", "8235109336690846723986161", // 2^149 - 1
+            "6740339310641", "3340762283952395329506327023033", // 2^169 - 1
+            "70084436712553223", "155285743288572277679887", // 2^173 - 1
+            "1587855697992791", "7248808599285760001152755641", // 2^185 - 1
+            "61654440233248340616559", "14732265321145317331353282383", // 2^193 - 1
+            "94803416684681", "1512348937147247", "5346950541323960232319657", // 2^209 - 1
+            "60272956433838849161", "3593875704495823757388199894268773153439", // 2^211 - 1
+            "2849881972114740679", "4205268574191396793", // 2^213 - 1
+            "6268703933840364033151", "378428804431424484082633", // 2^217 - 1
+            "671165898617413417", "4815314615204347717321", // 2^219 - 1
+            "1469495262398780123809", "596242599987116128415063", // 2^223 - 1
+            "26986333437777017", // 2^227 - 1
+            "7992177738205979626491506950867720953545660121688631",
+            "59833457464970183", "467795120187583723534280000348743236593", // 2^229 - 1
+            "23728823512345609279", "31357373417090093431", // 2^237 - 1
+            "16753783618801", "192971705688577", "3712990163251158343", // 2^243 - 1
+            "6459570124697", "402004106269663", "1282816117617265060453496956212169", // 2^247 - 1
+            "178230287214063289511", "61676882198695257501367", // 2^251 - 1
+            "12070396178249893039969681",
+            "199957736328435366769577", "44667711762797798403039426178361", // 2^253 - 1
+            "2663568851051", "862970652262943171", // 3^85 - 1
+            "1611479891519807", "5042939439565996049162197", // 3^89 - 1
+            "44626806191326911791", "397881837642577477902049", // 3^119 - 1
+        };
+        for (const auto *p : table) {
+            m_primes.push_back(biguint::parse(p));
+        }
+    }
+
+public:
+    [[nodiscard]]
+    static
+    auto instance() -> known_primes & {
+        static known_primes res;
+        return res;
+    }
+
+    /**
+     * Registers prime, throws std::invalid_argument if it isn't one.
+     */
+    void add(biguint p) {
+        if (!is_prime(p)) {
+            throw std::invalid_argument("registered divisor is not prime: " + p.to_string());
+        }
+        const std::lock_guard<std::mutex> lock(m_mutex);
+        if (std::find(m_primes.begin(), m_primes.end(), p) == m_primes.end()) {
+            m_primes.push_back(std::move(p));
+        }
+    }
+
+    /**
+     * Returns registered primes dividing n.
+     */
+    [[nodiscard]]
+    auto divisors(const biguint &n) -> std::vector<biguint> {
+        const std::lock_guard<std::mutex> lock(m_mutex);
+        std::vector<biguint> res;
+        for (const auto &p : m_primes) {
+            if (p <= n && (n % p).is_zero()) {
+                res.push_back(p);
+            }
+        }
+        return res;
+    }
+};
+
+/**
+ * Returns sorted list of distinct prime divisors of n. Small divisors are found
+ * by trial division, then known primes are taken out, others are found with
+ * Pollard's rho.
+ */
+[[nodiscard]]
+inline
+auto prime_divisors(biguint n) -> std::vector<biguint> {
+    std::vector<biguint> list;
+    for (uint32_t d = 2; d < (1U << 16U) && n > 1; d += (d == 2) ? 1 : 2) {
+        biguint tmp(n);
+        if (tmp.divmod(d) != 0) {
+            continue;
+        }
+        list.emplace_back(d);
+        do {
+            n = tmp;
+        } while (tmp.divmod(d) == 0);
+    }
+    if (n > 1) {
+        for (auto &p : known_primes::instance().divisors(n)) {
+            do {
+                n /= p;
+            } while ((n % p).is_zero());
+            list.push_back(std::move(p));
+        }
+    }
+    std::vector<biguint> stack;
+    if (n > 1) {
+        stack.push_back(std::move(n));
+    }
+    while (!stack.empty()) {
+        throw_if_stopped();
+        auto m = std::move(stack.back());
+        stack.pop_back();
+        if (is_prime(m)) {
+            list.push_back(std::move(m));
+            continue;
+        }
+        auto d = pollard_brent(m);
+        stack.push_back(m / d);
+        stack.push_back(std::move(d));
+    }
+    std::sort(list.begin(), list.end());
+    list.erase(std::unique(list.begin(), list.end()), list.end());
+    return list;
+}
+
+} // namespace irrpoly::detail
@@ -0,0 +1,160 @@
+/**
+ * @file    executor.hpp
+ * @author  Vadim Piven <vadim@piven.tech>
+ * @license Free use of this library is permitted under the
+ * guidelines and in accordance with the MIT License (MIT).
+ * @url     https://github.com/irreducible-polynoms/irrpoly
+ */
+
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+#include <algorithm>
+#include <cstdint>
+
+namespace irrpoly {
+
+namespace detail {
+
+/**
+ * Tests of smaller degree are never split between threads,
+ * for them a step of the test is faster than waking the threads up.
+ */
+inline uintmax_t parallel_threshold = 1024;
+
+} // namespace detail
+
+/**
+ * executor is a fixed team of threads for data parallel loops inside a single test,
+ * unlike pipeline which parallelizes across candidates. Calling thread takes part in
+ * every loop, so executor of one thread has no workers and runs loops inline.
+ * Workers are started once and sleep between loops. Loops are not reentrant:
+ * executor must be used by one caller at a time.
+ */
+class executor final {
+private:
+    std::vector<std::thread> m_workers;
+    std::mutex m_mutex;
+    std::condition_variable m_wake; ///< notifies workers about new loop or stop
+    std::condition_variable m_done; ///< notifies caller that workers have finished
+    const std::function<void(unsigned)> *m_job; ///< current loop part, called with part index
+    uintmax_t m_round; ///< number of loops started
+    unsigned m_busy; ///< workers which haven't finished current loop
+    bool m_stop;
+    std::exception_ptr m_error;
+
+    void work(const unsigned index) {
+        uintmax_t seen = 0;
+        for (;;) {
+            std::unique_lock<std::mutex> lk(m_mutex);
+            m_wake.wait(lk, [&]() { return m_stop || m_round != seen; });
+            if (m_stop) {
+                return;
+            }
+            seen = m_round;
+            const auto *job = m_job;
+            lk.unlock();
+            try {
+                (*job)(index);
+            } catch (...) {
+                lk.lock();
+                if (!m_error) {
+                    m_error = std::current_exception();
+                }
+                lk.unlock();
+            }
+            lk.lock();
+            if (--m_busy == 0) {
+                m_done.notify_one();
+            }
+        }
+    }
+
+public:
+    /**
+     * Creates executor with given thread budget, including the calling thread.
+     */
+    explicit
+    executor(const unsigned threads = std::thread::hardware_concurrency()) :
+        m_workers(), m_mutex(), m_wake(), m_done(), m_job(nullptr),
+        m_round(0), m_busy(0), m_stop(false), m_error() {
+        for (unsigned i = 1; i < std::max(1U, threads); ++i) {
+            m_workers.emplace_back(&executor::work, this, i);
+        }
+    }
+
+    executor(const executor &) = delete;
+
+    auto operator=(const executor &) -> executor & = delete;
+
+    ~executor() {
+        {
+            std::lock_guard<std::mutex> lg(m_mutex);
+            m_stop = true;
+        }
+        m_wake.notify_all();
+        for (auto &t : m_workers) {
+            t.join();
+        }
+    }
+
+    /**
+     * Returns thread budget including the calling thread.
+     */
+    [[nodiscard]]
+    auto threads() const -> unsigned {
+        return static_cast<unsigned>(m_workers.size()) + 1;
+    }
+
+    /**
+     * Splits [0, count) into threads() contiguous parts and calls fn(begin, end)
+     * for every non-empty part concurrently, the first part is processed by
+     * the calling thread. Returns when all parts are done, rethrows the first
+     * exception thrown by fn.
+     */
+    template<typename Fn>
+    void parallel_for(const uintmax_t count, const Fn &fn) {
+        const uintmax_t parts = threads();
+        if (parts == 1 || count < 2) {
+            fn(uintmax_t(0), count);
+            return;
+        }
+        const std::function<void(unsigned)> job = [&](const unsigned part) {
+            const auto begin = count * part / parts, end = count * (part + 1) / parts;
+            if (begin < end) {
+                fn(begin, end);
+            }
+        };
+        {
+            std::lock_guard<std::mutex> lg(m_mutex);
+            m_job = &job;
+            m_busy = static_cast<unsigned>(m_workers.size());
+            m_error = nullptr;
+            ++m_round;
+        }
+        m_wake.notify_all();
+        std::exception_ptr error;
+        try {
+            job(0);
+        } catch (...) {
+            error = std::current_exception();
+        }
+        std::unique_lock<std::mutex> lk(m_mutex);
+        m_done.wait(lk, [this]() { return m_busy == 0; });
+        if (!error) {
+            error = m_error;
+        }
+        m_job = nullptr;
+        lk.unlock();
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+};
+
+} // namespace irrpoly
@@ -14,6 +14,7 @@
 #include <utility>
 #include <vector>
 #include <cstdint>
+#include <cstddef>
 #include <ostream>
 #include <random>
 #include <stdexcept>
@@ -39,72 +40,584 @@ namespace irrpoly {
 #define CHECK_FIELD(comparison)
 #endif
 
+/**
+ * Default random number generator of the library.
+ */
+#ifdef __LP64__
+using random_engine = std::mt19937_64;
+#else
+using random_engine = std::mt19937;
+#endif
+
+namespace detail {
+
+/**
+ * Calculates multiplicative inverse of val modulo base using extended Euclid's algorithm.
+ * Throws if val and base are not coprime.
+ */
+[[nodiscard]]
+inline
+auto inv_calc(const intmax_t base, const intmax_t val) -> uintmax_t {
+    intmax_t u0 = base, u1 = 1, u2 = 0,
+        v0 = val, v1 = 0, v2 = 1, w0 = 0, w1 = 0, w2 = 0, q = 0;
+    while (v0 > 0) {
+        q = u0 / v0;
+        w0 = u0 - q * v0, w1 = u1 - q * v1, w2 = u2 - q * v2;
+        u0 = v0, u1 = v1, u2 = v2, v0 = w0, v1 = w1, v2 = w2;
+    }
+    if (u0 > 1) {
+        throw std::logic_error("multiplicative inverse don't exist");
+    }
+    return static_cast<uintmax_t>(u2 < 0 ? (base + u2) : (u2));
+}
+
+/**
+ * Checks if val is prime using trial division. Intended for compile-time checks.
+ */
+[[nodiscard]]
+constexpr
+auto is_prime(const uintmax_t val) -> bool {
+    if (val < 2) {
+        return false;
+    }
+    for (uintmax_t d = 2; d * d <= val; ++d) {
+        if (val % d == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Returns higher 64-bit word of the 128-bit product a * b.
+ */
+[[nodiscard]]
+inline
+auto mulhi(const uint64_t a, const uint64_t b) -> uint64_t {
+#ifdef __SIZEOF_INT128__
+    return static_cast<uint64_t>((static_cast<unsigned __int128>(a) * b) >> 64U);
+#else
+    const uint64_t a_lo = a & UINT32_MAX, a_hi = a >> 32U;
+    const uint64_t b_lo = b & UINT32_MAX, b_hi = b >> 32U;
+    const uint64_t lo_lo = a_lo * b_lo, hi_lo = a_hi * b_lo;
+    const uint64_t lo_hi = a_lo * b_hi, hi_hi = a_hi * b_hi;
+    const uint64_t cross = (lo_lo >> 32U) + (hi_lo & UINT32_MAX) + lo_hi;
+    return hi_hi + (hi_lo >> 32U) + (cross >> 32U);
+#endif
+}
+
+/**
+ * Returns the number of leading zero bits of non-zero val.
+ */
+[[nodiscard]]
+inline
+auto leading_zeros(uint64_t val) -> unsigned {
+    unsigned res = 0;
+    for (; !(val >> 63U); val <<= 1U) {
+        ++res;
+    }
+    return res;
+}
+
+#ifdef __SIZEOF_INT128__
+
+/**
+ * Returns (hi * 2^64 + lo) % d for d with the highest bit set and hi < d.
+ * v = floor((2^128 - 1) / d) - 2^64 is precomputed reciprocal of d, so the
+ * remainder takes two multiplications instead of 128-bit division, see
+ * "Improved division by invariant integers" by Moller and Granlund.
+ */
+[[nodiscard]]
+inline
+auto mod_2by1(const uint64_t hi, const uint64_t lo, const uint64_t d, const uint64_t v) -> uint64_t {
+    const auto q = static_cast<unsigned __int128>(v) * hi +
+        ((static_cast<unsigned __int128>(hi + 1) << 64U) | lo);
+    uint64_t r = lo - static_cast<uint64_t>(q >> 64U) * d;
+    if (r > static_cast<uint64_t>(q)) {
+        r += d;
+    }
+    if (r >= d) {
+        r -= d;
+    }
+    return r;
+}
+
+#endif
+
+/**
+ * Calculates (a * b) % mod for any a, b and mod.
+ */
+[[nodiscard]]
+inline
+auto mul_mod(const uintmax_t a, const uintmax_t b, const uintmax_t mod) -> uintmax_t {
+#ifdef __SIZEOF_INT128__
+    return static_cast<uintmax_t>(static_cast<unsigned __int128>(a) * b % mod);
+#else
+    uintmax_t res = 0, x = a % mod, y = b;
+    while (y) {
+        if (y & 1U) {
+            res = (res >= mod - x) ? (res - (mod - x)) : (res + x);
+        }
+        x = (x >= mod - x) ? (x - (mod - x)) : (x + x);
+        y >>= 1U;
+    }
+    return res;
+#endif
+}
+
+/**
+ * Checks if val is prime using deterministic Miller-Rabin test,
+ * the set of witnesses is sufficient for all 64-bit numbers.
+ */
+[[nodiscard]]
+inline
+auto is_prime_miller_rabin(const uintmax_t val) -> bool {
+    if (val < 2) {
+        return false;
+    }
+    for (uintmax_t p : {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37}) {
+        if (val % p == 0) {
+            return val == p;
+        }
+    }
+    uintmax_t d = val - 1, s = 0;
+    while (!(d & 1U)) {
+        d >>= 1U, ++s;
+    }
+    for (uintmax_t a : {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37}) {
+        uintmax_t x = 1, b = a, e = d;
+        for (; e; e >>= 1U, b = mul_mod(b, b, val)) {
+            if (e & 1U) {
+                x = mul_mod(x, b, val);
+            }
+        }
+        if (x == 1 || x == val - 1) {
+            continue;
+        }
+        bool composite = true;
+        for (uintmax_t r = 1; r < s && composite; ++r) {
+            x = mul_mod(x, x, val);
+            composite = (x != val - 1);
+        }
+        if (composite) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * SplitMix64 generator, satisfies UniformRandomBitGenerator. State is a single
+ * 64-bit counter and every output is a bijective mix of it, so independent
+ * streams for any (seed, index) pair are created for free. Unlike standard engines
+ * and distributions its output is the same for every platform and standard library.
+ */
+class splitmix64 final {
+private:
+    uint64_t m_state;
+
+public:
+    using result_type = uint64_t;
+
+    explicit constexpr
+    splitmix64(const uint64_t seed) : m_state(seed) {}
+
+    /**
+     * Creates stream number index of the sequence seeded by seed.
+     */
+    constexpr
+    splitmix64(const uint64_t seed, const uint64_t index) :
+        m_state(splitmix64(seed ^ splitmix64(index)())()) {}
+
+    [[nodiscard]]
+    static constexpr
+    auto min() -> result_type {
+        return 0;
+    }
+
+    [[nodiscard]]
+    static constexpr
+    auto max() -> result_type {
+        return UINT64_MAX;
+    }
+
+    constexpr
+    auto operator()() -> result_type {
+        uint64_t z = (m_state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30U)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27U)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31U);
+    }
+};
+
+/**
+ * Returns uniformly distributed number from range [0, bound-1] using Lemire's
+ * multiply-shift method with rejection. Result depends only on generator output,
+ * which is not guaranteed by std::uniform_int_distribution.
+ */
+[[nodiscard]]
+inline
+auto random_below(splitmix64 &gen, const uint64_t bound) -> uint64_t {
+    uint64_t x = gen(), lo = x * bound;
+    if (lo < bound) {
+        const uint64_t threshold = (0 - bound) % bound;
+        while (lo < threshold) {
+            x = gen(), lo = x * bound;
+        }
+    }
+    return mulhi(x, bound);
+}
+
+/**
+ * Returns generator of the calling thread, seeded from std::random_device on first use.
+ * Used by random functions called without generator, so they are safe to call concurrently.
+ */
+[[nodiscard]]
+inline
+auto thread_engine() -> random_engine & {
+    static thread_local random_engine gen(std::random_device{}());
+    return gen;
+}
+
+} // namespace detail
+
 class gfbase;
 
+/**
+ * Strategies of multiplicative inverse calculation in gf.
+ */
+enum class gf_inverse {
+    table, ///< all inverses are computed during field construction, O(P) memory
+    euclid, ///< inverses are computed on demand by extended Euclid's algorithm, O(1) memory
+    recommended, ///< table for small fields, euclid for large fields
+};
+
 /**
  * gf type represents PRIME Galois field. It is a shared pointer that couldn't
  * contain nullptr value that allows to get rid of null checks at runtime.
  * gf instance could be constructed only then associated Galois field exists.
- * This fact is checked by calculating multiplicative inverse for every elements.
+ * This fact is checked by calculating multiplicative inverse for every elements
+ * in case of table strategy or by Miller-Rabin primality test otherwise.
  * In PRIME field all multiplicative inverse elements must exist. The smallest
- * field you can create is GF[2], the largest is GF[65521] for 32-bit architecture
- * and GF[4294967291] for 64-bit architecture. gfn instance must always be passed
+ * field you can create is GF[2], the largest is GF[4294967291] or GF[9223372036854775783]
+ * if compiler supports 128-bit integers. gfn instance must always be passed
  * by reference and copied at the very last moment.
- * TODO: add support for COMPOSITE fields P^N.
+ * All modulo operations are performed with Barrett reduction, its constant is
+ * precomputed once during field construction (products of wide fields are
+ * reduced with 128-bit reciprocal, see detail::mod_2by1).
+ * Fields of P^k elements are represented by gfext.
  */
 using gf = dropbox::oxygen::nn_shared_ptr<gfbase>;
 
 class gfbase final {
 private:
     const uintmax_t m_base; ///< field base, always could be converted to intmax_t
-    std::vector<uintmax_t> m_inv; ///< multiplicative inverses for all elements
+    const uintmax_t m_barrett; ///< floor((2^64 - 1) / base), Barrett reduction constant
+    const bool m_wide; ///< set to true when product of two elements doesn't fit 64 bits
+    const unsigned m_shift; ///< shift which sets the highest bit of base, used for wide products
+    const uintmax_t m_recip; ///< floor((2^128 - 1) / (base << m_shift)) - 2^64, zero if not wide
+    std::vector<uintmax_t> m_inv; ///< multiplicative inverses for all elements, empty if on demand
 
-    explicit
-    gfbase(uintmax_t /*base*/);
+    gfbase(uintmax_t /*base*/, gf_inverse /*inv*/);
 
-    friend auto make_gf(uintmax_t /*base*/) -> gf;
+    friend auto make_gf(uintmax_t /*base*/, gf_inverse /*inv*/) -> gf;
 
 public:
+    /**
+     * Fields with base up to this value use inverse table for recommended strategy.
+     */
+    static constexpr uintmax_t inverse_table_limit = UINT16_MAX + 1U;
+
     [[nodiscard]]
     auto base() const -> uintmax_t;
 
+    /**
+     * Returns field characteristic, for PRIME field it's equal to base().
+     * Residues are integers modulo base() only when they are equal, see gfext.
+     */
+    [[nodiscard]]
+    auto characteristic() const -> uintmax_t;
+
     /**
      * Returns multiplicative inverse for given number.
      */
     [[nodiscard]]
     auto mul_inv(uintmax_t /*val*/) const -> uintmax_t;
+
+    /**
+     * Returns val % base() without hardware division.
+     */
+    [[nodiscard]]
+    auto reduce(uintmax_t /*val*/) const -> uintmax_t;
+
+    /**
+     * UNSAFE! Requires lb and rb to lay between 0 and base().
+     * Returned number also lays between 0 and base().
+     */
+    [[nodiscard]]
+    auto add(uintmax_t /*lb*/, uintmax_t /*rb*/) const -> uintmax_t;
+
+    /**
+     * UNSAFE! Requires lb and rb to lay between 0 and base().
+     * Returned number also lays between 0 and base().
+     */
+    [[nodiscard]]
+    auto sub(uintmax_t /*lb*/, uintmax_t /*rb*/) const -> uintmax_t;
+
+    /**
+     * UNSAFE! Requires rb to lay between 0 and base().
+     * Returned number also lays between 0 and base().
+     */
+    [[nodiscard]]
+    auto neg(uintmax_t /*rb*/) const -> uintmax_t;
+
+    /**
+     * UNSAFE! Requires lb and rb to lay between 0 and base().
+     * Returned number also lays between 0 and base().
+     */
+    [[nodiscard]]
+    auto mul(uintmax_t /*lb*/, uintmax_t /*rb*/) const -> uintmax_t;
 };
 
+inline
 auto operator==(const gf &lb, const gf &rb) -> bool {
     return lb->base() == rb->base();
 }
 
+inline
 auto operator!=(const gf &lb, const gf &rb) -> bool {
     return lb->base() != rb->base();
 }
 
 /**
- * gfn type represents number in GF[P]. The number is always within 0 and P-1.
+ * gf_view is a non-owning handle of gf with the same pointer-like access.
+ * Copying gf changes shared reference counter with atomic operation, which is
+ * costly in hot loops and causes cache line contention between threads sharing
+ * the field. gf_view is a raw pointer, so it could be used as Field of elements
+ * (gfn_view) and polynomials in such places. Field must outlive all its views.
  */
-class gfn final {
+class gf_view final {
 private:
-    gf m_field;
+    const gfbase *m_ptr;
+
+public:
+    gf_view(const gf &field) : m_ptr(&*field) {} // NOLINT(google-explicit-constructor)
+
+    auto operator->() const -> const gfbase * {
+        return m_ptr;
+    }
+
+    auto operator*() const -> const gfbase & {
+        return *m_ptr;
+    }
+
+    friend
+    auto operator==(const gf_view lb, const gf_view rb) -> bool {
+        return lb.m_ptr == rb.m_ptr || lb->base() == rb->base();
+    }
+
+    friend
+    auto operator!=(const gf_view lb, const gf_view rb) -> bool {
+        return !(lb == rb);
+    }
+
+    /// gf_view is never uninitialised
+    friend
+    auto operator==(const gf_view /*lb*/, std::nullptr_t /*rb*/) -> bool {
+        return false;
+    }
+};
+
+/**
+ * gf_static type represents PRIME Galois field with base known at compile time.
+ * It is an empty type and could be used everywhere instead of gf, so that
+ * the compiler could fold all modulo operations by constant base.
+ * For compatibility with gf it provides pointer-like access (field->base()).
+ * The largest field you can create is GF[4294967291].
+ */
+template<uintmax_t P>
+class gf_static final {
+    static_assert(P != 0, "empty field");
+    static_assert(P != 1, "field could contain only zero");
+    static_assert(P <= UINT32_MAX, "too large field");
+    static_assert(detail::is_prime(P), "multiplicative inverse don't exist");
+
+public:
+    constexpr gf_static() = default;
+
+    constexpr auto operator->() const -> const gf_static * {
+        return this;
+    }
+
+    constexpr auto operator*() const -> const gf_static & {
+        return *this;
+    }
+
+    [[nodiscard]]
+    static constexpr
+    auto base() -> uintmax_t {
+        return P;
+    }
+
+    [[nodiscard]]
+    static constexpr
+    auto characteristic() -> uintmax_t {
+        return P;
+    }
+
+    /**
+     * Returns multiplicative inverse for given number.
+     */
+    [[nodiscard]]
+    static
+    auto mul_inv(const uintmax_t val) -> uintmax_t {
+        switch (val % P) {
+        case 0:throw std::logic_error("multiplicative inverse don't exist");
+        default:return detail::inv_calc(static_cast<intmax_t>(P),
+                                        static_cast<intmax_t>(val % P));
+        }
+    }
+
+    /**
+     * Returns val % base(), division by constant is folded by the compiler.
+     */
+    [[nodiscard]]
+    static constexpr
+    auto reduce(const uintmax_t val) -> uintmax_t {
+        return val % P;
+    }
+
+    /**
+     * UNSAFE! Requires lb and rb to lay between 0 and base().
+     * Returned number also lays between 0 and base().
+     */
+    [[nodiscard]]
+    static constexpr
+    auto add(const uintmax_t lb, const uintmax_t rb) -> uintmax_t {
+        return (lb + rb >= P) ? (lb + rb - P) : (lb + rb);
+    }
+
+    /**
+     * UNSAFE! Requires lb and rb to lay between 0 and base().
+     * Returned number also lays between 0 and base().
+     */
+    [[nodiscard]]
+    static constexpr
+    auto sub(const uintmax_t lb, const uintmax_t rb) -> uintmax_t {
+        return (lb >= rb) ? (lb - rb) : (P + lb - rb);
+    }
+
+    /**
+     * UNSAFE! Requires rb to lay between 0 and base().
+     * Returned number also lays between 0 and base().
+     */
+    [[nodiscard]]
+    static constexpr
+    auto neg(const uintmax_t rb) -> uintmax_t {
+        return rb ? (P - rb) : 0;
+    }
+
+    /**
+     * UNSAFE! Requires lb and rb to lay between 0 and base().
+     * Returned number also lays between 0 and base().
+     */
+    [[nodiscard]]
+    static constexpr
+    auto mul(const uintmax_t lb, const uintmax_t rb) -> uintmax_t {
+        return (lb * rb) % P;
+    }
+
+    constexpr friend
+    auto operator==(gf_static /*lb*/, gf_static /*rb*/) -> bool {
+        return true;
+    }
+
+    constexpr friend
+    auto operator!=(gf_static /*lb*/, gf_static /*rb*/) -> bool {
+        return false;
+    }
+
+    /// gf_static is never uninitialised, unlike moved-out gf
+    constexpr friend
+    auto operator==(gf_static /*lb*/, std::nullptr_t /*rb*/) -> bool {
+        return false;
+    }
+};
+
+/**
+ * Creates Galois field with base known at compile time.
+ */
+template<uintmax_t P>
+[[nodiscard]]
+constexpr
+auto make_gf() -> gf_static<P> {
+    return gf_static<P>{};
+}
+
+/**
+ * Returns non-owning handle of the field, see gf_view.
+ */
+[[nodiscard]]
+inline
+auto field_view(const gf &field) -> gf_view {
+    return gf_view(field);
+}
+
+[[nodiscard]]
+inline
+auto field_view(const gf_view field) -> gf_view {
+    return field;
+}
+
+/**
+ * gf_static is an empty type, it is a view of itself.
+ */
+template<uintmax_t P>
+[[nodiscard]]
+constexpr
+auto field_view(const gf_static<P> field) -> gf_static<P> {
+    return field;
+}
+
+/**
+ * Type of non-owning field handle: gf_view for gf, gf_static<P> for itself.
+ */
+template<typename Field>
+using field_view_t = decltype(field_view(std::declval<Field>()));
+
+/**
+ * basic_gfn type represents number in GF[P]. The number is always within 0 and P-1.
+ * Field type could be either gf (field base is known at runtime) or
+ * gf_static<P> (field base is known at compile time).
+ */
+template<typename Field>
+class basic_gfn final {
+private:
+    Field m_field;
     uintmax_t m_val;
 
+    struct reduced_t {}; ///< marks that value is already within 0 and P-1
+
+    basic_gfn(const Field &field, const uintmax_t val, reduced_t /*unused*/) :
+        m_field(field), m_val(val) {}
+
 public:
     /**
-     * Generates a random number from  range [0, P-1].
+     * Generates a random number from range [0, P-1] using provided generator.
      */
+    template<typename Gen>
     static
-    auto random(const gf &field) -> gfn {
-        static std::random_device rd;
-#ifdef __LP64__
-        static std::mt19937_64 gen(rd());
-#else
-        static std::mt19937 gen(rd());
-#endif
-        std::uniform_int_distribution<uint_fast64_t> dis(0, field->base() - 1);
-        return gfn(field, dis(gen));
+    auto random(const Field &field, Gen &gen) -> basic_gfn {
+        std::uniform_int_distribution<uintmax_t> dis(0, field->base() - 1);
+        return basic_gfn(field, dis(gen));
+    }
+
+    /**
+     * Generates a random number from range [0, P-1] using generator of the calling thread.
+     */
+    static
+    auto random(const Field &field) -> basic_gfn {
+        return random(field, detail::thread_engine());
     }
 
     [[nodiscard]]
@@ -113,16 +626,16 @@ public:
     }
 
     explicit
-    gfn(const gf &field) : m_field(field), m_val(0) {}
+    basic_gfn(const Field &field) : m_field(field), m_val(0) {}
 
-    gfn(const gf &field, const uintmax_t val) :
-        m_field(field), m_val(val % m_field->base()) {}
+    basic_gfn(const Field &field, const uintmax_t val) :
+        m_field(field), m_val(m_field->reduce(val)) {}
 
-    gfn(const gfn &other) = default;
+    basic_gfn(const basic_gfn &other) = default;
 
-    gfn(gfn &&other) = default;
+    basic_gfn(basic_gfn &&other) = default;
 
-    auto operator=(const gfn &other) -> gfn & {
+    auto operator=(const basic_gfn &other) -> basic_gfn & {
         if (this != &other) {
             // m_field == nullptr means that gfn instance is uninitialised
             // this happens during std::move, std::swap and inside some std::vector methods
@@ -138,124 +651,136 @@ public:
         return m_field->base();
     }
 
-    auto operator=(const uintmax_t other) -> gfn & {
-        m_val = other % base();
+    auto operator=(const uintmax_t other) -> basic_gfn & {
+        m_val = m_field->reduce(other);
         return *this;
     }
 
     [[nodiscard]]
-    auto field() const -> const gf & {
+    auto field() const -> const Field & {
         return m_field;
     }
 
     [[nodiscard]]
-    auto operator+() const -> gfn {
-        return gfn{*this};
+    auto operator+() const -> basic_gfn {
+        return basic_gfn{*this};
     }
 
     [[nodiscard]]
-    auto operator+(const gfn &other) const -> gfn {
+    auto operator+(const basic_gfn &other) const -> basic_gfn {
         CHECK_FIELD(m_field == other.field())
-        return gfn{m_field, m_val + other.m_val};
+        return basic_gfn{m_field, m_field->add(m_val, other.m_val), reduced_t{}};
     }
 
     [[nodiscard]]
-    auto operator+(const uintmax_t other) const -> gfn {
-        return gfn{m_field, m_val + (other % base())};
+    auto operator+(const uintmax_t other) const -> basic_gfn {
+        return basic_gfn{m_field, m_field->add(m_val, m_field->reduce(other)), reduced_t{}};
     }
 
+    [[nodiscard]]
     friend
-    auto operator+(uintmax_t /*other*/, const gfn & /*curr*/) -> gfn;
+    auto operator+(const uintmax_t other, const basic_gfn &curr) -> basic_gfn {
+        return basic_gfn{curr.m_field,
+                         curr.m_field->add(curr.m_field->reduce(other), curr.m_val), reduced_t{}};
+    }
 
-    auto operator+=(const gfn &other) -> gfn & {
+    auto operator+=(const basic_gfn &other) -> basic_gfn & {
         CHECK_FIELD(m_field == other.field())
-        m_val = (m_val + other.m_val) % base();
+        m_val = m_field->add(m_val, other.m_val);
         return *this;
     }
 
-    auto operator+=(const uintmax_t other) -> gfn {
-        m_val = (m_val + (other % base())) % base();
+    auto operator+=(const uintmax_t other) -> basic_gfn {
+        m_val = m_field->add(m_val, m_field->reduce(other));
         return *this;
     }
 
-    auto operator++() -> gfn & {
-        m_val = (m_val + 1) % base();
+    auto operator++() -> basic_gfn & {
+        m_val = m_field->add(m_val, 1);
         return *this;
     }
 
     [[nodiscard]]
-    auto operator++(int) & -> gfn {
-        gfn tmp{*this};
-        m_val = (m_val + 1) % base();
+    auto operator++(int) & -> basic_gfn {
+        basic_gfn tmp{*this};
+        m_val = m_field->add(m_val, 1);
         return tmp;
     }
 
     [[nodiscard]]
-    auto operator-() const -> gfn {
-        gfn tmp{*this};
-        tmp.m_val = (base() - m_val) % base();
+    auto operator-() const -> basic_gfn {
+        basic_gfn tmp{*this};
+        tmp.m_val = m_field->neg(m_val);
         return tmp;
     }
 
     [[nodiscard]]
-    auto operator-(const gfn &other) const -> gfn {
+    auto operator-(const basic_gfn &other) const -> basic_gfn {
         CHECK_FIELD(m_field == other.field())
-        return gfn{m_field, base() + m_val - other.m_val};
+        return basic_gfn{m_field, m_field->sub(m_val, other.m_val), reduced_t{}};
     }
 
     [[nodiscard]]
-    auto operator-(const uintmax_t other) const -> gfn {
-        return gfn{m_field, base() + m_val - (other % base())};
+    auto operator-(const uintmax_t other) const -> basic_gfn {
+        return basic_gfn{m_field, m_field->sub(m_val, m_field->reduce(other)), reduced_t{}};
     }
 
+    [[nodiscard]]
     friend
-    auto operator-(uintmax_t /*other*/, const gfn & /*curr*/) -> gfn;
+    auto operator-(const uintmax_t other, const basic_gfn &curr) -> basic_gfn {
+        return basic_gfn{curr.m_field,
+                         curr.m_field->sub(curr.m_field->reduce(other), curr.m_val), reduced_t{}};
+    }
 
-    auto operator-=(const gfn &other) -> gfn & {
+    auto operator-=(const basic_gfn &other) -> basic_gfn & {
         CHECK_FIELD(m_field == other.field())
-        m_val = (base() + m_val - other.m_val) % base();
+        m_val = m_field->sub(m_val, other.m_val);
         return *this;
     }
 
-    auto operator-=(const uintmax_t other) -> gfn {
-        m_val = (base() + m_val - (other % base())) % base();
+    auto operator-=(const uintmax_t other) -> basic_gfn {
+        m_val = m_field->sub(m_val, m_field->reduce(other));
         return *this;
     }
 
-    auto operator--() -> gfn & {
-        m_val = (base() + m_val - 1) % base();
+    auto operator--() -> basic_gfn & {
+        m_val = m_field->sub(m_val, 1);
         return *this;
     }
 
     [[nodiscard]]
-    auto operator--(int) & -> gfn {
-        gfn tmp{*this};
-        m_val = (base() + m_val - 1) % base();
+    auto operator--(int) & -> basic_gfn {
+        basic_gfn tmp{*this};
+        m_val = m_field->sub(m_val, 1);
         return tmp;
     }
 
     [[nodiscard]]
-    auto operator*(const gfn &other) const -> gfn {
+    auto operator*(const basic_gfn &other) const -> basic_gfn {
         CHECK_FIELD(m_field == other.field())
-        return gfn{m_field, m_val * other.m_val};
+        return basic_gfn{m_field, m_field->mul(m_val, other.m_val), reduced_t{}};
     }
 
     [[nodiscard]]
-    auto operator*(const uintmax_t other) const -> gfn {
-        return gfn{m_field, m_val * (other % base())};
+    auto operator*(const uintmax_t other) const -> basic_gfn {
+        return basic_gfn{m_field, m_field->mul(m_val, m_field->reduce(other)), reduced_t{}};
     }
 
+    [[nodiscard]]
     friend
-    auto operator*(uintmax_t /*other*/, const gfn & /*curr*/) -> gfn;
+    auto operator*(const uintmax_t other, const basic_gfn &curr) -> basic_gfn {
+        return basic_gfn{curr.m_field,
+                         curr.m_field->mul(curr.m_field->reduce(other), curr.m_val), reduced_t{}};
+    }
 
-    auto operator*=(const gfn &other) -> gfn & {
+    auto operator*=(const basic_gfn &other) -> basic_gfn & {
         CHECK_FIELD(m_field == other.field())
-        m_val = (m_val * other.m_val) % base();
+        m_val = m_field->mul(m_val, other.m_val);
         return *this;
     }
 
-    auto operator*=(const uintmax_t other) -> gfn {
-        m_val = (m_val * (other % base())) % base();
+    auto operator*=(const uintmax_t other) -> basic_gfn {
+        m_val = m_field->mul(m_val, m_field->reduce(other));
         return *this;
     }
 
@@ -263,48 +788,59 @@ public:
      * Returns multiplicative inverse for current gfn instance.
      */
     [[maybe_unused]] [[nodiscard]]
-    auto mul_inv() -> gfn {
-        return gfn{m_field, m_field->mul_inv(m_val)};
+    auto mul_inv() -> basic_gfn {
+        return basic_gfn{m_field, m_field->mul_inv(m_val), reduced_t{}};
     }
 
     /**
      * Division is defined as multiplication by multiplicative inverse.
      */
     [[nodiscard]]
-    auto operator/(const gfn &other) const -> gfn {
+    auto operator/(const basic_gfn &other) const -> basic_gfn {
         CHECK_FIELD(m_field == other.field())
         switch (other.m_val) {
         case 0:throw std::invalid_argument("division by zero");
-        default:return gfn{m_field, m_val * m_field->mul_inv(other.m_val)};
+        default:return basic_gfn{m_field, m_field->mul(m_val, m_field->mul_inv(other.m_val)),
+                                 reduced_t{}};
         }
     }
 
     [[nodiscard]]
-    auto operator/(const uintmax_t other) const -> gfn {
-        switch (other % base()) {
+    auto operator/(const uintmax_t other) const -> basic_gfn {
+        switch (m_field->reduce(other)) {
         case 0:throw std::invalid_argument("division by zero");
         default:
-            return gfn{m_field,
-                       m_val * m_field->mul_inv(other % base())};
+            return basic_gfn{m_field, m_field->mul(m_val, m_field->mul_inv(other)),
+                             reduced_t{}};
         }
     }
 
+    [[nodiscard]]
     friend
-    auto operator/(uintmax_t /*other*/, const gfn & /*curr*/) -> gfn;
+    auto operator/(const uintmax_t other, const basic_gfn &curr) -> basic_gfn {
+        switch (curr.m_val) {
+        case 0:throw std::invalid_argument("division by zero");
+        default:
+            return basic_gfn{curr.m_field,
+                             curr.m_field->mul(curr.m_field->reduce(other),
+                                               curr.m_field->mul_inv(curr.m_val)),
+                             reduced_t{}};
+        }
+    }
 
-    auto operator/=(const gfn &other) -> gfn & {
+    auto operator/=(const basic_gfn &other) -> basic_gfn & {
         CHECK_FIELD(m_field == other.field())
         switch (other.m_val) {
         case 0:throw std::invalid_argument("division by zero");
-        default:m_val = (m_val * m_field->mul_inv(other.m_val)) % base();
+        default:m_val = m_field->mul(m_val, m_field->mul_inv(other.m_val));
             return *this;
         }
     }
 
-    auto operator/=(const uintmax_t other) -> gfn {
-        switch (other % base()) {
+    auto operator/=(const uintmax_t other) -> basic_gfn {
+        switch (m_field->reduce(other)) {
         case 0:throw std::invalid_argument("division by zero");
-        default:m_val = (m_val * m_field->mul_inv(other % base())) % base();
+        default:m_val = m_field->mul(m_val, m_field->mul_inv(other));
             return *this;
         }
     }
@@ -320,30 +856,51 @@ public:
 
     template<class charT, class traits>
     friend
-    auto operator<<(std::basic_ostream<charT, traits> & /*os*/, const gfn & /*val*/)
-    -> std::basic_ostream<charT, traits> &;
+    auto operator<<(std::basic_ostream<charT, traits> &os, const basic_gfn &val)
+    -> std::basic_ostream<charT, traits> & {
+        return os << val.m_val;
+    }
 
     template<class charT, class traits>
     friend
-    auto operator>>(std::basic_istream<charT, traits> & /*is*/, gfn & /*val*/)
-    -> std::basic_istream<charT, traits> &;
+    auto operator>>(std::basic_istream<charT, traits> &is, basic_gfn &val)
+    -> std::basic_istream<charT, traits> & {
+        is >> val.m_val;
+        val.m_val = val.m_field->reduce(val.m_val);
+        return is;
+    }
 };
 
+/**
+ * gfn type represents number in GF[P] with field base known at runtime.
+ */
+using gfn = basic_gfn<gf>;
+
+/**
+ * gfn_view is a lightweight number in GF[P] with field base known at runtime:
+ * it holds raw residue and gf_view, so it is cheap to copy and store in containers.
+ * Field must outlive all the numbers, use gfn when in doubt.
+ */
+using gfn_view = basic_gfn<gf_view>;
+
 #define GFN_COMPARISON_OPERATORS(op) \
+    template<typename Field> \
     inline \
-    auto operator op(const gfn &l, const gfn &r) -> bool { \
+    auto operator op(const basic_gfn<Field> &l, const basic_gfn<Field> &r) -> bool { \
         CHECK_FIELD(l.field() == r.field()) \
         return l.value() op r.value(); \
     } \
     \
+    template<typename Field> \
     inline \
-    auto operator op(const gfn &l, const uintmax_t r) -> bool { \
-        return l.value() op (r % l.base()); \
+    auto operator op(const basic_gfn<Field> &l, const uintmax_t r) -> bool { \
+        return l.value() op l.field()->reduce(r); \
     } \
     \
+    template<typename Field> \
     inline \
-    auto operator op(const uintmax_t l, const gfn &r) -> bool { \
-        return (l % r.base()) op r.value(); \
+    auto operator op(const uintmax_t l, const basic_gfn<Field> &r) -> bool { \
+        return r.field()->reduce(l) op r.value(); \
     }
 
 GFN_COMPARISON_OPERATORS(==)
@@ -355,78 +912,65 @@ GFN_COMPARISON_OPERATORS(>=)
 
 #undef GFN_COMPARISON_OPERATORS
 
+/**
+ * Returns val^pow by binary exponentiation.
+ */
+template<typename Field>
 [[nodiscard]]
-auto operator+(const uintmax_t other, const gfn &curr) -> gfn {
-    return gfn{curr.m_field, (other % curr.base()) + curr.m_val};
-}
-
-[[nodiscard]]
-auto operator-(const uintmax_t other, const gfn &curr) -> gfn {
-    return gfn{curr.m_field, curr.base() + (other % curr.base()) - curr.m_val};
-}
-
-[[nodiscard]]
-auto operator*(const uintmax_t other, const gfn &curr) -> gfn {
-    return gfn{curr.m_field, (other % curr.base()) * curr.m_val};
-}
-
-[[nodiscard]]
-auto operator/(const uintmax_t other, const gfn &curr) -> gfn {
-    switch (curr.m_val) {
-    case 0:throw std::invalid_argument("division by zero");
-    default:
-        return gfn{curr.m_field,
-                   (other % curr.base()) * curr.m_field->mul_inv(curr.m_val)};
+auto pow(basic_gfn<Field> val, uintmax_t exp) -> basic_gfn<Field> {
+    auto res = basic_gfn<Field>(val.field(), 1);
+    for (; exp; exp >>= 1U, val *= val) {
+        if (exp & 1U) {
+            res *= val;
+        }
     }
-}
-
-template<class charT, class traits>
-auto operator<<(std::basic_ostream<charT, traits> &os, const gfn &val)
--> std::basic_ostream<charT, traits> & {
-    return os << val.m_val;
-}
-
-template<class charT, class traits>
-auto operator>>(std::basic_istream<charT, traits> &is, gfn &val)
--> std::basic_istream<charT, traits> & {
-    is >> val.m_val;
-    val.m_val %= val.base();
-    return is;
+    return res;
 }
 
 inline
-gfbase::gfbase(const uintmax_t base) : m_base(base), m_inv(base, 0) {
+gfbase::gfbase(const uintmax_t base, const gf_inverse inv) :
+    m_base(base), m_barrett(base ? UINTMAX_MAX / base : 0),
+    m_wide(base > 1 && UINTMAX_MAX / (base - 1) < (base - 1)),
+    m_shift(m_wide ? detail::leading_zeros(base) : 0),
+#ifdef __SIZEOF_INT128__
+    m_recip(m_wide ? static_cast<uintmax_t>(~static_cast<unsigned __int128>(0) / (base << m_shift)) : 0),
+#else
+    m_recip(0),
+#endif
+    m_inv() {
     if (base == 0) {
         throw std::logic_error("empty field");
     }
     if (base == 1) {
         throw std::logic_error("field could contain only zero");
     }
-    if (UINTMAX_MAX / (base - 1) < (base - 1)) {
+#ifdef __SIZEOF_INT128__
+    // sum of two elements must fit uintmax_t, wide products use 128-bit integers
+    if (base > static_cast<uintmax_t>(INTMAX_MAX)) {
         throw std::logic_error("too large field");
     }
-
-    auto i_base = static_cast<intmax_t>(base);
-    auto inv_calc = [](const intmax_t base, const intmax_t val) -> uintmax_t {
-        intmax_t u0 = base, u1 = 1, u2 = 0,
-            v0 = val, v1 = 0, v2 = 1, w0 = 0, w1 = 0, w2 = 0, q = 0;
-        while (v0 > 0) {
-            q = u0 / v0;
-            w0 = u0 - q * v0, w1 = u1 - q * v1, w2 = u2 - q * v2;
-            u0 = v0, u1 = v1, u2 = v2, v0 = w0, v1 = w1, v2 = w2;
-        }
-        if (u0 > 1) {
+#else
+    if (m_wide) {
+        throw std::logic_error("too large field");
+    }
+#endif
+    if (inv == gf_inverse::euclid ||
+        (inv == gf_inverse::recommended && base > inverse_table_limit)) {
+        if (!detail::is_prime_miller_rabin(base)) {
             throw std::logic_error("multiplicative inverse don't exist");
         }
-        return static_cast<uintmax_t>(u2 < 0 ? (base + u2) : (u2));
-    };
+        return;
+    }
 
+    m_inv.resize(base, 0);
+
+    auto i_base = static_cast<intmax_t>(base);
     m_inv[1] = 1;
     for (uintmax_t i = 2; i < m_base; ++i) {
         if (m_inv[i]) {
             continue;
         }
-        m_inv[i] = inv_calc(i_base, i);
+        m_inv[i] = detail::inv_calc(i_base, static_cast<intmax_t>(i));
         m_inv[m_inv[i]] = i;
     }
 }
@@ -437,20 +981,76 @@ auto gfbase::base() const -> uintmax_t {
     return m_base;
 }
 
+[[nodiscard]]
+inline
+auto gfbase::characteristic() const -> uintmax_t {
+    return m_base;
+}
+
 [[nodiscard]]
 inline
 auto gfbase::mul_inv(const uintmax_t val) const -> uintmax_t {
-    switch (val % m_base) {
+    switch (reduce(val)) {
     case 0:throw std::logic_error("multiplicative inverse don't exist");
-    default:return m_inv[val % m_base];
+    default:return m_inv.empty() ?
+                   detail::inv_calc(static_cast<intmax_t>(m_base),
+                                    static_cast<intmax_t>(reduce(val))) :
+                   m_inv[reduce(val)];
+    }
+}
+
+[[nodiscard]]
+inline
+auto gfbase::reduce(const uintmax_t val) const -> uintmax_t {
+    // quotient estimation is at most 2 less than real one, see Barrett reduction
+    uintmax_t res = val - detail::mulhi(val, m_barrett) * m_base;
+    while (res >= m_base) {
+        res -= m_base;
     }
+    return res;
 }
 
 [[nodiscard]]
 inline
-auto make_gf(const uintmax_t base) -> gf {
+auto gfbase::add(const uintmax_t lb, const uintmax_t rb) const -> uintmax_t {
+    return (lb + rb >= m_base) ? (lb + rb - m_base) : (lb + rb);
+}
+
+[[nodiscard]]
+inline
+auto gfbase::sub(const uintmax_t lb, const uintmax_t rb) const -> uintmax_t {
+    return (lb >= rb) ? (lb - rb) : (m_base + lb - rb);
+}
+
+[[nodiscard]]
+inline
+auto gfbase::neg(const uintmax_t rb) const -> uintmax_t {
+    return rb ? (m_base - rb) : 0;
+}
+
+[[nodiscard]]
+inline
+auto gfbase::mul(const uintmax_t lb, const uintmax_t rb) const -> uintmax_t {
+#ifdef __SIZEOF_INT128__
+    if (m_wide) {
+        const auto prod = static_cast<unsigned __int128>(lb) * rb << m_shift;
+        return detail::mod_2by1(static_cast<uint64_t>(prod >> 64U), static_cast<uint64_t>(prod),
+                                m_base << m_shift, m_recip) >> m_shift;
+    }
+#endif
+    return reduce(lb * rb);
+}
+
+/**
+ * Creates Galois field with base known at runtime. Strategy of
+ * multiplicative inverse calculation could be selected with inv.
+ */
+[[nodiscard]]
+inline
+auto make_gf(const uintmax_t base,
+             const gf_inverse inv = gf_inverse::recommended) -> gf {
     return dropbox::oxygen::nn<std::shared_ptr<gfbase>>(dropbox::oxygen::nn(
-        dropbox::oxygen::i_promise_i_checked_for_null_t{}, new gfbase(base)));
+        dropbox::oxygen::i_promise_i_checked_for_null_t{}, new gfbase(base, inv)));
 }
 
 #undef CHECK_FIELD
@@ -0,0 +1,578 @@
+/**
+ * @file    gf2poly.hpp
+ * @author  Vadim Piven <vadim@piven.tech>
+ * @license Free use of this library is permitted under the
+ * guidelines and in accordance with the MIT License (MIT).
+ * @url     https://github.com/irreducible-polynoms/irrpoly
+ */
+
+#pragma once
+
+#include "gfpoly.hpp"
+#include "stats.hpp"
+
+#include <vector>
+#include <cstdint>
+#include <initializer_list>
+#include <stdexcept>
+
+#if (defined(__x86_64__) || defined(_M_X64)) && defined(__GNUC__)
+#include <immintrin.h>
+#define IRRPOLY_CLMUL_PCLMUL
+#elif (defined(__ARM_FEATURE_AES) || defined(__ARM_FEATURE_CRYPTO)) && defined(__aarch64__)
+#include <arm_neon.h>
+#define IRRPOLY_CLMUL_PMULL
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#if defined(IRRPOLY_CLMUL_PCLMUL) && !defined(__PCLMUL__)
+#define IRRPOLY_TARGET_PCLMUL __attribute__((target("pclmul")))
+#else
+#define IRRPOLY_TARGET_PCLMUL
+#endif
+
+#if defined(IRRPOLY_CLMUL_PCLMUL) && !defined(__AVX2__)
+#define IRRPOLY_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define IRRPOLY_TARGET_AVX2
+#endif
+
+namespace irrpoly {
+
+namespace detail {
+
+/**
+ * Portable carry-less multiplication of two 64-bit words, returns lower word
+ * of product and stores higher word in hi.
+ */
+inline
+auto clmul_portable(const uint64_t a, const uint64_t b, uint64_t &hi) -> uint64_t {
+    // 4-bit window: table holds products of a by every 4-bit polynomial
+    uint64_t tl[16], th[16];
+    tl[0] = th[0] = 0;
+    for (unsigned i = 1; i < 16; ++i) {
+        tl[i] = (i & 1U) ? a : 0;
+        th[i] = 0;
+        for (unsigned j = 1; j < 4; ++j) {
+            if (i & (1U << j)) {
+                tl[i] ^= a << j;
+                th[i] ^= a >> (64U - j);
+            }
+        }
+    }
+    uint64_t lo = 0;
+    hi = 0;
+    for (unsigned s = 64; s > 0;) {
+        s -= 4;
+        const auto w = static_cast<unsigned>((b >> s) & 0xFU);
+        hi = (hi << 4U) | (lo >> 60U);
+        lo <<= 4U;
+        lo ^= tl[w];
+        hi ^= th[w];
+    }
+    return lo;
+}
+
+#if defined(IRRPOLY_CLMUL_PCLMUL)
+
+/**
+ * Returns true if processor supports PCLMULQDQ, it is always true when
+ * compiled with -mpclmul, otherwise it is asked once with cpuid.
+ */
+inline
+auto has_pclmul() -> bool {
+#if defined(__PCLMUL__)
+    return true;
+#else
+    static const bool res = __builtin_cpu_supports("pclmul");
+    return res;
+#endif
+}
+
+/**
+ * Returns true if processor supports AVX2, see has_pclmul.
+ */
+inline
+auto has_avx2() -> bool {
+#if defined(__AVX2__)
+    return true;
+#else
+    static const bool res = __builtin_cpu_supports("avx2");
+    return res;
+#endif
+}
+
+/**
+ * Carry-less multiplication with PCLMULQDQ, may be called only if has_pclmul.
+ */
+IRRPOLY_TARGET_PCLMUL inline
+auto clmul_pclmul(const uint64_t a, const uint64_t b, uint64_t &hi) -> uint64_t {
+    const __m128i r = _mm_clmulepi64_si128(
+        _mm_cvtsi64_si128(static_cast<long long>(a)),
+        _mm_cvtsi64_si128(static_cast<long long>(b)), 0x00);
+    hi = static_cast<uint64_t>(_mm_cvtsi128_si64(_mm_unpackhi_epi64(r, r)));
+    return static_cast<uint64_t>(_mm_cvtsi128_si64(r));
+}
+
+#endif
+
+/**
+ * Carry-less multiplication of two 64-bit words, returns lower word of product
+ * and stores higher word in hi. Uses PCLMULQDQ on x86 if processor supports it
+ * and PMULL on ARM (compile with +crypto), otherwise portable implementation.
+ */
+inline
+auto clmul(const uint64_t a, const uint64_t b, uint64_t &hi) -> uint64_t {
+#if defined(IRRPOLY_CLMUL_PCLMUL)
+    return has_pclmul() ? clmul_pclmul(a, b, hi) : clmul_portable(a, b, hi);
+#elif defined(IRRPOLY_CLMUL_PMULL)
+    const poly128_t r = vmull_p64(static_cast<poly64_t>(a), static_cast<poly64_t>(b));
+    hi = static_cast<uint64_t>(r >> 64U);
+    return static_cast<uint64_t>(r);
+#else
+    return clmul_portable(a, b, hi);
+#endif
+}
+
+/**
+ * Adds carry-less product of words a[0..na) and b[0..nb) to prod[0..na+nb)
+ * multiplying words with clmul.
+ */
+inline
+void clmul_words_generic(uint64_t *prod, const uint64_t *a, const uintmax_t na,
+                          const uint64_t *b, const uintmax_t nb) {
+    uint64_t hi = 0;
+    for (uintmax_t i = 0; i < na; ++i) {
+        for (uintmax_t j = 0; j < nb; ++j) {
+            prod[i + j] ^= clmul(a[i], b[j], hi);
+            prod[i + j + 1] ^= hi;
+        }
+    }
+}
+
+#if defined(IRRPOLY_CLMUL_PCLMUL)
+
+/**
+ * Same as clmul_words_generic with PCLMULQDQ, may be called only if has_pclmul.
+ */
+IRRPOLY_TARGET_PCLMUL inline
+void clmul_words_pclmul(uint64_t *prod, const uint64_t *a, const uintmax_t na,
+                        const uint64_t *b, const uintmax_t nb) {
+    uint64_t hi = 0;
+    for (uintmax_t i = 0; i < na; ++i) {
+        for (uintmax_t j = 0; j < nb; ++j) {
+            prod[i + j] ^= clmul_pclmul(a[i], b[j], hi);
+            prod[i + j + 1] ^= hi;
+        }
+    }
+}
+
+#endif
+
+/**
+ * Adds carry-less product of words a[0..na) and b[0..nb) to prod[0..na+nb),
+ * kernel is selected once per call, so inner loop is free of dispatch.
+ */
+inline
+void clmul_words(uint64_t *prod, const uint64_t *a, const uintmax_t na,
+                 const uint64_t *b, const uintmax_t nb) {
+#if defined(IRRPOLY_CLMUL_PCLMUL)
+    if (has_pclmul()) {
+        clmul_words_pclmul(prod, a, na, b, nb);
+        return;
+    }
+#endif
+    clmul_words_generic(prod, a, na, b, nb);
+}
+
+#if defined(IRRPOLY_CLMUL_PCLMUL)
+
+/**
+ * Row addition with AVX2, may be called only if has_avx2.
+ */
+IRRPOLY_TARGET_AVX2 inline
+void xor_row_avx2(uint64_t *dst, const uint64_t *src, const uintmax_t len) {
+    uintmax_t i = 0;
+    for (; i + 4 <= len; i += 4) {
+        const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(dst + i));
+        const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm256_xor_si256(a, b));
+    }
+    for (; i < len; ++i) {
+        dst[i] ^= src[i];
+    }
+}
+
+#endif
+
+/**
+ * Adds (XORs) len words of src to dst, the row operation of Gaussian elimination
+ * over GF[2]. Processes 256 bits per step with AVX2 if processor supports it
+ * and 128 bits with NEON, remaining words are handled one by one.
+ */
+inline
+void xor_row(uint64_t *dst, const uint64_t *src, const uintmax_t len) {
+    uintmax_t i = 0;
+#if defined(IRRPOLY_CLMUL_PCLMUL)
+    if (has_avx2()) {
+        xor_row_avx2(dst, src, len);
+        return;
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 2 <= len; i += 2) {
+        vst1q_u64(dst + i, veorq_u64(vld1q_u64(dst + i), vld1q_u64(src + i)));
+    }
+#endif
+    for (; i < len; ++i) {
+        dst[i] ^= src[i];
+    }
+}
+
+} // namespace detail
+
+/**
+ * gf2poly represents a polynomial over GF[2] in bit-packed form: each 64-bit
+ * word stores 64 consecutive coefficients, bit i of word w is the term x^(64w+i).
+ * Addition and subtraction are word XOR, multiplication uses carry-less multiply,
+ * remainder is computed with word-level shift and XOR.
+ * Polynomial is either zero or reduced which means that highest word is non-zero.
+ */
+class gf2poly final {
+private:
+    std::vector<uint64_t> m_data; ///< packed polynomial coefficients
+
+    /**
+     * Removes leading zero words.
+     */
+    auto reduce() -> gf2poly & {
+        while (!m_data.empty() && m_data.back() == 0) {
+            m_data.pop_back();
+        }
+        return *this;
+    }
+
+public:
+    gf2poly() : m_data() {}
+
+    /**
+     * Constructs polynomial from coefficients list, every coefficient is taken modulo 2.
+     */
+    gf2poly(std::initializer_list<uintmax_t> l) : m_data((l.size() + 63) / 64, 0) {
+        uintmax_t i = 0;
+        for (uintmax_t v : l) {
+            m_data[i / 64] |= static_cast<uint64_t>(v & 1U) << (i % 64);
+            ++i;
+        }
+        reduce();
+    }
+
+    /**
+     * Packs polynomial over GF[2], throws if polynomial is over other field.
+     */
+    template<typename Field>
+    explicit
+    gf2poly(const basic_gfpoly<Field> &poly) : m_data((poly.size() + 63) / 64, 0) {
+        if (poly.base() != 2) {
+            throw std::invalid_argument("polynomial is not over GF[2]");
+        }
+        for (uintmax_t i = 0; i < poly.size(); ++i) {
+            m_data[i / 64] |= static_cast<uint64_t>(poly[i]) << (i % 64);
+        }
+    }
+
+    /**
+     * Constructs polynomial from packed words.
+     */
+    static
+    auto from_words(std::vector<uint64_t> words) -> gf2poly {
+        gf2poly res;
+        res.m_data = std::move(words);
+        return res.reduce();
+    }
+
+    /**
+     * Unpacks polynomial into GF[2] polynomial of general form.
+     */
+    template<typename Field>
+    [[nodiscard]]
+    auto to_gfpoly(const Field &field) const -> basic_gfpoly<Field> {
+        std::vector<uintmax_t> data(size(), 0);
+        for (uintmax_t i = 0; i < data.size(); ++i) {
+            data[i] = (*this)[i];
+        }
+        return basic_gfpoly<Field>(field, std::move(data));
+    }
+
+    [[nodiscard]]
+    auto value() const -> const std::vector<uint64_t> & {
+        return m_data;
+    }
+
+    [[nodiscard]]
+    static constexpr
+    auto base() -> uintmax_t {
+        return 2;
+    }
+
+    /**
+     * Returns number of coefficients (degree + 1), zero for zero polynomial.
+     */
+    [[nodiscard]]
+    auto size() const -> uintmax_t {
+        if (m_data.empty()) {
+            return 0;
+        }
+        uintmax_t top = 63;
+        while (!(m_data.back() >> top)) {
+            --top;
+        }
+        return (m_data.size() - 1) * 64 + top + 1;
+    }
+
+    /**
+     * Returns polynomial degree. For zero polynomial degree is undefined.
+     */
+    [[nodiscard]]
+    auto degree() const -> uintmax_t {
+        if (m_data.empty()) {
+            throw std::logic_error("degree is undefined for zero polynomial");
+        }
+        return size() - 1;
+    }
+
+    auto operator[](const uintmax_t i) const -> uintmax_t {
+        return (i / 64 < m_data.size()) ? (m_data[i / 64] >> (i % 64)) & 1U : 0;
+    }
+
+    [[nodiscard]]
+    auto is_zero() const -> bool {
+        return m_data.empty();
+    }
+
+    explicit operator bool() const {
+        return !is_zero();
+    }
+
+    [[maybe_unused]]
+    auto set_zero() -> gf2poly & {
+        m_data.clear();
+        return *this;
+    }
+
+    auto operator+=(const gf2poly &value) -> gf2poly & {
+        if (m_data.size() < value.m_data.size()) {
+            m_data.resize(value.m_data.size(), 0);
+        }
+        for (uintmax_t i = 0; i < value.m_data.size(); ++i) {
+            m_data[i] ^= value.m_data[i];
+        }
+        return reduce();
+    }
+
+    auto operator-=(const gf2poly &value) -> gf2poly & {
+        return *this += value;
+    }
+
+    auto operator*=(const gf2poly &value) -> gf2poly & {
+        if (is_zero() || value.is_zero()) {
+            return set_zero();
+        }
+        detail::count(counter::multiplications);
+        std::vector<uint64_t> prod(m_data.size() + value.m_data.size(), 0);
+        detail::clmul_words(prod.data(), m_data.data(), m_data.size(),
+                            value.m_data.data(), value.m_data.size());
+        m_data.swap(prod);
+        return reduce();
+    }
+
+    /**
+     * Squaring over GF[2] only spreads bits, so it is cheaper than multiplication.
+     */
+    [[nodiscard]]
+    auto square() const -> gf2poly {
+        detail::count(counter::multiplications);
+        gf2poly res;
+        res.m_data.resize(2 * m_data.size(), 0);
+        uint64_t hi = 0;
+        for (uintmax_t i = 0; i < m_data.size(); ++i) {
+            res.m_data[2 * i] = detail::clmul(m_data[i], m_data[i], hi);
+            res.m_data[2 * i + 1] = hi;
+        }
+        return res.reduce();
+    }
+
+private:
+    /**
+     * this ^= value * x^shift.
+     */
+    void xor_shifted(const gf2poly &value, const uintmax_t shift) {
+        const uintmax_t ws = shift / 64, bs = shift % 64;
+        const auto need = value.m_data.size() + ws + (bs ? 1 : 0);
+        if (m_data.size() < need) {
+            m_data.resize(need, 0);
+        }
+        for (uintmax_t w = 0; w < value.m_data.size(); ++w) {
+            m_data[w + ws] ^= value.m_data[w] << bs;
+            if (bs) {
+                m_data[w + ws + 1] ^= value.m_data[w] >> (64 - bs);
+            }
+        }
+    }
+
+    /**
+     * Reduces this modulo v, quotient bits are stored into q if it is not null.
+     */
+    void division(const gf2poly &v, gf2poly *q) {
+        if (v.is_zero()) {
+            throw std::invalid_argument("division by zero");
+        }
+        const auto n = v.degree();
+        detail::count(counter::remainders);
+        if (q) {
+            q->set_zero();
+        }
+        if (is_zero() || degree() < n) {
+            return;
+        }
+        if (q) {
+            q->m_data.resize((degree() - n) / 64 + 1, 0);
+        }
+        for (auto d = degree(); d >= n; --d) {
+            if ((*this)[d]) {
+                xor_shifted(v, d - n);
+                if (q) {
+                    q->m_data[(d - n) / 64] |= uint64_t(1) << ((d - n) % 64);
+                }
+            }
+            if (d == 0) {
+                break;
+            }
+        }
+        reduce();
+        if (q) {
+            q->reduce();
+        }
+    }
+
+public:
+    auto operator/=(const gf2poly &value) -> gf2poly & {
+        gf2poly q;
+        division(value, &q);
+        m_data.swap(q.m_data);
+        return *this;
+    }
+
+    auto operator%=(const gf2poly &value) -> gf2poly & {
+        division(value, nullptr);
+        return *this;
+    }
+
+    /**
+     * Logically equal to operation this *= x^n.
+     */
+    auto operator<<=(const uintmax_t n) -> gf2poly & {
+        if (is_zero() || n == 0) {
+            return *this;
+        }
+        gf2poly res;
+        res.xor_shifted(*this, n);
+        m_data.swap(res.m_data);
+        return reduce();
+    }
+
+    /**
+     * Logically equal to operation this /= x^n. Defined only when such devision is possible.
+     */
+    auto operator>>=(const uintmax_t n) -> gf2poly & {
+        if (n == 0) {
+            return *this;
+        }
+        if (is_zero() || n > degree()) {
+            throw std::logic_error("division is impossible");
+        }
+        for (uintmax_t i = 0; i < n; ++i) {
+            if ((*this)[i]) {
+                throw std::logic_error("division is impossible");
+            }
+        }
+        const uintmax_t ws = n / 64, bs = n % 64;
+        for (uintmax_t w = 0; w + ws < m_data.size(); ++w) {
+            m_data[w] = m_data[w + ws] >> bs;
+            if (bs && w + ws + 1 < m_data.size()) {
+                m_data[w] |= m_data[w + ws + 1] << (64 - bs);
+            }
+        }
+        m_data.resize(m_data.size() - ws);
+        return reduce();
+    }
+
+    friend
+    auto operator+(gf2poly a, const gf2poly &b) -> gf2poly {
+        a += b;
+        return a;
+    }
+
+    friend
+    auto operator-(gf2poly a, const gf2poly &b) -> gf2poly {
+        a -= b;
+        return a;
+    }
+
+    friend
+    auto operator*(gf2poly a, const gf2poly &b) -> gf2poly {
+        a *= b;
+        return a;
+    }
+
+    friend
+    auto operator/(gf2poly a, const gf2poly &b) -> gf2poly {
+        a /= b;
+        return a;
+    }
+
+    friend
+    auto operator%(gf2poly a, const gf2poly &b) -> gf2poly {
+        a %= b;
+        return a;
+    }
+
+    friend
+    auto operator<<(gf2poly a, const uintmax_t n) -> gf2poly {
+        a <<= n;
+        return a;
+    }
+
+    friend
+    auto operator>>(gf2poly a, const uintmax_t n) -> gf2poly {
+        a >>= n;
+        return a;
+    }
+
+    friend
+    auto operator==(const gf2poly &a, const gf2poly &b) -> bool {
+        return a.m_data == b.m_data;
+    }
+
+    friend
+    auto operator!=(const gf2poly &a, const gf2poly &b) -> bool {
+        return a.m_data != b.m_data;
+    }
+
+    template<class charT, class traits>
+    friend
+    auto operator<<(std::basic_ostream<charT, traits> &os, const gf2poly &poly)
+    -> std::basic_ostream<charT, traits> & {
+        os << "{ ";
+        for (uintmax_t i = 0; i < poly.size(); ++i) {
+            if (i) {
+                os << ", ";
+            }
+            os << poly[i];
+        }
+        os << " }";
+        return os;
+    }
+};
+
+} // namespace irrpoly
@@ -0,0 +1,409 @@
+/**
+ * @file    gfbatch.hpp
+ * @author  Vadim Piven <vadim@piven.tech>
+ * @license Free use of this library is permitted under the
+ * guidelines and in accordance with the MIT License (MIT).
+ * @url     https://github.com/irreducible-polynoms/irrpoly
+ */
+
+#pragma once
+
+#include "gfpoly.hpp"
+#include "biguint.hpp"
+
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdint>
+
+namespace irrpoly {
+
+/**
+ * Binary operations for two gfn instances are correctly defined only
+ * when field is the same for both of them. By default this is checked
+ * only in Debug configuration and no checks performed in Release to speed
+ * up computations. If you are not sure in correctness of your code add
+ * #define IRRPOLY_RELEASE_CHECKED before #include <irrpoly.h> to enable
+ * checks for Release configuration.
+ */
+#if !defined(NDEBUG) || defined(IRRPOLY_RELEASE_CHECKED) // Debug or Release Checked
+#define CHECK_FIELD(comparison) \
+    if (!(comparison)) { \
+        throw std::logic_error("field check failed"); \
+    }
+#else // Release
+#define CHECK_FIELD(comparison)
+#endif
+
+namespace detail {
+
+/**
+ * Lane operation dst[r] += a[r] * b[r] without reduction, see lazy_bound.
+ * There are no branches and no divisions, so the loop is vectorized.
+ */
+inline void lanes_add_mul_lazy(uintmax_t *dst, const uintmax_t *a,
+                               const uintmax_t *b, const uintmax_t lanes) {
+    for (uintmax_t r = 0; r < lanes; ++r) {
+        dst[r] += a[r] * b[r];
+    }
+}
+
+/**
+ * Lane operation dst[r] = dst[r] + a[r] * b[r] with reduction, used for large bases.
+ */
+template<typename Field>
+void lanes_add_mul(const Field &field, uintmax_t *dst, const uintmax_t *a,
+                   const uintmax_t *b, const uintmax_t lanes) {
+    for (uintmax_t r = 0; r < lanes; ++r) {
+        dst[r] = field->add(dst[r], field->mul(a[r], b[r]));
+    }
+}
+
+} // namespace detail
+
+/**
+ * basic_gfpoly_batch stores many polynomials over the same field with degree
+ * at most degree() in one coefficient matrix. Matrix is stored by coefficients:
+ * coefficient j of all polynomials is a contiguous column of count() lanes,
+ * so batch operations process every polynomial at once by vectorized loops
+ * and there is a single allocation for the whole batch.
+ * Field type could be either gf or gf_static<P>, rows are extracted as basic_gfpoly.
+ */
+template<typename Field>
+class basic_gfpoly_batch final {
+private:
+    Field m_field;
+    uintmax_t m_size; ///< coefficients per polynomial, degree + 1
+    uintmax_t m_count; ///< number of polynomials
+    std::vector<uintmax_t> m_data; ///< coefficient j of polynomial r is m_data[j * m_count + r]
+
+    template<typename Bits>
+    auto x_pow_impl(uintmax_t len, const Bits &bit) const -> basic_gfpoly_batch;
+
+public:
+    /**
+     * Creates batch of count zero polynomials of degree at most degree.
+     */
+    basic_gfpoly_batch(const Field &field, const uintmax_t degree, const uintmax_t count) :
+        m_field(field), m_size(degree + 1), m_count(count), m_data(m_size * count, 0) {}
+
+    /**
+     * Creates batch from row-major buffer of polynomials with degree + 1 coefficients each,
+     * lower coefficient goes first (the format of random_batch).
+     */
+    basic_gfpoly_batch(const Field &field, const uintmax_t degree, const std::vector<uintmax_t> &rows) :
+        m_field(field), m_size(degree + 1), m_count(rows.size() / (degree + 1)), m_data(rows.size()) {
+        if (rows.size() % m_size) {
+            throw std::invalid_argument("buffer size must be a multiple of degree + 1");
+        }
+        for (uintmax_t r = 0; r < m_count; ++r) {
+            for (uintmax_t j = 0; j < m_size; ++j) {
+                m_data[j * m_count + r] = m_field->reduce(rows[r * m_size + j]);
+            }
+        }
+    }
+
+    /**
+     * Packs polynomials into batch, degree is the largest degree among them.
+     */
+    basic_gfpoly_batch(const Field &field, const std::vector<basic_gfpoly<Field>> &polys) :
+        m_field(field), m_size(1), m_count(polys.size()), m_data() {
+        for (const auto &p : polys) {
+            CHECK_FIELD(m_field == p.field())
+            m_size = std::max<uintmax_t>(m_size, p.size());
+        }
+        m_data.assign(m_size * m_count, 0);
+        for (uintmax_t r = 0; r < m_count; ++r) {
+            const auto &v = polys[r].value();
+            for (uintmax_t j = 0; j < v.size(); ++j) {
+                m_data[j * m_count + r] = v[j];
+            }
+        }
+    }
+
+    /**
+     * Creates batch of candidates [first, first + count) of the random sequence seed,
+     * see random_indexed.
+     */
+    [[nodiscard]]
+    static
+    auto random(const Field &field, const uintmax_t degree, const uintmax_t count,
+                const uint64_t seed, const uint64_t first = 0) -> basic_gfpoly_batch {
+        basic_gfpoly_batch res(field, degree, count);
+        std::vector<uintmax_t> row(degree + 1);
+        for (uintmax_t r = 0; r < count; ++r) {
+            detail::random_monic(field->base(), degree, seed, first + r, row.data());
+            for (uintmax_t j = 0; j <= degree; ++j) {
+                res.m_data[j * count + r] = row[j];
+            }
+        }
+        return res;
+    }
+
+    [[nodiscard]]
+    auto field() const -> const Field & {
+        return m_field;
+    }
+
+    /**
+     * Returns the upper bound of degrees of polynomials.
+     */
+    [[nodiscard]]
+    auto degree() const -> uintmax_t {
+        return m_size - 1;
+    }
+
+    /**
+     * Returns the number of polynomials.
+     */
+    [[nodiscard]]
+    auto count() const -> uintmax_t {
+        return m_count;
+    }
+
+    /**
+     * Returns coefficient j of polynomial r.
+     */
+    [[nodiscard]]
+    auto operator()(const uintmax_t r, const uintmax_t j) const -> uintmax_t {
+        return m_data[j * m_count + r];
+    }
+
+    /**
+     * Returns column of coefficients j of all polynomials.
+     */
+    [[nodiscard]]
+    auto column(const uintmax_t j) const -> const uintmax_t * {
+        return m_data.data() + j * m_count;
+    }
+
+    /**
+     * Sets coefficient j of polynomial r.
+     */
+    void set(const uintmax_t r, const uintmax_t j, const uintmax_t val) {
+        m_data[j * m_count + r] = m_field->reduce(val);
+    }
+
+    /**
+     * Returns polynomial r.
+     */
+    [[nodiscard]]
+    auto row(const uintmax_t r) const -> basic_gfpoly<Field> {
+        std::vector<uintmax_t> data(m_size);
+        for (uintmax_t j = 0; j < m_size; ++j) {
+            data[j] = m_data[j * m_count + r];
+        }
+        return basic_gfpoly<Field>(m_field, std::move(data));
+    }
+
+    /**
+     * Unpacks all the polynomials.
+     */
+    [[nodiscard]]
+    auto rows() const -> std::vector<basic_gfpoly<Field>> {
+        std::vector<basic_gfpoly<Field>> res;
+        res.reserve(m_count);
+        for (uintmax_t r = 0; r < m_count; ++r) {
+            res.emplace_back(row(r));
+        }
+        return res;
+    }
+
+    /**
+     * Returns true if leading coefficient of every polynomial is non-zero,
+     * which means all of them have degree exactly degree().
+     */
+    [[nodiscard]]
+    auto is_exact() const -> bool {
+        const auto lead = column(m_size - 1);
+        return std::all_of(lead, lead + m_count, [](uintmax_t v) { return v != 0; });
+    }
+
+    /**
+     * Evaluates all polynomials at point x by Horner's method.
+     */
+    [[nodiscard]]
+    auto eval(const uintmax_t x) const -> std::vector<uintmax_t> {
+        const auto px = m_field->reduce(x);
+        std::vector<uintmax_t> acc(column(m_size - 1), column(m_size - 1) + m_count);
+        const bool lazy = detail::lazy_bound(m_field) > 0;
+        for (auto j = m_size - 1; j > 0;) {
+            const auto col = column(--j);
+            for (uintmax_t r = 0; r < m_count; ++r) {
+                acc[r] = lazy ? m_field->reduce(acc[r] * px + col[r])
+                              : m_field->add(m_field->mul(acc[r], px), col[r]);
+            }
+        }
+        return acc;
+    }
+
+    /**
+     * Returns batch of products of all polynomials by g.
+     */
+    [[nodiscard]]
+    auto mul(const basic_gfpoly<Field> &g) const -> basic_gfpoly_batch {
+        CHECK_FIELD(m_field == g.field())
+        if (g.is_zero()) {
+            return basic_gfpoly_batch(m_field, 0, m_count);
+        }
+        const auto &b = g.value();
+        basic_gfpoly_batch res(m_field, degree() + g.degree(), m_count);
+        const auto len = m_size * m_count;
+        const auto bound = detail::lazy_bound(m_field);
+        if (bound < 2) {
+            for (uintmax_t k = 0; k < b.size(); ++k) {
+                if (b[k]) {
+                    detail::row_sub_mul(m_field, res.m_data.data() + k * m_count,
+                                        m_data.data(), m_field->neg(b[k]), len);
+                }
+            }
+            return res;
+        }
+        // columns [first, k + m_size) were accumulated since the last reduction
+        uintmax_t first = 0;
+        for (uintmax_t k = 0; k < b.size(); ++k) {
+            if (k - first == bound) {
+                detail::reduce_range(m_field, res.m_data.data() + first * m_count,
+                                     (k - first + m_size - 1) * m_count);
+                first = k;
+            }
+            if (b[k]) {
+                detail::row_add_mul_lazy(res.m_data.data() + k * m_count, m_data.data(), b[k], len);
+            }
+        }
+        detail::reduce_range(m_field, res.m_data.data() + first * m_count,
+                             (b.size() - first + m_size - 1) * m_count);
+        return res;
+    }
+
+    /**
+     * Returns batch of residues x^pow mod f for every polynomial f of the batch,
+     * residues have degree at most degree() - 1. Requires is_exact() and degree() > 0.
+     */
+    [[nodiscard]]
+    auto x_pow_mod(const uintmax_t pow) const -> basic_gfpoly_batch {
+        uintmax_t len = 0;
+        for (auto p = pow; p; p >>= 1U) {
+            ++len;
+        }
+        return x_pow_impl(len, [pow](uintmax_t i) { return (pow >> i) & 1U; });
+    }
+
+    /**
+     * Returns batch of residues x^pow mod f for exponents exceeding uintmax_t.
+     */
+    [[nodiscard]]
+    auto x_pow_mod(const detail::biguint &pow) const -> basic_gfpoly_batch {
+        return x_pow_impl(pow.bit_length(), [&pow](uintmax_t i) { return pow.bit(i); });
+    }
+};
+
+template<typename Field>
+template<typename Bits>
+auto basic_gfpoly_batch<Field>::x_pow_impl(uintmax_t len, const Bits &bit) const -> basic_gfpoly_batch {
+    const auto n = degree(), c = m_count;
+    if (n == 0) {
+        throw std::domain_error("moduli must have positive degree");
+    }
+    if (!is_exact()) {
+        throw std::domain_error("moduli must have exact degree");
+    }
+    // negated lower coefficients of normalized moduli, x^n = nf[0] + ... + nf[n - 1] x^(n - 1)
+    std::vector<uintmax_t> nf(n * c), lead(column(n), column(n) + c);
+    for (auto &v : lead) {
+        v = (v == 1) ? 1 : m_field->mul_inv(v);
+    }
+    for (uintmax_t j = 0; j < n; ++j) {
+        for (uintmax_t r = 0; r < c; ++r) {
+            nf[j * c + r] = m_field->neg(m_field->mul(m_data[j * c + r], lead[r]));
+        }
+    }
+
+    const auto bound = detail::lazy_bound(m_field);
+    basic_gfpoly_batch res(m_field, n - 1, c);
+    auto *const a = res.m_data.data();
+    std::fill(a, a + c, 1);
+    std::vector<uintmax_t> prod((2 * n - 1) * c), dbl(c);
+    auto *const p = prod.data();
+
+    auto sqr = [&]() {
+        std::fill(prod.begin(), prod.end(), 0);
+        // a^2 = sum a[i]^2 x^(2i) + sum 2 a[i] a[j] x^(i + j), i < j
+        uintmax_t first = 0;
+        for (uintmax_t i = 0; i < n; ++i) {
+            for (uintmax_t r = 0; r < c; ++r) {
+                dbl[r] = m_field->add(a[i * c + r], a[i * c + r]);
+            }
+            if (bound < 2) {
+                detail::lanes_add_mul(m_field, p + 2 * i * c, a + i * c, a + i * c, c);
+                for (uintmax_t j = i + 1; j < n; ++j) {
+                    detail::lanes_add_mul(m_field, p + (i + j) * c, dbl.data(), a + j * c, c);
+                }
+                continue;
+            }
+            if (i - first == bound) {
+                detail::reduce_range(m_field, p + 2 * first * c, (2 * n - 1 - 2 * first) * c);
+                first = i;
+            }
+            detail::lanes_add_mul_lazy(p + 2 * i * c, a + i * c, a + i * c, c);
+            for (uintmax_t j = i + 1; j < n; ++j) {
+                detail::lanes_add_mul_lazy(p + (i + j) * c, dbl.data(), a + j * c, c);
+            }
+        }
+        if (bound >= 2) {
+            detail::reduce_range(m_field, p + 2 * first * c, (2 * n - 1 - 2 * first) * c);
+        }
+        // reduction from the highest column, column n + k is reduced before use
+        uintmax_t pending = 0, top = 0;
+        for (auto k = n - 1; k > 0;) {
+            --k;
+            auto *const q = p + (n + k) * c;
+            if (bound < 2) {
+                for (uintmax_t j = 0; j < n; ++j) {
+                    detail::lanes_add_mul(m_field, p + (k + j) * c, q, nf.data() + j * c, c);
+                }
+                continue;
+            }
+            if (pending == bound) {
+                detail::reduce_range(m_field, p + (k + 1) * c, (top - k - 1) * c);
+                pending = 0;
+            }
+            detail::reduce_range(m_field, q, c);
+            if (!pending) {
+                top = n + k;
+            }
+            for (uintmax_t j = 0; j < n; ++j) {
+                detail::lanes_add_mul_lazy(p + (k + j) * c, q, nf.data() + j * c, c);
+            }
+            ++pending;
+        }
+        if (bound >= 2) {
+            detail::reduce_range(m_field, p, n * c);
+        }
+        std::copy(p, p + n * c, a);
+    };
+
+    // multiplication by x is a shift of columns and a single reduction step
+    auto shift = [&]() {
+        std::copy(a + (n - 1) * c, a + n * c, dbl.begin());
+        std::copy_backward(a, a + (n - 1) * c, a + n * c);
+        std::fill(a, a + c, 0);
+        for (uintmax_t j = 0; j < n; ++j) {
+            detail::lanes_add_mul(m_field, a + j * c, dbl.data(), nf.data() + j * c, c);
+        }
+    };
+
+    for (; len > 0; --len) {
+        sqr();
+        if (bit(len - 1)) {
+            shift();
+        }
+    }
+    return res;
+}
+
+using gfpoly_batch = basic_gfpoly_batch<gf>;
+
+#undef CHECK_FIELD
+
+} // namespace irrpoly
@@ -10,6 +10,23 @@
 
 #include "pipeline.hpp"
 #include "gfpoly.hpp"
+#include "gfmod.hpp"
+#include "gfbatch.hpp"
+#include "executor.hpp"
+#include "stop.hpp"
+#include "stats.hpp"
+#include "gfcost.hpp"
+#include "gf2poly.hpp"
+#include "biguint.hpp"
+
+#include <map>
+#include <memory>
+#include <algorithm>
+#include <future>
+#include <chrono>
+#include <optional>
+#include <mutex>
+#include <tuple>
 
 namespace irrpoly {
 
@@ -30,90 +47,570 @@ namespace irrpoly {
 #define CHECK_FIELD(comparison)
 #endif
 
+namespace detail {
+
+/**
+ * Polynomials of degree at least this use half-GCD in gcd, smaller ones use
+ * remainder sequence directly. Could be changed before checks are started.
+ * With the current multiplication tiers half-GCD is still about twice slower than
+ * remainder sequence up to degree 4096 ("multiplication tiers" benchmark),
+ * so it is disabled by default.
+ */
+inline uintmax_t hgcd_threshold = UINTMAX_MAX;
+
+/**
+ * Returns a div x^k, i.e. polynomial without k lowest terms.
+ */
+template<typename Field>
+[[nodiscard]]
+auto shift_down(const basic_gfpoly<Field> &a, const uintmax_t k) -> basic_gfpoly<Field> {
+    if (a.size() <= k) {
+        return basic_gfpoly<Field>(a.field());
+    }
+    return basic_gfpoly<Field>(a.field(), std::vector<uintmax_t>(a.value().begin() + k, a.value().end()));
+}
+
+/**
+ * 2x2 polynomial matrix, which transforms pair of consecutive remainders of Euclid's
+ * algorithm into the later pair: (r[j], r[j+1]) = M * (r[0], r[1]).
+ */
+template<typename Field>
+struct gcd_matrix {
+    basic_gfpoly<Field> m00, m01, m10, m11;
+
+    explicit
+    gcd_matrix(const Field &field) :
+        m00(field, 1), m01(field), m10(field), m11(field, 1) {}
+
+    /**
+     * Applies matrix to the pair (a, b).
+     */
+    void apply(basic_gfpoly<Field> &a, basic_gfpoly<Field> &b) const {
+        auto c = m00 * a + m01 * b;
+        b = m10 * a + m11 * b;
+        a = std::move(c);
+    }
+
+    /**
+     * Replaces matrix M by S * M.
+     */
+    void premultiply(const gcd_matrix &s) {
+        auto n00 = s.m00 * m00 + s.m01 * m10, n01 = s.m00 * m01 + s.m01 * m11;
+        auto n10 = s.m10 * m00 + s.m11 * m10, n11 = s.m10 * m01 + s.m11 * m11;
+        m00 = std::move(n00), m01 = std::move(n01), m10 = std::move(n10), m11 = std::move(n11);
+    }
+
+    /**
+     * Replaces matrix M by [[0, 1], [1, -q]] * M, the single step of Euclid's algorithm.
+     */
+    void premultiply_step(const basic_gfpoly<Field> &q) {
+        auto n10 = m00 - q * m10, n11 = m01 - q * m11;
+        swap(m00, m10), swap(m01, m11);
+        m10 = std::move(n10), m11 = std::move(n11);
+    }
+};
+
 /**
- * Calculates greatest common divisor for two polynomials.
+ * Half-GCD: for deg(a) > deg(b) returns matrix M, such that M * (a, b) is the pair
+ * of consecutive remainders with deg(r[j]) >= ceil(deg(a) / 2) > deg(r[j+1]).
+ * Quotients only depend on the highest terms, so both halves of the remainder sequence
+ * are found recursively from the polynomials of half degree.
+ * For more information read "Fast Algorithms for Polynomials over Finite Fields"
+ * (chapter 11 of "Modern Computer Algebra" by von zur Gathen and Gerhard).
+ */
+template<typename Field>
+[[nodiscard]]
+auto hgcd(const basic_gfpoly<Field> &a, const basic_gfpoly<Field> &b) -> gcd_matrix<Field> {
+    const auto m = (a.degree() + 1) / 2;
+    gcd_matrix<Field> r(a.field());
+    if (b.is_zero() || b.degree() < m) {
+        return r;
+    }
+
+    r = hgcd(shift_down(a, m), shift_down(b, m));
+    auto c = a, d = b;
+    r.apply(c, d);
+    if (d.is_zero() || d.degree() < m) {
+        return r;
+    }
+
+    basic_gfpoly<Field> q(a.field()), e(a.field());
+    basic_gfpoly<Field>::divrem_into(q, e, c, d);
+    r.premultiply_step(q);
+    if (e.is_zero() || e.degree() < m) {
+        return r;
+    }
+
+    const auto k = 2 * m - d.degree();
+    r.premultiply(hgcd(shift_down(d, k), shift_down(e, k)));
+    return r;
+}
+
+/**
+ * Greatest common divisor using half-GCD, requires deg(a) >= deg(b).
+ * Returns the same polynomial as Euclid's algorithm does.
+ */
+template<typename Field>
+[[nodiscard]]
+auto gcd_hgcd(basic_gfpoly<Field> a, basic_gfpoly<Field> b) -> basic_gfpoly<Field> {
+    while (b && b.degree() >= hgcd_threshold) {
+        if (a.degree() == b.degree()) {
+            a.rem_inplace(b);
+            swap(a, b);
+            continue;
+        }
+        hgcd(a, b).apply(a, b);
+        if (b) {
+            // remainders are now of about half degree, one ordinary step is required
+            a.rem_inplace(b);
+            swap(a, b);
+        }
+    }
+    while (b) {
+        a.rem_inplace(b);
+        swap(a, b);
+    }
+    return a;
+}
+
+} // namespace detail
+
+/**
+ * Calculates greatest common divisor for two polynomials. Result is the last
+ * non-zero remainder of Euclid's algorithm, it is not normalized.
+ * Large polynomials are processed by subquadratic half-GCD algorithm.
+ * If Bezout coefficients are required use xgcd.
+ */
+template<typename Field>
+[[nodiscard]]
+auto gcd(basic_gfpoly<Field> m, basic_gfpoly<Field> n) -> basic_gfpoly<Field> {
+    CHECK_FIELD(m.field() == n.field())
+    if (m.is_zero() || n.is_zero()) {
+        throw std::domain_error("arguments must be strictly positive");
+    }
+    if (m.degree() < n.degree()) {
+        swap(m, n);
+    }
+    if (n.degree() >= detail::hgcd_threshold) {
+        return detail::gcd_hgcd(std::move(m), std::move(n));
+    }
+    while (n) {
+        detail::count(counter::gcd_steps);
+        m.rem_inplace(n);
+        swap(m, n);
+    }
+    return m;
+}
+
+/**
+ * Calculates greatest common divisor g for two polynomials together with
+ * Bezout coefficients s and t: g = s * m + t * n. Returned tuple is (g, s, t),
+ * g is the same as gcd returns.
  * Originally taken from Boost library, then made some changes.
  */
+template<typename Field>
 [[nodiscard]]
-auto gcd(gfpoly m, gfpoly n) -> gfpoly {
+auto xgcd(basic_gfpoly<Field> m, basic_gfpoly<Field> n)
+-> std::tuple<basic_gfpoly<Field>, basic_gfpoly<Field>, basic_gfpoly<Field>> {
     CHECK_FIELD(m.field() == n.field())
     if (m.is_zero() || n.is_zero()) {
         throw std::domain_error("arguments must be strictly positive");
     }
     if (m.degree() < n.degree()) {
-        std::swap(m, n);
+        auto [g, t, s] = xgcd(std::move(n), std::move(m));
+        return std::make_tuple(std::move(g), std::move(s), std::move(t));
     }
-    gfpoly u0 = m, u1 = gfpoly(m.field(), 1), u2 = gfpoly(m.field()),
-        v0 = n, v1 = gfpoly(m.field()), v2 = gfpoly(m.field(), 1),
-        w0 = gfpoly(m.field()), w1 = gfpoly(m.field()), w2 = gfpoly(m.field()),
-        q = gfpoly(m.field());
+    // all temporaries are created once, then buffers are rotated by swap
+    const auto field = m.field();
+    basic_gfpoly<Field> u0 = std::move(m), u1(field, 1), u2(field),
+        v0 = std::move(n), v1(field), v2(field, 1), w0(field), w1(field), w2(field),
+        q(field), t(field);
     while (v0) {
-        q = u0 / v0;
-        w0 = u0 - q * v0, w1 = u1 - q * v1, w2 = u2 - q * v2;
-        u0 = v0, u1 = v1, u2 = v2, v0 = w0, v1 = w1, v2 = w2;
+        detail::count(counter::gcd_steps);
+        basic_gfpoly<Field>::divrem_into(q, w0, u0, v0);
+        basic_gfpoly<Field>::mul_into(t, q, v1);
+        w1 = u1;
+        w1 -= t;
+        basic_gfpoly<Field>::mul_into(t, q, v2);
+        w2 = u2;
+        w2 -= t;
+        swap(u0, v0), swap(u1, v1), swap(u2, v2);
+        swap(v0, w0), swap(v1, w1), swap(v2, w2);
     }
-    return u0;
+    return std::make_tuple(std::move(u0), std::move(u1), std::move(u2));
 }
 
-namespace detail {
-
 /**
- * Quick computation of t^n for T and N being integer types.
- * Originally taken from Boost library, then made some changes.
+ * Calculates greatest common divisor for two polynomials over GF[2].
+ * Bezout coefficients are not needed over GF[2], so the plain Euclid's algorithm is used.
  */
-template<class T, class N>
 [[nodiscard]]
-auto integer_power(T t, N n) -> T {
-    switch (n) {
-    case 0:return static_cast<T>(1U);
-    case 1:return t;
-    case 2:return t * t;
-    case 3:return t * t * t;
-    default:T result = integer_power(t, n / 2);
-        return (n & 1U) ? result * result * t : result * result;
+inline
+auto gcd(gf2poly m, gf2poly n) -> gf2poly {
+    if (m.is_zero() || n.is_zero()) {
+        throw std::domain_error("arguments must be strictly positive");
+    }
+    while (n) {
+        detail::count(counter::gcd_steps);
+        m %= n;
+        std::swap(m, n);
     }
+    return m;
 }
 
+namespace detail {
+
 /**
  * Calculates derivative for given polynomial.
  */
+template<typename Field>
 [[nodiscard]]
-auto derivative(const gfpoly &poly) -> gfpoly {
+auto derivative(const basic_gfpoly<Field> &poly) -> basic_gfpoly<Field> {
     if (poly.is_zero() || poly.degree() == 0) {
-        return gfpoly(poly.field());
+        return basic_gfpoly<Field>(poly.field());
     }
     std::vector<uintmax_t> res(poly.size() - 1, 0);
     for (uintmax_t i = 1; i < poly.size(); ++i) {
-        res[i - 1] = (i % poly.base()) * poly[i];
+        // i is an element of the prime subfield, its residue is i % characteristic
+        res[i - 1] = poly.field()->mul(poly.field()->reduce(i % poly.field()->characteristic()), poly[i]);
+    }
+    return basic_gfpoly<Field>(poly.field(), res);
+}
+
+/**
+ * Calculates derivative for given polynomial over GF[2]: only odd terms remain
+ * and they are shifted by one position.
+ */
+[[nodiscard]]
+inline
+auto derivative(const gf2poly &poly) -> gf2poly {
+    auto words = poly.value();
+    for (uintmax_t i = 0; i < words.size(); ++i) {
+        words[i] >>= 1U;
+        if (i + 1 < words.size()) {
+            words[i] |= words[i + 1] << 63U;
+        }
+        words[i] &= UINT64_C(0x5555555555555555);
     }
-    return gfpoly(poly.field(), res);
+    return gf2poly::from_words(std::move(words));
+}
+
+/**
+ * Calculates (x^pow) % mod by binary exponentiation (square-and-multiply),
+ * see basic_gfmod::x_powmod. Create basic_gfmod directly when several
+ * operations share the modulus.
+ */
+template<typename Field>
+[[nodiscard]]
+auto x_pow_mod(uintmax_t pow, const basic_gfpoly<Field> &mod) -> basic_gfpoly<Field> {
+    return basic_gfmod<Field>(mod).x_powmod(pow);
+}
+
+/**
+ * Calculates (x^pow) % mod for exponents exceeding uintmax_t, such as P^n - 1.
+ */
+template<typename Field>
+[[nodiscard]]
+auto x_pow_mod(const biguint &pow, const basic_gfpoly<Field> &mod) -> basic_gfpoly<Field> {
+    return basic_gfmod<Field>(mod).x_powmod(pow);
 }
 
 /**
- * Calculates (x^pow) % mod.
- * Reduces the amount of memory used during computation.
- * Work principle is that during column division x^n is represented as [0 ... 0 1],
- * so we can take only some of zeroes, perform division partially, then pad more
- * zeroes and continue division. As a bonus there are some cases when we'll
- * get 0 ... 0 1 (which is x^m) somewhere during division process. In this case we
- * could calculate tmp = (n - m) and skip (k * tmp) steps because after each
- * tmp division iterations we well get x^(m - k*tmp).
- * TODO: check FLINT sources for similar function and rewrite this to speed up.
+ * Returns sorted list of distinct prime divisors of r = (P^n - 1) / (P - 1),
+ * the exponent used by primitivity test. r is the product of cyclotomic values
+ * Phi_d(P) for d | n, d > 1, they are factored one by one, so Pollard's rho works
+ * with shorter numbers.
  */
 [[nodiscard]]
-auto x_pow_mod(uintmax_t pow, const gfpoly &mod) -> gfpoly {
-    const auto n = mod.degree();
-    gfpoly xn = gfpoly(mod.field(), 1) << n; // x^n
-    gfpoly res(mod.field(), 1);
+inline
+auto factor_primitive_exponent(const uintmax_t P, const uintmax_t n) -> std::vector<biguint> {
+    std::map<uintmax_t, biguint> phi; // Phi_d(P) of divisors found so far
+    std::vector<biguint> res;
+    for (uintmax_t d = 1; d <= n; ++d) {
+        if (n % d) {
+            continue;
+        }
+        // P^d - 1 is the product of Phi_e(P) for all e | d
+        auto val = biguint::power(P, d) - 1;
+        for (const auto &[e, pe] : phi) {
+            if (d % e == 0) {
+                val /= pe;
+            }
+        }
+        if (d > 1) {
+            throw_if_stopped();
+            for (auto &q : prime_divisors(val)) {
+                res.push_back(std::move(q));
+            }
+        }
+        phi.emplace(d, std::move(val));
+    }
+    std::sort(res.begin(), res.end());
+    res.erase(std::unique(res.begin(), res.end()), res.end());
+    return res;
+}
+
+/**
+ * Values built once per key on first demand and shared between threads. Building
+ * runs outside the lock, so slow key doesn't block the others, threads asking for
+ * the same key wait for the first one (and still throw operation_cancelled once
+ * their own stop is requested). Failed build, e.g. cancelled one, is not cached:
+ * next demand builds the value again. References stay valid while the cache lives.
+ */
+template<typename Key, typename Value>
+class once_cache final {
+private:
+    using future = std::shared_future<std::shared_ptr<const Value>>;
+
+    std::mutex m_mutex;
+    std::map<Key, future> m_values;
+
+public:
+    once_cache() : m_mutex(), m_values() {}
+
+    template<typename Build>
+    [[nodiscard]]
+    auto get(const Key &key, Build build) -> const Value & {
+        while (true) {
+            std::promise<std::shared_ptr<const Value>> promise;
+            future value;
+            bool owner = false;
+            {
+                const std::lock_guard<std::mutex> lock(m_mutex);
+                auto it = m_values.find(key);
+                owner = (it == m_values.end());
+                if (owner) {
+                    it = m_values.emplace(key, promise.get_future().share()).first;
+                }
+                value = it->second;
+            }
+            if (owner) {
+                try {
+                    promise.set_value(std::make_shared<const Value>(build()));
+                } catch (...) {
+                    {
+                        const std::lock_guard<std::mutex> lock(m_mutex);
+                        m_values.erase(key);
+                    }
+                    promise.set_exception(std::current_exception());
+                    throw;
+                }
+                return *value.get();
+            }
+            while (value.wait_for(std::chrono::milliseconds(1)) != std::future_status::ready) {
+                throw_if_stopped();
+            }
+            try {
+                return *value.get();
+            } catch (...) {} // the first thread failed, value is built again
+        }
+    }
+};
+
+/**
+ * Returns sorted list of distinct prime divisors of r = (P^n - 1) / (P - 1),
+ * the exponent used by primitivity test. Factorization is the expensive part
+ * of the test and depends only on P and n, so results are cached and shared
+ * between threads. Returned reference stays valid until program termination.
+ */
+[[nodiscard]]
+inline
+auto primitive_factors(const uintmax_t P, const uintmax_t n) -> const std::vector<biguint> & {
+    static once_cache<std::pair<uintmax_t, uintmax_t>, std::vector<biguint>> cache;
+    return cache.get(std::make_pair(P, n), [P, n]() { return factor_primitive_exponent(P, n); });
+}
+
+/**
+ * Frobenius map g -> g^P (mod poly) is linear over GF[P], as (a + b)^P = a^P + b^P
+ * and c^P = c for any c from GF[P]. So it is defined by the matrix which rows are
+ * x^(iP) (mod poly), 0 <= i < n (the same matrix Berlekamp's test uses).
+ * This class builds the matrix once per modulus on first demand, then
+ * x^(P^(i+1)) is obtained from x^(P^i) with single matrix-vector product
+ * instead of new exponentiation.
+ */
+template<typename Field>
+class frobenius final {
+private:
+    basic_gfmod<Field> m_mod; ///< modulus context
+    basic_gfpoly<Field> m_xp; ///< x^P (mod poly)
+    std::vector<uintmax_t> m_matrix; ///< n x n matrix stored row by row, empty until required
+    std::vector<uintmax_t> m_buf; ///< matrix-vector product buffer
+
+    executor *m_exec; ///< splits large matrix operations between threads, if provided
+
+    /**
+     * Fills matrix rows [begin, end), row is x^(begin P) (mod poly) and mod is used for it only.
+     */
+    void fill_rows(const basic_gfmod<Field> &mod, basic_gfpoly<Field> row,
+                   const uintmax_t begin, const uintmax_t end) {
+        const auto n = mod.degree();
+        const auto P = mod.modulus().base();
+        for (uintmax_t i = begin; i < end; ++i) {
+            throw_if_stopped();
+            for (uintmax_t j = 0; j < row.size(); ++j) {
+                m_matrix[i * n + j] = row[j];
+            }
+            // row * x^P is a shift when P is less than degree, so reduction is cheap
+            if (P < n) {
+                row <<= P;
+                mod.reduce(row);
+            } else {
+                mod.mulmod_inplace(row, m_xp);
+            }
+        }
+    }
+
+    [[nodiscard]]
+    auto parallel() const -> bool {
+        return m_exec && m_exec->threads() > 1 && m_mod.degree() >= parallel_threshold;
+    }
+
+    void build_matrix() {
+        const auto n = m_mod.degree();
+        m_matrix.assign(n * n, 0);
+        if (!parallel()) {
+            fill_rows(m_mod, basic_gfpoly<Field>(m_mod.field(), 1), 0, n);
+            return;
+        }
+        // every thread starts its block of rows from x^(begin P) with own modulus context
+        m_exec->parallel_for(n, [this](const uintmax_t begin, const uintmax_t end) {
+            const basic_gfmod<Field> mod(m_mod);
+            fill_rows(mod, mod.x_powmod(biguint(mod.modulus().base()) * biguint(begin)), begin, end);
+        });
+    }
+
+    /**
+     * m_buf[begin, end) = sum g[i] * row(i)[begin, end).
+     */
+    void apply_columns(const basic_gfpoly<Field> &g, const uintmax_t begin, const uintmax_t end) {
+        const auto n = m_mod.degree();
+        const auto &field = m_mod.field();
+        const auto len = end - begin;
+        auto *const buf = m_buf.data() + begin;
+        const auto bound = lazy_bound(field);
+        if (bound < 2) {
+            for (uintmax_t i = 0; i < g.size(); ++i) {
+                if (g[i] != 0) {
+                    // res -= (-g[i]) * row(i)
+                    row_sub_mul(field, buf, m_matrix.data() + i * n + begin, field->neg(g[i]), len);
+                }
+            }
+            return;
+        }
+        // res += g[i] * row(i), reduced once per bound rows
+        uintmax_t pending = 0;
+        for (uintmax_t i = 0; i < g.size(); ++i) {
+            if (g[i] != 0) {
+                if (pending == bound) {
+                    reduce_range(field, buf, len);
+                    pending = 0;
+                }
+                row_add_mul_lazy(buf, m_matrix.data() + i * n + begin, g[i], len);
+                ++pending;
+            }
+        }
+        reduce_range(field, buf, len);
+    }
+
+public:
+    explicit
+    frobenius(const basic_gfpoly<Field> &poly) :
+        frobenius(basic_gfmod<Field>(poly)) {}
+
+    /**
+     * Shares precomputed modulus context, so it isn't built twice.
+     */
+    explicit
+    frobenius(basic_gfmod<Field> mod) :
+        m_mod(std::move(mod)),
+        m_xp(m_mod.x_powmod(m_mod.modulus().base())),
+        m_matrix(), m_buf(), m_exec(nullptr) {}
+
+    /**
+     * Large matrix construction and products are split between exec threads,
+     * nullptr makes them sequential. Executor must outlive the object.
+     */
+    void set_executor(executor *exec) {
+        m_exec = exec;
+    }
 
-    uintmax_t d = 0;
-    uintmax_t tmp = 0;
-    for (auto m = res.degree(); pow + m >= n; m = res.degree()) {
-        tmp = n - m, pow -= tmp, res <<= tmp;
-        d = (res == xn) ? (d) ? (d -= pow, pow %= d, 0) : pow : d;
-        res %= mod;
+    /**
+     * Returns normalized modulus.
+     */
+    [[nodiscard]]
+    auto modulus() const -> const basic_gfpoly<Field> & {
+        return m_mod.modulus();
     }
-    return res << pow;
+
+    /**
+     * Returns x^P (mod poly), no matrix is needed for it.
+     */
+    [[nodiscard]]
+    auto x_pow_p() const -> const basic_gfpoly<Field> & {
+        return m_xp;
+    }
+
+    /**
+     * Returns the matrix row x^(iP) (mod poly) of length deg(poly).
+     */
+    [[nodiscard]]
+    auto row(const uintmax_t i) -> const uintmax_t * {
+        if (m_matrix.empty()) {
+            build_matrix();
+        }
+        return m_matrix.data() + i * m_mod.degree();
+    }
+
+    /**
+     * Replaces g reduced modulo poly by g^P (mod poly), buffers are reused.
+     */
+    auto apply_inplace(basic_gfpoly<Field> &g) -> basic_gfpoly<Field> & {
+        throw_if_stopped();
+        if (m_matrix.empty()) {
+            build_matrix();
+        }
+        m_buf.assign(m_mod.degree(), 0);
+        if (parallel()) {
+            m_exec->parallel_for(m_mod.degree(), [this, &g](const uintmax_t begin, const uintmax_t end) {
+                apply_columns(g, begin, end);
+            });
+        } else {
+            apply_columns(g, 0, m_mod.degree());
+        }
+        return g = m_buf;
+    }
+
+    /**
+     * Returns g^P (mod poly) for g reduced modulo poly.
+     */
+    [[nodiscard]]
+    auto apply(basic_gfpoly<Field> g) -> basic_gfpoly<Field> {
+        apply_inplace(g);
+        return g;
+    }
+};
+
+/**
+ * Calculates (x^pow) % mod over GF[2] by binary exponentiation,
+ * squaring is cheap for packed polynomials and multiplication by x is a shift.
+ */
+[[nodiscard]]
+inline
+auto x_pow_mod(uintmax_t pow, const gf2poly &mod) -> gf2poly {
+    gf2poly res{1};
+    uintmax_t bit = 1;
+    while (bit <= pow / 2) {
+        bit <<= 1U;
+    }
+    for (; pow && bit; bit >>= 1U) {
+        throw_if_stopped();
+        count(counter::x_pow_steps);
+        res = res.square() % mod;
+        if (pow & bit) {
+            res <<= 1U;
+        }
+    }
+    return res % mod;
 }
 
 } // namespace detail
@@ -134,11 +631,126 @@ auto x_pow_mod(uintmax_t pow, const gfpoly &mod) -> gfpoly {
  * Then B - I is calculated and rank(B - I) is found. If rank(B - I) == deg(poly) - 1
  * then poly is irreducible, otherwise it is reducible. For rank calculation
  * matrix is reduced to a stepwise form and number of steps is calculated,
- * this number is equal to matrix rank.
- * TODO: change the way matrix rank is calculated to make algorithm faster.
+ * this number is equal to matrix rank. Matrix is kept as single row-major buffer
+ * of residues (bit rows for GF[2], see overload below) to avoid per-element overhead.
+ */
+template<typename Field>
+[[nodiscard]]
+auto is_irreducible_berlekamp(const basic_gfmod<Field> &mod, const unsigned threads = 1) -> bool {
+    const auto &poly = mod.modulus();
+    const auto n = poly.degree();
+
+    if (n == 0 || (poly[0] == 0 && n > 1)) {
+        return false;
+    }
+    if (n == 1) {
+        return true;
+    }
+
+    // builds matrix B - I and calculates it's rank
+    auto berlekampMatrixRank = [threads](const basic_gfmod<Field> &val) {
+        const auto n = val.degree();
+        const auto &field = val.field();
+        detail::frobenius<Field> frob(val);
+        // for large degrees matrix construction and row operations are split between threads
+        std::optional<executor> exec;
+        if (threads > 1 && n >= detail::parallel_threshold) {
+            exec.emplace(threads);
+            frob.set_executor(&*exec);
+        }
+        auto for_rows = [&exec](const uintmax_t begin, const uintmax_t end, const auto &fn) {
+            if (!exec) {
+                for (auto r = begin; r < end; ++r) {
+                    fn(r);
+                }
+                return;
+            }
+            exec->parallel_for(end - begin, [&](const uintmax_t b, const uintmax_t e) {
+                for (auto r = begin + b; r < begin + e; ++r) {
+                    fn(r);
+                }
+            });
+        };
+        // B[i,*] = x ^ ip (mod val), stored row by row as raw residues
+        std::vector<uintmax_t> B(frob.row(0), frob.row(0) + n * n);
+        for (uintmax_t i = 0; i < n; ++i) {
+            B[i * n + i] = field->sub(B[i * n + i], 1); // B - I
+        }
+
+        // reduces matrix to stepwise form, pivot row is normalized
+        // so elimination factor is the eliminated element itself;
+        // when lazy_bound allows, rows below pivot are reduced only when
+        // their elements are read or when bound eliminations are accumulated
+        const auto bound = detail::lazy_bound(field);
+        const bool lazy = bound >= 2;
+        uintmax_t i = 0, pending = 0;
+        for (uintmax_t k = 0; i < n && k < n; ++k) {
+            detail::throw_if_stopped();
+            if (lazy) {
+                const bool full = (pending == bound);
+                for_rows(i, n, [&](const uintmax_t r) {
+                    if (full) {
+                        detail::reduce_range(field, B.data() + r * n + k, n - k);
+                    } else {
+                        B[r * n + k] = field->reduce(B[r * n + k]);
+                    }
+                });
+                pending = full ? 0 : pending;
+            }
+            uintmax_t j = i;
+            while (j < n && B[j * n + k] == 0) {
+                ++j;
+            }
+            if (j == n) {
+                continue;
+            }
+            if (j != i) {
+                std::swap_ranges(B.begin() + j * n + k, B.begin() + (j + 1) * n, B.begin() + i * n + k);
+            }
+            auto *pivot = B.data() + i * n;
+            if (lazy) {
+                detail::reduce_range(field, pivot + k, n - k);
+            }
+            const auto inv = field->mul_inv(pivot[k]);
+            for (uintmax_t l = k; l < n; ++l) {
+                pivot[l] = field->mul(pivot[l], inv);
+            }
+            for_rows(i + 1, n, [&](const uintmax_t r) {
+                auto *curr = B.data() + r * n;
+                if (curr[k] && lazy) {
+                    detail::row_add_mul_lazy(curr + k, pivot + k, field->neg(curr[k]), n - k);
+                } else if (curr[k]) {
+                    detail::row_sub_mul(field, curr + k, pivot + k, curr[k], n - k);
+                }
+            });
+            pending += lazy;
+            ++i;
+        }
+        return i;
+    };
+
+    // algorithm begins here
+    auto d = detail::derivative(poly);
+    return !!d && gcd(poly, d).degree() == 0 &&
+        berlekampMatrixRank(mod) == poly.degree() - 1;
+}
+
+/**
+ * Berlekamp's irreducibility test, modulus context is built for poly.
+ */
+template<typename Field>
+[[nodiscard]]
+auto is_irreducible_berlekamp(const basic_gfpoly<Field> &poly, const unsigned threads = 1) -> bool {
+    return !poly.is_zero() && is_irreducible_berlekamp(basic_gfmod<Field>(poly), threads);
+}
+
+/**
+ * Berlekamp's irreducibility test for bit-packed polynomials over GF[2].
+ * Matrix B - I is stored as contiguous bit rows, so row operations are word XORs.
  */
 [[nodiscard]]
-auto is_irreducible_berlekamp(const gfpoly &poly) -> bool {
+inline
+auto is_irreducible_berlekamp(const gf2poly &poly) -> bool {
     if (poly.is_zero()) {
         return false;
     }
@@ -152,41 +764,42 @@ auto is_irreducible_berlekamp(const gfpoly &poly) -> bool {
     }
 
     // builds matrix B - I and calculates it's rank
-    auto berlekampMatrixRank = [](const gfpoly &val) {
-        uintmax_t i = 0, j = 0, k = 0, l = 0;
+    auto berlekampMatrixRank = [](const gf2poly &val) {
         const auto n = val.degree();
-        std::vector<std::vector<gfn>> B(n, std::vector<gfn>(n, gfn(val.field()))); // B = 0
-        for (i = 0; i < n; ++i) {
-            // B[i,*] = x ^ ip (mod val)
-            const auto poly = detail::x_pow_mod(i * val.base(), val);
-            for (j = 0, k = poly.degree(); j <= k; ++j) {
-                B[i][j] += poly[j];
-            }
-            B[i][i] -= 1; // B - I
+        const auto w = (n + 63) / 64;
+        std::vector<uint64_t> B(n * w, 0);
+        gf2poly row{1}; // x^0
+        for (uintmax_t i = 0; i < n; ++i) {
+            // B[i,*] = x ^ 2i (mod val)
+            const auto &words = row.value();
+            std::copy(words.begin(), words.end(), B.begin() + i * w);
+            B[i * w + i / 64] ^= uint64_t(1) << (i % 64); // B - I
+            row <<= 2U;
+            row %= val;
         }
 
         // reduces matrix to stepwise form
-        bool f = false;
-        gfn num(val.field());
-        for (i = k = 0; i < n && k < n; ++k) {
-            f = !!B[i][k];
+        uintmax_t i = 0;
+        for (uintmax_t k = 0; i < n && k < n; ++k) {
+            detail::throw_if_stopped();
+            const auto kw = k / 64;
+            const auto kb = uint64_t(1) << (k % 64);
+            uintmax_t j = i;
+            while (j < n && !(B[j * w + kw] & kb)) {
+                ++j;
+            }
+            if (j == n) {
+                continue;
+            }
+            if (j != i) {
+                std::swap_ranges(B.begin() + j * w, B.begin() + (j + 1) * w, B.begin() + i * w);
+            }
             for (j = i + 1; j < n; ++j) {
-                if (B[j][k]) {
-                    if (f) {
-                        num = B[j][k] / B[i][k];
-                        B[j][k] = 0;
-                        for (l = k + 1; l < n; ++l) {
-                            B[j][l] -= B[i][l] * num;
-                        }
-                    } else {
-                        for (l = k; l < n; ++l) {
-                            std::swap(B[i][l], B[j][l]);
-                        }
-                        f = true;
-                    }
+                if (B[j * w + kw] & kb) {
+                    detail::xor_row(B.data() + j * w + kw, B.data() + i * w + kw, w - kw);
                 }
             }
-            i += f;
+            ++i;
         }
         return i;
     };
@@ -203,11 +816,10 @@ auto is_irreducible_berlekamp(const gfpoly &poly) -> bool {
  * test for polynomials over finite Fields" by Panario, Pittel, Richmond and Viola.
  * Added common case checks as in Berlekamp's test above.
  */
+template<typename Field>
 [[nodiscard]]
-auto is_irreducible_rabin(const gfpoly &poly) -> bool {
-    if (poly.is_zero()) {
-        return false;
-    }
+auto is_irreducible_rabin(const basic_gfmod<Field> &mod, const unsigned threads = 1) -> bool {
+    const auto &poly = mod.modulus();
     const auto n = poly.degree();
 
     if (n == 0 || (poly[0] == 0 && n > 1)) {
@@ -236,31 +848,237 @@ auto is_irreducible_rabin(const gfpoly &poly) -> bool {
         return list;
     };
 
-    auto P = poly.base();
+    // list holds n / d for ascending primes d, reversed it allows computing
+    // all x^(P^i) in one Frobenius chain
     auto list = factorize(n);
-    gfpoly tmp(poly.field()), x = gfpoly(poly.field(), {0, 1});
-    for (auto i: list) {
-        tmp = detail::x_pow_mod(detail::integer_power(P, i), poly) - x;
-        if (tmp.is_zero() || gcd(poly, tmp).degree() > 0) {
+    std::reverse(list.begin(), list.end());
+    detail::frobenius<Field> frob(mod);
+    // for large degrees gcds run concurrently with the chain, which uses the rest of threads
+    std::optional<executor> exec;
+    std::vector<std::future<bool>> factors;
+    const bool parallel = threads > 1 && n >= detail::parallel_threshold;
+    if (parallel) {
+        exec.emplace(threads - 1);
+        frob.set_executor(&*exec);
+    }
+    basic_gfpoly<Field> tmp(poly.field()), x = basic_gfpoly<Field>(poly.field(), {0, 1});
+    basic_gfpoly<Field> xpi = frob.x_pow_p(); // x^(P^i)
+    uintmax_t i = 1;
+    for (auto d: list) {
+        for (; i < d; ++i) {
+            frob.apply_inplace(xpi);
+        }
+        tmp = xpi;
+        tmp -= x;
+        if (tmp.is_zero()) {
+            return false;
+        }
+        if (parallel) {
+            factors.emplace_back(std::async(std::launch::async, [&poly, tmp]() {
+                return gcd(poly, tmp).degree() > 0;
+            }));
+        } else if (gcd(poly, tmp).degree() > 0) {
             return false;
         }
     }
 
-    tmp = detail::x_pow_mod(detail::integer_power(P, n), poly) - x;
-    return tmp.is_zero();
+    for (; i < n; ++i) {
+        frob.apply_inplace(xpi);
+    }
+    tmp = xpi;
+    tmp -= x;
+    bool irreducible = tmp.is_zero();
+    for (auto &f : factors) {
+        irreducible = !f.get() && irreducible;
+    }
+    return irreducible;
+}
+
+/**
+ * Rabin's irreducibility test, modulus context is built for poly.
+ */
+template<typename Field>
+[[nodiscard]]
+auto is_irreducible_rabin(const basic_gfpoly<Field> &poly, const unsigned threads = 1) -> bool {
+    return !poly.is_zero() && is_irreducible_rabin(basic_gfmod<Field>(poly), threads);
+}
+
+/**
+ * Part of distinct degree factorization: monic product of all irreducible factors
+ * of the same degree (repeated factors are included with their multiplicity).
+ */
+template<typename Field>
+struct distinct_degree_part {
+    uintmax_t degree; ///< degree of each irreducible factor
+    basic_gfpoly<Field> factor; ///< product of the factors
+};
+
+namespace detail {
+
+/**
+ * Computes distinct degree factorization of the normalized modulus f.
+ * x^(P^i) (mod f) is obtained from x^(P^(i-1)) with one Frobenius step as in Ben-Or's
+ * test, part of degree i is gcd(g, x^(P^i) - x) where g is the cofactor of parts found,
+ * g has no factors of degree below i, so when deg(g) < 2i it is irreducible.
+ * Repeated factors are removed by dividing g while it shares factors with the part.
+ * In early mode stops at the first part of degree below deg(f) (which proves f reducible),
+ * then for large degrees gcd of each step runs concurrently with the next Frobenius step
+ * and the rest of threads split the steps themselves.
+ */
+template<typename Field>
+[[nodiscard]]
+auto distinct_degree_chain(const basic_gfmod<Field> &mod, const bool early, const unsigned threads = 1)
+-> std::vector<distinct_degree_part<Field>> {
+    const auto &field = mod.field();
+    std::vector<distinct_degree_part<Field>> res;
+    auto rest = mod.modulus();
+    if (rest.degree() == 0) {
+        return res;
+    }
+
+    auto monic = [&field](basic_gfpoly<Field> &g) {
+        if (g[g.degree()] != 1) {
+            g *= field->mul_inv(g[g.degree()]);
+        }
+    };
+
+    frobenius<Field> frob(mod);
+    const basic_gfpoly<Field> x(field, {0, 1});
+    basic_gfpoly<Field> tmp(field), xpi = frob.x_pow_p(); // x^(P^i)
+    if (early && threads > 1 && rest.degree() >= parallel_threshold) {
+        executor exec(threads - 1);
+        frob.set_executor(&exec);
+        // rest isn't changed in early mode, gcd of step i - 1 is checked after step i
+        std::future<basic_gfpoly<Field>> prev;
+        uintmax_t i = 1;
+        auto found = [&]() {
+            auto g = prev.get();
+            if (g.degree() == 0) {
+                return false;
+            }
+            monic(g);
+            res.push_back({i - 1, std::move(g)});
+            return true;
+        };
+        for (; rest.degree() >= 2 * i; ++i) {
+            if (i > 1) {
+                frob.apply_inplace(xpi);
+            }
+            tmp = xpi;
+            tmp -= x;
+            if (prev.valid() && found()) {
+                return res;
+            }
+            if (tmp.is_zero()) {
+                res.push_back({i, rest});
+                return res;
+            }
+            prev = std::async(std::launch::async, [&rest, tmp]() { return gcd(rest, tmp); });
+        }
+        if (prev.valid() && found()) {
+            return res;
+        }
+        const auto d = rest.degree();
+        res.push_back({d, std::move(rest)});
+        return res;
+    }
+    for (uintmax_t i = 1; rest.degree() >= 2 * i; ++i) {
+        if (i > 1) {
+            frob.apply_inplace(xpi);
+        }
+        tmp = xpi;
+        tmp -= x;
+        auto g = tmp.is_zero() ? rest : gcd(rest, tmp);
+        if (g.degree() == 0) {
+            continue;
+        }
+        monic(g);
+        distinct_degree_part<Field> part{i, g};
+        rest /= g;
+        while (rest.degree() >= i) {
+            g = gcd(rest, g);
+            if (g.degree() == 0) {
+                break;
+            }
+            monic(g);
+            rest /= g;
+            part.factor *= g;
+        }
+        res.emplace_back(std::move(part));
+        if (early) {
+            return res;
+        }
+    }
+    if (rest.degree() > 0) {
+        monic(rest);
+        const auto d = rest.degree();
+        res.push_back({d, std::move(rest)});
+    }
+    return res;
+}
+
+} // namespace detail
+
+/**
+ * Returns distinct degree factorization of polynomial given by its modulus context,
+ * parts are ordered by degree. It is built on the same Frobenius chain as Ben-Or's test,
+ * the polynomial is irreducible if there is a single part of degree deg(poly).
+ */
+template<typename Field>
+[[nodiscard]]
+auto distinct_degree_factor(const basic_gfmod<Field> &mod) -> std::vector<distinct_degree_part<Field>> {
+    return detail::distinct_degree_chain(mod, false);
+}
+
+/**
+ * Returns distinct degree factorization of non-zero polynomial.
+ */
+template<typename Field>
+[[nodiscard]]
+auto distinct_degree_factor(const basic_gfpoly<Field> &poly) -> std::vector<distinct_degree_part<Field>> {
+    if (poly.is_zero()) {
+        throw std::domain_error("polynomial must be non-zero");
+    }
+    return distinct_degree_factor(basic_gfmod<Field>(poly));
+}
+
+/**
+ * Returns degrees of all irreducible factors of polynomial given by its modulus context
+ * in non-decreasing order, repeated factors are counted with multiplicity.
+ */
+template<typename Field>
+[[nodiscard]]
+auto factor_degrees(const basic_gfmod<Field> &mod) -> std::vector<uintmax_t> {
+    std::vector<uintmax_t> res;
+    for (const auto &part : distinct_degree_factor(mod)) {
+        res.insert(res.end(), part.factor.degree() / part.degree, part.degree);
+    }
+    return res;
+}
+
+/**
+ * Returns degrees of all irreducible factors of non-zero polynomial.
+ */
+template<typename Field>
+[[nodiscard]]
+auto factor_degrees(const basic_gfpoly<Field> &poly) -> std::vector<uintmax_t> {
+    if (poly.is_zero()) {
+        throw std::domain_error("polynomial must be non-zero");
+    }
+    return factor_degrees(basic_gfmod<Field>(poly));
 }
 
 /**
  * This function implements Ben-Or's irreducibility test for polynomials over Galois field.
  * Alghoritm's pseudocode is provided in article "Tests and constructions of
  * irreducible polynomials over finite fields" by Gao and Panario.
- * Added common case checks as in Berlekamp's test above.
+ * Added common case checks as in Berlekamp's test above. The test is the early
+ * mode of distinct degree factorization.
  */
+template<typename Field>
 [[nodiscard]]
-auto is_irreducible_benor(const gfpoly &poly) -> bool {
-    if (poly.is_zero()) {
-        return false;
-    }
+auto is_irreducible_benor(const basic_gfmod<Field> &mod, const unsigned threads = 1) -> bool {
+    const auto &poly = mod.modulus();
     const auto n = poly.degree();
 
     if (n == 0 || (poly[0] == 0 && n > 1)) {
@@ -270,126 +1088,485 @@ auto is_irreducible_benor(const gfpoly &poly) -> bool {
         return true;
     }
 
-    auto P = poly.base();
-    gfpoly tmp(poly.field()), x = gfpoly(poly.field(), {0, 1});
-    for (uintmax_t m = n / 2, i = 1; i <= m; ++i) {
-        tmp = detail::x_pow_mod(detail::integer_power(P, i), poly) - x;
-        if (tmp.is_zero() || gcd(poly, tmp).degree() > 0) {
-            return false;
-        }
-    }
-    return true;
+    const auto parts = detail::distinct_degree_chain(mod, true, threads);
+    return parts.size() == 1 && parts.front().degree == n;
+}
+
+/**
+ * Ben-Or's irreducibility test, modulus context is built for poly.
+ */
+template<typename Field>
+[[nodiscard]]
+auto is_irreducible_benor(const basic_gfpoly<Field> &poly, const unsigned threads = 1) -> bool {
+    return !poly.is_zero() && is_irreducible_benor(basic_gfmod<Field>(poly), threads);
 }
 
 /**
- * This function performs quickest irreducibility test, defined by benchmark results.
- * TODO: implement Distinct Degree Factorization algorithm, find out cases then it is fastest.
+ * This function performs quickest irreducibility test for polynomials over GF[2].
  */
 [[nodiscard]]
 inline
-auto is_irreducible(const gfpoly &poly) -> bool {
-    switch (poly.base()) {
-    case 2: return is_irreducible_berlekamp(poly);
-    default: return is_irreducible_benor(poly);
+auto is_irreducible(const gf2poly &poly) -> bool {
+    return is_irreducible_berlekamp(poly);
+}
+
+namespace detail {
+
+/**
+ * Sieve checks roots by Horner evaluation at every element of the field
+ * when base doesn't exceed this value. Could be changed before checks are started.
+ */
+inline uintmax_t sieve_roots_max = 64;
+
+/**
+ * Upper bound for degree of the product of small irreducible polynomials used by sieve.
+ * Product remainder costs deg(product) * deg(poly), so product is also limited by
+ * sieve_product_ratio * deg(poly), otherwise it is more expensive than the first steps
+ * of the full test finding the same factors.
+ */
+inline uintmax_t sieve_product_degree = 512;
+inline uintmax_t sieve_product_ratio = 4;
+
+/**
+ * Products of monic irreducible polynomials over GF[P]: prefix[k] holds the product of
+ * all of them with degree 2..k, while its degree doesn't exceed sieve_product_degree.
+ * prefix[0] and prefix[1] are empty.
+ */
+struct sieve_product {
+    std::vector<std::vector<uintmax_t>> prefix;
+};
+
+/**
+ * Returns sieve_product for the field, it is computed on first demand and cached
+ * per field base. Returned reference stays valid until program termination.
+ */
+template<typename Field>
+[[nodiscard]]
+auto small_irreducibles(const Field &field) -> const sieve_product & {
+    static std::mutex mutex;
+    static std::map<std::pair<uintmax_t, uintmax_t>, sieve_product> cache;
+    const std::lock_guard<std::mutex> lock(mutex);
+    const auto P = field->base();
+    const auto key = std::make_pair(P, sieve_product_degree);
+    auto it = cache.find(key);
+    if (it != cache.end()) {
+        return it->second;
+    }
+
+    sieve_product res{std::vector<std::vector<uintmax_t>>(2)};
+    basic_gfpoly<Field> prod(field, 1), factor(field);
+    for (uintmax_t d = 2;; ++d) {
+        // irreducibles of degree d have total degree at most P^d
+        if (P > sieve_product_degree || biguint::power(P, d) > sieve_product_degree - prod.degree()) {
+            break;
+        }
+        std::vector<uintmax_t> data(d + 1, 0);
+        data[d] = 1;
+        for (bool next = true; next;) {
+            factor = data;
+            if (is_irreducible_benor(factor)) {
+                prod *= factor;
+            }
+            // next monic polynomial of degree d, lower coefficient goes first
+            uintmax_t i = 0;
+            for (; i < d && ++data[i] == P; ++i) {
+                data[i] = 0;
+            }
+            next = (i < d);
+        }
+        std::vector<uintmax_t> coef(prod.size());
+        for (uintmax_t i = 0; i < prod.size(); ++i) {
+            coef[i] = prod[i];
+        }
+        res.prefix.emplace_back(std::move(coef));
     }
+    return cache.emplace(key, std::move(res)).first->second;
 }
 
+} // namespace detail
+
 /**
- * This function implements primitivity test for polynomials over Galois field.
- * Alghoritm is fully described in article "Primitive polynomials over finite
- * fields" by Hansen and Mullen. Added common case checks as in Berlekamp's test above.
+ * Cheap pre-filter for irreducibility tests. Returns true when polynomial certainly
+ * has a factor of small degree, and so is reducible. Candidate is checked for
+ * roots by Horner evaluation (for small bases), then gcd with the precomputed product
+ * of small irreducibles (see detail::small_irreducibles) is found. False result
+ * means nothing, full test is still required.
  */
+template<typename Field>
 [[nodiscard]]
-auto is_primitive_definition(const gfpoly &poly) -> bool {
-    if (poly.is_zero()) {
+auto has_small_factor(const basic_gfmod<Field> &mod) -> bool {
+    const auto &poly = mod.modulus();
+    const auto &field = poly.field();
+    const auto n = poly.degree();
+    if (n < 2) {
         return false;
     }
-    const auto n = poly.degree();
+    if (poly[0] == 0) {
+        return true;
+    }
 
-    if (n == 0 || (poly[0] == 0 && n > 1)) {
+    if (field->base() <= detail::sieve_roots_max) {
+        for (uintmax_t a = 1; a < field->base(); ++a) {
+            if (poly.eval(a) == 0) {
+                return true;
+            }
+        }
+    }
+
+    // polynomials of degree 2 and 3 are reducible only if they have roots;
+    // products are cached per base, which doesn't identify extension field
+    if (n < 4 || !detail::integer_residues(field)) {
         return false;
     }
-    if (n == 1 && poly[0] == 0) {
-        return true;
-    } // val = k * x + 0
+    const auto &prefix = detail::small_irreducibles(field).prefix;
+    uintmax_t k = 1;
+    while (k + 1 < prefix.size() && prefix[k + 1].size() <= detail::sieve_product_ratio * n) {
+        ++k;
+    }
+    if (k < 2) {
+        return false;
+    }
+    basic_gfpoly<Field> rem(field, prefix[k]);
+    mod.reduce(rem);
+    if (rem.is_zero()) {
+        // poly is product of distinct small irreducibles, it is one of them only if small
+        return n > k;
+    }
+    return gcd(poly, rem).degree() > 0;
+}
 
-    // this algorithm is defined only for normalized polynomials
-    const auto npoly = poly / poly[n];
+template<typename Field>
+[[nodiscard]]
+auto has_small_factor(const basic_gfpoly<Field> &poly) -> bool {
+    return !poly.is_zero() && has_small_factor(basic_gfmod<Field>(poly));
+}
 
-    // degenerate case
-    auto P = npoly.base();
-    if (P == 2 && npoly == gfpoly(npoly.field(), {1, 1})) {
+namespace detail {
+
+/**
+ * Runs the test chosen by the dispatcher, Berlekamp's one over GF[2] is the packed one.
+ */
+template<typename Field>
+[[nodiscard]]
+auto run_irreducible(const basic_gfmod<Field> &mod, const irreducible_test test, const unsigned threads) -> bool {
+    switch (test) {
+    case irreducible_test::berlekamp:
+        return (mod.modulus().base() == 2) ?
+               is_irreducible_berlekamp(gf2poly(mod.modulus())) : is_irreducible_berlekamp(mod, threads);
+    case irreducible_test::rabin: return is_irreducible_rabin(mod, threads);
+    default: return is_irreducible_benor(mod, threads);
+    }
+}
+
+} // namespace detail
+
+/**
+ * This function performs quickest irreducibility test: the one with the least cost
+ * for the base and degree in the table set by set_irreducible_costs (see cost_table),
+ * cost_table::builtin() by default. Tests of large degree are split between threads
+ * (packed GF[2] test is sequential).
+ */
+template<typename Field>
+[[nodiscard]]
+auto is_irreducible(const basic_gfmod<Field> &mod, const unsigned threads = 1) -> bool {
+    const auto &poly = mod.modulus();
+    const auto choice = detail::pick_irreducible(poly.base(), poly.degree());
+    if (choice.sieve && has_small_factor(mod)) {
         return false;
     }
+    return detail::run_irreducible(mod, choice.test, threads);
+}
 
-    auto mp = gfn(npoly.field(), npoly[0]);
-    mp = (n % 2) ? -mp : mp;
+template<typename Field>
+[[nodiscard]]
+auto is_irreducible(const basic_gfpoly<Field> &poly, const unsigned threads = 1) -> bool {
+    if (poly.is_zero()) {
+        return false;
+    }
+    const auto choice = detail::pick_irreducible(poly.base(), poly.degree());
+    if (poly.base() == 2 && choice.test == irreducible_test::berlekamp && !choice.sieve) {
+        // packed test needs no modulus context
+        return is_irreducible_berlekamp(gf2poly(poly));
+    }
+    return is_irreducible(basic_gfmod<Field>(poly), threads);
+}
 
-    // returns list of distinct prime divisors of n except 1 and n if it's prime
-    auto factorize = [](uintmax_t n) {
-        std::vector<uintmax_t> list;
-        const auto begin = n;
-        for (uintmax_t d = 2; d * d <= n; ++d) {
-            if (n % d) {
-                continue;
+/**
+ * Irreducibility test preceded by has_small_factor sieve, the test is chosen
+ * the same way as by is_irreducible. Pays off in exhaustive sweeps, where most
+ * of candidates have small factors.
+ */
+template<typename Field>
+[[nodiscard]]
+auto is_irreducible_sieved(const basic_gfmod<Field> &mod, const unsigned threads = 1) -> bool {
+    const auto &poly = mod.modulus();
+    return !has_small_factor(mod) &&
+           detail::run_irreducible(mod, detail::pick_irreducible(poly.base(), poly.degree()).test, threads);
+}
+
+template<typename Field>
+[[nodiscard]]
+auto is_irreducible_sieved(const basic_gfpoly<Field> &poly, const unsigned threads = 1) -> bool {
+    return !poly.is_zero() && is_irreducible_sieved(basic_gfmod<Field>(poly), threads);
+}
+
+/**
+ * Registers known prime divisors of P^n - 1 (Cunningham tables list them for small P),
+ * primitivity test takes them out before Pollard's rho, which can't find divisors
+ * of more than about 60 bits in reasonable time. Primes are given in decimal, throws
+ * std::invalid_argument if some of them isn't prime. Contexts built before are not affected.
+ */
+inline
+void register_prime_divisors(const std::vector<std::string> &primes) {
+    for (const auto &p : primes) {
+        detail::known_primes::instance().add(detail::biguint::parse(p));
+    }
+}
+
+/**
+ * Everything primitivity test needs for polynomials of degree n over GF[P], which
+ * is the same for all the candidates: prime divisors of P - 1 (leading coefficient
+ * of x^r must be primitive element of GF[P]), r = (P^n - 1) / (P - 1) and its prime
+ * divisors q. All x^(r / q) are computed from single x^m, m = r / prod(q), by splitting
+ * the primes in halves: node holding x^(r / prod(Q)) passes its power by the product
+ * of the right half to the left half and vice versa, so the cost is
+ * O(log(r) log(k)) modular squarings for k primes instead of O(k log(r)).
+ * Exponents of all the nodes are precomputed. Use primitivity_context::cached
+ * to share contexts between checks and threads.
+ */
+class primitivity_context final {
+private:
+    uintmax_t m_base;
+    uintmax_t m_degree;
+    std::vector<uintmax_t> m_order_cofactors; ///< (P - 1) / q for primes q dividing P - 1
+    detail::biguint m_r; ///< (P^n - 1) / (P - 1)
+    std::vector<detail::biguint> m_primes; ///< sorted prime divisors of r
+    detail::biguint m_top; ///< r / prod(primes)
+    std::vector<detail::biguint> m_splits; ///< products of halves, in order the split consumes them
+    bool m_pow_leaf; ///< x^r is obtained from x^(r / q) for the smallest q, not by x_powmod
+
+    /**
+     * Appends exponents of the split of primes [lo, hi) in depth-first order:
+     * product of the right half, exponents of the left half, product of the left
+     * half, exponents of the right one.
+     */
+    void build(const std::size_t lo, const std::size_t hi) {
+        if (hi - lo < 2) {
+            return;
+        }
+        const auto mid = (lo + hi) / 2;
+        const auto product = [this](std::size_t first, const std::size_t last) {
+            detail::biguint res(1);
+            for (; first < last; ++first) {
+                res *= m_primes[first];
             }
-            list.emplace_back(d);
-            while (n % d == 0) {
-                n /= d;
+            return res;
+        };
+        m_splits.push_back(product(mid, hi));
+        build(lo, mid);
+        m_splits.push_back(product(lo, mid));
+        build(mid, hi);
+    }
+
+    /**
+     * Receives val = x^(r / prod(primes[lo, hi))), returns false if x^(r / q) is
+     * constant for some q from the range. Sets leaf to x^(r / primes[0]).
+     */
+    template<typename Field>
+    auto split(const basic_gfmod<Field> &mod, basic_gfpoly<Field> val,
+               const std::size_t lo, const std::size_t hi, std::size_t &next,
+               basic_gfpoly<Field> &leaf) const -> bool {
+        if (hi - lo == 1) {
+            if (val.is_zero() || val.degree() == 0) {
+                return false;
             }
+            if (lo == 0) {
+                leaf = std::move(val);
+            }
+            return true;
         }
-        if (n != 1 && n != begin) {
-            list.emplace_back(n);
+        const auto mid = (lo + hi) / 2;
+        if (!split(mod, mod.powmod(val, m_splits[next++]), lo, mid, next, leaf)) {
+            return false;
         }
-        return list;
-    };
+        return split(mod, mod.powmod(std::move(val), m_splits[next++]), mid, hi, next, leaf);
+    }
 
-    if (P > 2) {
-        const auto p = P - 1;
-        auto list = (p == 2) ? std::vector<uintmax_t>{2} : factorize(p);
-        auto m = list.size() - 1;
-        auto tmp = mp;
-        for (uint32_t i = 1; i <= p; ++i, tmp *= mp) {
-            if (i != p / list[m]) {
-                continue;
-            }
-            if (tmp == 1) {
-                return false;
-            }
-            if (m == 0) {
-                break;
+public:
+    primitivity_context(const uintmax_t P, const uintmax_t n) :
+        m_base(P), m_degree(n), m_order_cofactors(),
+        m_r((detail::biguint::power(P, n) - 1) / (P - 1)),
+        m_primes(), m_top(m_r), m_splits(), m_pow_leaf(false) {
+        if (n == 0) {
+            throw std::invalid_argument("degree must be positive");
+        }
+        m_primes = detail::primitive_factors(P, n);
+        if (P > 2) {
+            for (const auto &q : detail::prime_divisors(detail::biguint(P - 1))) {
+                m_order_cofactors.push_back((P - 1) / q.value());
             }
-            m -= 1;
         }
+        for (const auto &q : m_primes) {
+            m_top /= q;
+        }
+        build(0, m_primes.size());
+        // power of the leaf costs about a multiplication more per bit than x_powmod
+        m_pow_leaf = !m_primes.empty() && 2 * m_primes.front().bit_length() < m_r.bit_length();
     }
 
-    uintmax_t r = (detail::integer_power(P, n) - 1) / (P - 1);
-    auto tmp = detail::x_pow_mod(r, poly) - mp;
-    if (tmp) {
-        return false;
+    /**
+     * Returns context for P and n, it is created on first demand and cached,
+     * returned reference stays valid until program termination. Contexts of
+     * different P and n are built concurrently, factorization throws
+     * operation_cancelled once stop is requested (see detail::once_cache).
+     */
+    [[nodiscard]]
+    static
+    auto cached(const uintmax_t P, const uintmax_t n) -> const primitivity_context & {
+        static detail::once_cache<std::pair<uintmax_t, uintmax_t>, primitivity_context> cache;
+        return cache.get(std::make_pair(P, n), [P, n]() { return primitivity_context(P, n); });
     }
 
-    auto list3 = factorize(r);
-    const auto m = list3.size();
-    for (size_t i = 0; i < m; ++i) {
-        tmp = detail::x_pow_mod(r / list3[i], npoly);
-        if (tmp.is_zero() || tmp.degree() == 0) {
+    [[nodiscard]]
+    auto base() const -> uintmax_t {
+        return m_base;
+    }
+
+    [[nodiscard]]
+    auto degree() const -> uintmax_t {
+        return m_degree;
+    }
+
+    /**
+     * Returns prime divisors of r = (P^n - 1) / (P - 1).
+     */
+    [[nodiscard]]
+    auto primes() const -> const std::vector<detail::biguint> & {
+        return m_primes;
+    }
+
+    /**
+     * Primitivity test of polynomial given by its modulus context, which base
+     * and degree must be the ones of the context.
+     */
+    template<typename Field>
+    [[nodiscard]]
+    auto is_primitive(const basic_gfmod<Field> &mod) const -> bool {
+        const auto &npoly = mod.modulus(); // this algorithm is defined only for normalized polynomials
+        const auto n = npoly.degree();
+        const auto P = npoly.base();
+        if (P != m_base || n != m_degree) {
+            throw std::invalid_argument("polynomial doesn't match primitivity context");
+        }
+
+        if (n == 0 || (npoly[0] == 0 && n > 1)) {
+            return false;
+        }
+        if (n == 1 && npoly[0] == 0) {
+            return true;
+        } // val = k * x + 0
+        // degenerate case
+        if (P == 2 && npoly == basic_gfpoly<Field>(npoly.field(), {1, 1})) {
+            return false;
+        }
+
+        // elements are only used locally, so non-owning field handle is enough
+        auto mp = basic_gfn<field_view_t<Field>>(field_view(npoly.field()), npoly[0]);
+        mp = (n % 2) ? -mp : mp;
+        // mp must be a primitive element of GF[P]
+        for (const auto c : m_order_cofactors) {
+            if (pow(mp, c) == 1) {
+                return false;
+            }
+        }
+
+        basic_gfpoly<Field> leaf(npoly.field());
+        std::size_t next = 0;
+        if (!m_primes.empty() && !split(mod, mod.x_powmod(m_top), 0, m_primes.size(), next, leaf)) {
             return false;
         }
+        // x^r, it's constant for any irreducible polynomial
+        auto xr = m_pow_leaf ? mod.powmod(std::move(leaf), m_primes.front()) : mod.x_powmod(m_r);
+        return !(xr - mp.value());
     }
+};
 
-    return true;
+/**
+ * This function implements primitivity test for polynomials over Galois field.
+ * Alghoritm is fully described in article "Primitive polynomials over finite
+ * fields" by Hansen and Mullen. Added common case checks as in Berlekamp's test above.
+ * Context of the base and degree is cached (see primitivity_context).
+ */
+template<typename Field>
+[[nodiscard]]
+auto is_primitive_definition(const basic_gfmod<Field> &mod) -> bool {
+    const auto &poly = mod.modulus();
+    if (poly.degree() == 0) {
+        return false;
+    }
+    return primitivity_context::cached(poly.base(), poly.degree()).is_primitive(mod);
+}
+
+/**
+ * Primitivity test by definition, modulus context is built for poly.
+ */
+template<typename Field>
+[[nodiscard]]
+auto is_primitive_definition(const basic_gfpoly<Field> &poly) -> bool {
+    return !poly.is_zero() && is_primitive_definition(basic_gfmod<Field>(poly));
+}
+
+/**
+ * Quickest primitivity test for polynomial given by its modulus context,
+ * the context is shared by irreducibility and primitivity tests.
+ */
+template<typename Field>
+[[nodiscard]]
+inline
+auto is_primitive(const basic_gfmod<Field> &mod) -> bool {
+    return is_irreducible(mod) ? is_primitive_definition(mod) : false;
 }
 
 /**
  * This function performs quickest primitivity test, defined by benchmark results.
  */
+template<typename Field>
 [[nodiscard]]
 inline
-auto is_primitive(const gfpoly &val) -> bool {
-    return is_irreducible(val) ? is_primitive_definition(val) : false;
+auto is_primitive(const basic_gfpoly<Field> &val) -> bool {
+    return !val.is_zero() && is_primitive(basic_gfmod<Field>(val));
 }
 
+namespace detail {
+
+/**
+ * Batches over fields of larger base are checked polynomial by polynomial,
+ * otherwise polynomials with roots are rejected for the whole batch at once.
+ */
+inline uintmax_t batch_root_points = 64;
+
+/**
+ * Returns true for polynomials of the batch, which have no roots in GF[P].
+ * The rest have linear factors, so they are reducible if their degree exceeds 1.
+ * All P points are evaluated for the whole batch at once.
+ */
+template<typename Field>
+[[nodiscard]]
+auto root_filter(const basic_gfpoly_batch<Field> &batch) -> std::vector<bool> {
+    std::vector<bool> pass(batch.count(), true);
+    for (uintmax_t x = 0; x < batch.field()->base(); ++x) {
+        const auto val = batch.eval(x);
+        for (uintmax_t r = 0; r < batch.count(); ++r) {
+            if (!val[r]) {
+                pass[r] = false;
+            }
+        }
+    }
+    return pass;
+}
+
+} // namespace detail
+
 namespace multithread {
 
 struct check_result {
@@ -405,7 +1582,8 @@ enum class irreducible_method {
     berlekamp, ///< Berlekam's test
     rabin, ///< Rabin's test
     benor, ///< Ben-Or's test
-    recommended, ///< fastest test
+    recommended, ///< the cheapest test by cost table (see cost_table), possibly sieved
+    sieve, ///< small factors sieve followed by the cheapest test
 };
 
 /**
@@ -417,48 +1595,162 @@ enum class primitive_method {
     recommended, ///< оптимальный алгоритм
 };
 
-using polychecker = pipeline<gfpoly, check_result>;
+template<typename Field>
+using basic_polychecker = pipeline<basic_gfpoly<Field>, check_result>;
+
+using polychecker = basic_polychecker<gf>;
+
+/**
+ * Performs the tests selected for single polynomial.
+ * In case nil method is selected - the result is true.
+ * Irreducibility tests of large degree use up to threads threads (see detail::parallel_threshold).
+ */
+template<typename Field>
+[[nodiscard]]
+auto check(const basic_gfpoly<Field> &poly,
+           irreducible_method irr_meth, primitive_method prim_meth,
+           const unsigned threads = 1) -> check_result {
+    const detail::stats_timer latency(counter::checks, true);
+    auto result = check_result{true, true};
+    if (poly.is_zero()) {
+        result.irreducible = (irr_meth == irreducible_method::nil);
+        result.primitive = (prim_meth == primitive_method::nil);
+        return result;
+    }
+    // single modulus context is shared by all the tests
+    const basic_gfmod<Field> mod(poly);
+    // the same choice as of is_irreducible, stats tell rejections by sieve and by the test apart
+    const auto choice = detail::pick_irreducible(poly.base(), poly.degree());
+    constexpr counter reasons[] = {counter::rejected_berlekamp, counter::rejected_rabin, counter::rejected_benor};
+    auto reason = reasons[static_cast<unsigned>(choice.test)];
+
+    switch (irr_meth) {
+    case irreducible_method::recommended:
+        if (choice.sieve && has_small_factor(mod)) {
+            result.irreducible = false;
+            reason = counter::rejected_sieve;
+        } else {
+            result.irreducible = detail::run_irreducible(mod, choice.test, threads);
+        }
+        break;
+    case irreducible_method::berlekamp:
+        result.irreducible = is_irreducible_berlekamp(mod, threads);
+        reason = counter::rejected_berlekamp;
+        break;
+    case irreducible_method::rabin:
+        result.irreducible = is_irreducible_rabin(mod, threads);
+        reason = counter::rejected_rabin;
+        break;
+    case irreducible_method::benor:
+        result.irreducible = is_irreducible_benor(mod, threads);
+        reason = counter::rejected_benor;
+        break;
+    case irreducible_method::sieve:
+        // the same as is_irreducible_sieved
+        if (has_small_factor(mod)) {
+            result.irreducible = false;
+            reason = counter::rejected_sieve;
+        } else {
+            result.irreducible = detail::run_irreducible(mod, choice.test, threads);
+        }
+        break;
+    default:; // irreducible_method::nil
+    }
+    if (!result.irreducible) {
+        detail::count((poly.degree() > 1 && poly[0] == 0) ? counter::rejected_constant : reason);
+    }
+
+    switch (prim_meth) {
+    case primitive_method::recommended:
+        result.primitive = result.irreducible ?
+                           is_primitive(mod) : false;
+        break;
+    case primitive_method::definition:
+        result.primitive = result.irreducible ?
+                           is_primitive_definition(mod) : false;
+        break;
+    default:; // primitive_method::nil
+    }
+    if (result.irreducible && !result.primitive) {
+        detail::count(counter::rejected_primitive);
+    }
+
+    return result;
+}
+
+/**
+ * Performs the tests selected for every polynomial of the batch. Results are the same
+ * as of single checks. Berlekamp's and Rabin's tests have no early exit, so for small
+ * bases polynomials are first filtered by detail::root_filter for the whole batch at once
+ * and only those passing it are tested separately (other tests find roots themselves).
+ */
+template<typename Field>
+[[nodiscard]]
+auto check(const basic_gfpoly_batch<Field> &batch,
+           irreducible_method irr_meth, primitive_method prim_meth) -> std::vector<check_result> {
+    std::vector<bool> pass(batch.count(), true);
+    const bool filtered = (irr_meth == irreducible_method::berlekamp || irr_meth == irreducible_method::rabin);
+    if (filtered && batch.count() > 1 && batch.degree() > 1 &&
+        batch.field()->base() <= detail::batch_root_points && batch.is_exact()) {
+        pass = detail::root_filter(batch);
+    }
+    std::vector<check_result> res(batch.count(), check_result{false, false});
+    for (uintmax_t r = 0; r < batch.count(); ++r) {
+        if (pass[r]) {
+            res[r] = check(batch.row(r), irr_meth, prim_meth);
+        } else {
+            detail::count(counter::checks);
+            detail::count(counter::rejected_root_filter);
+            res[r].primitive = (prim_meth == primitive_method::nil);
+        }
+    }
+    return res;
+}
 
 /**
  * Creates payload_fn for irrpoly::multithread::pipeline.
  * In case nil method is selected - the result is true.
+ * Field type defaults to gf, pass gf_static<P> to check polynomials over static field.
  */
+template<typename Field = gf>
 [[nodiscard]]
 auto make_check_func(
     irreducible_method irr_meth, primitive_method prim_meth)
--> typename pipeline<gfpoly, check_result>::payload_fn {
-    return [=](const gfpoly &poly, std::optional<check_result> &res) {
-        auto result = check_result{true, true};
+-> typename basic_polychecker<Field>::payload_fn {
+    return [=](const basic_gfpoly<Field> &poly, std::optional<check_result> &res) {
+        res.emplace(check(poly, irr_meth, prim_meth));
+    };
+}
 
-        switch (irr_meth) {
-        case irreducible_method::recommended:
-            result.irreducible = is_irreducible(poly);
-            break;
-        case irreducible_method::berlekamp:
-            result.irreducible = is_irreducible_berlekamp(poly);
-            break;
-        case irreducible_method::rabin:
-            result.irreducible = is_irreducible_rabin(poly);
-            break;
-        case irreducible_method::benor:
-            result.irreducible = is_irreducible_benor(poly);
-            break;
-        default:; // irreducible_method::nil
+/**
+ * Creates batch_payload_fn for irrpoly::multithread::pipeline::chain_batch,
+ * whole chunk of polynomials is checked within single call.
+ */
+template<typename Field = gf>
+[[nodiscard]]
+auto make_batch_check_func(
+    irreducible_method irr_meth, primitive_method prim_meth)
+-> typename basic_polychecker<Field>::batch_payload_fn {
+    return [=](const std::vector<basic_gfpoly<Field>> &poly,
+               std::vector<std::optional<check_result>> &res) {
+        if (poly.empty()) {
+            return;
         }
-
-        switch (prim_meth) {
-        case primitive_method::recommended:
-            result.primitive = result.irreducible ?
-                               is_primitive(poly) : false;
-            break;
-        case primitive_method::definition:
-            result.primitive = result.irreducible ?
-                               is_primitive_definition(poly) : false;
-            break;
-        default:; // primitive_method::nil
+        // same degree candidates are packed to be checked as a batch,
+        // zero polynomial has no degree and is checked separately
+        const bool same_degree = std::all_of(poly.begin(), poly.end(), [&poly](const basic_gfpoly<Field> &p) {
+            return !p.is_zero() && p.degree() == poly.front().degree();
+        });
+        if (same_degree) {
+            const auto found = check(basic_gfpoly_batch<Field>(poly.front().field(), poly), irr_meth, prim_meth);
+            for (std::size_t i = 0; i < poly.size(); ++i) {
+                res[i].emplace(found[i]);
+            }
+            return;
+        }
+        for (std::size_t i = 0; i < poly.size(); ++i) {
+            res[i].emplace(check(poly[i], irr_meth, prim_meth));
         }
-
-        res.emplace(result);
     };
 }
 
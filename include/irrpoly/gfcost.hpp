@@ -0,0 +1,394 @@
+/**
+ * @file    gfcost.hpp
+ * @author  Vadim Piven <vadim@piven.tech>
+ * @license Free use of this library is permitted under the
+ * guidelines and in accordance with the MIT License (MIT).
+ * @url     https://github.com/irreducible-polynoms/irrpoly
+ */
+
+#pragma once
+
+#include "gfmul.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <fstream>
+#include <istream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace irrpoly {
+
+/**
+ * Irreducibility tests the dispatcher chooses from.
+ */
+enum class irreducible_test : unsigned {
+    berlekamp, ///< Berlekamp's test, packed one over GF[2]
+    rabin, ///< Rabin's test
+    benor, ///< Ben-Or's test
+    sieve, ///< has_small_factor sieve followed by the cheapest of the other tests
+};
+
+/// number of irreducible_test values
+inline constexpr unsigned irreducible_test_count = 4;
+
+/**
+ * Arithmetic the tests run on for given base and degree.
+ */
+enum class test_backend : unsigned {
+    generic, ///< schoolbook and Karatsuba products of gfpoly
+    packed_gf2, ///< bit-packed gf2poly
+    ntt, ///< number theoretic transform products
+};
+
+[[nodiscard]]
+inline
+auto test_name(const irreducible_test t) -> const char * {
+    constexpr const char *names[irreducible_test_count] = {"berlekamp", "rabin", "benor", "sieve"};
+    return names[static_cast<unsigned>(t)];
+}
+
+[[nodiscard]]
+inline
+auto backend_name(const test_backend b) -> const char * {
+    constexpr const char *names[] = {"generic", "packed_gf2", "ntt"};
+    return names[static_cast<unsigned>(b)];
+}
+
+/**
+ * Returns the backend used by the tests of polynomials of given degree over GF[base]
+ * with the current detail::ntt_threshold.
+ */
+[[nodiscard]]
+inline
+auto test_backend_for(const uintmax_t base, const uintmax_t degree) -> test_backend {
+    if (base == 2) {
+        return test_backend::packed_gf2;
+    }
+    if (degree >= detail::ntt_threshold && base < (uintmax_t(1) << 31U)) {
+        return test_backend::ntt;
+    }
+    return test_backend::generic;
+}
+
+/**
+ * Measured cost of every test for candidates of given degree over GF[base],
+ * mean nanoseconds per candidate, zero for tests not measured.
+ */
+struct cost_entry {
+    uintmax_t base;
+    uintmax_t degree;
+    test_backend backend;
+    std::array<double, irreducible_test_count> ns;
+};
+
+/**
+ * Choice of the dispatcher: test and whether it is preceded by the sieve.
+ */
+struct irreducible_choice {
+    irreducible_test test;
+    bool sieve;
+};
+
+/**
+ * Table of measured costs. For a candidate the dispatcher takes the nearest entry
+ * (by logarithms of base and degree) among entries of the same backend, or among
+ * all of them if there are none, and chooses its cheapest test. With empty table
+ * Berlekamp's test is used over GF[2] and Ben-Or's one otherwise.
+ *
+ * Text form has one entry per line: base, degree, backend name and costs of
+ * berlekamp, rabin, benor and sieve; lines starting with '#' are comments.
+ * tests/sweep writes it with --costs option.
+ */
+class cost_table {
+private:
+    std::vector<cost_entry> m_entries;
+
+    [[nodiscard]]
+    static
+    auto distance(const cost_entry &e, const double lb, const double ld) -> double {
+        return std::fabs(std::log2(static_cast<double>(e.base)) - lb) +
+               std::fabs(std::log2(static_cast<double>(std::max<uintmax_t>(e.degree, 1))) - ld);
+    }
+
+public:
+    cost_table() = default;
+
+    explicit
+    cost_table(std::vector<cost_entry> entries) {
+        for (auto &e : entries) {
+            add(e);
+        }
+    }
+
+    /**
+     * Adds entry, replacing the one with the same base, degree and backend.
+     */
+    void add(const cost_entry &e) {
+        if (e.base < 2) {
+            throw std::invalid_argument("field base must be at least 2");
+        }
+        for (auto &old : m_entries) {
+            if (old.base == e.base && old.degree == e.degree && old.backend == e.backend) {
+                old = e;
+                return;
+            }
+        }
+        m_entries.push_back(e);
+    }
+
+    [[nodiscard]]
+    auto entries() const -> const std::vector<cost_entry> & {
+        return m_entries;
+    }
+
+    [[nodiscard]]
+    auto empty() const -> bool {
+        return m_entries.empty();
+    }
+
+    /**
+     * Returns the test for candidates of given degree over GF[base].
+     */
+    [[nodiscard]]
+    auto pick(const uintmax_t base, const uintmax_t degree) const -> irreducible_choice {
+        const auto backend = test_backend_for(base, degree);
+        const bool same = std::any_of(m_entries.begin(), m_entries.end(),
+                                      [backend](const cost_entry &e) { return e.backend == backend; });
+        const auto lb = std::log2(static_cast<double>(base));
+        const auto ld = std::log2(static_cast<double>(std::max<uintmax_t>(degree, 1)));
+        const cost_entry *nearest = nullptr;
+        for (const auto &e : m_entries) {
+            if ((!same || e.backend == backend) && (!nearest || distance(e, lb, ld) < distance(*nearest, lb, ld))) {
+                nearest = &e;
+            }
+        }
+        irreducible_choice res{base == 2 ? irreducible_test::berlekamp : irreducible_test::benor, false};
+        if (!nearest) {
+            return res;
+        }
+        auto best = std::numeric_limits<double>::infinity();
+        for (unsigned t = 0; t < irreducible_test_count - 1; ++t) {
+            const auto ns = nearest->ns[t];
+            if (ns > 0 && ns < best) {
+                best = ns;
+                res.test = static_cast<irreducible_test>(t);
+            }
+        }
+        const auto sieve = nearest->ns[static_cast<unsigned>(irreducible_test::sieve)];
+        res.sieve = (sieve > 0 && sieve < best);
+        return res;
+    }
+
+    /**
+     * Costs measured by tests/sweep --costs on x86-64 (GCC 12, Release, single thread)
+     * over 32 random candidates per sample, they mostly have small factors, so the sieve
+     * wins over GF[2] and is on par with Ben-Or's test from degree 32 over the others.
+     */
+    [[nodiscard]]
+    static
+    auto builtin() -> cost_table;
+
+    friend
+    auto operator<<(std::ostream &os, const cost_table &table) -> std::ostream & {
+        os << "# base degree backend";
+        for (unsigned t = 0; t < irreducible_test_count; ++t) {
+            os << ' ' << test_name(static_cast<irreducible_test>(t));
+        }
+        os << " (ns per candidate, 0 if not measured)\n";
+        for (const auto &e : table.m_entries) {
+            os << e.base << ' ' << e.degree << ' ' << backend_name(e.backend);
+            for (const auto ns : e.ns) {
+                os << ' ' << ns;
+            }
+            os << '\n';
+        }
+        return os;
+    }
+
+    /**
+     * Reads cost table in text form, replacing the content. Throws
+     * std::invalid_argument on malformed line.
+     */
+    friend
+    auto operator>>(std::istream &is, cost_table &table) -> std::istream & {
+        std::vector<cost_entry> entries;
+        std::string line;
+        while (std::getline(is, line)) {
+            const auto first = line.find_first_not_of(" \t\r");
+            if (first == std::string::npos || line[first] == '#') {
+                continue;
+            }
+            std::istringstream ls(line);
+            cost_entry e{};
+            std::string backend;
+            ls >> e.base >> e.degree >> backend;
+            for (auto &ns : e.ns) {
+                ls >> ns;
+            }
+            if (!ls || e.base < 2) {
+                throw std::invalid_argument("malformed cost table line: " + line);
+            }
+            if (backend == "generic") {
+                e.backend = test_backend::generic;
+            } else if (backend == "packed_gf2") {
+                e.backend = test_backend::packed_gf2;
+            } else if (backend == "ntt") {
+                e.backend = test_backend::ntt;
+            } else {
+                throw std::invalid_argument("unknown backend in cost table: " + backend);
+            }
+            entries.push_back(e);
+        }
+        table = cost_table(std::move(entries));
+        is.clear(is.rdstate() & ~std::ios::failbit);
+        return is;
+    }
+};
+
+inline
+auto cost_table::builtin() -> cost_table {
+    using b = test_backend;
+    return cost_table({
+        {2, 8, b::packed_gf2, {1299, 1187, 1333, 640}},
+        {2, 16, b::packed_gf2, {1999, 3088, 2014, 900}},
+        {2, 32, b::packed_gf2, {3791, 18905, 6544, 1268}},
+        {2, 64, b::packed_gf2, {13468, 110410, 44461, 10756}},
+        {2, 128, b::packed_gf2, {37437, 466110, 63787, 27382}},
+        {2, 256, b::packed_gf2, {135374, 3245160, 253278, 101283}},
+        {2, 512, b::packed_gf2, {467957, 26193300, 1317510, 259989}},
+        {2, 1024, b::packed_gf2, {2481310, 185271000, 2107260, 766975}},
+        {2, 2048, b::packed_gf2, {11301600, 1635370000, 36001900, 2714820}},
+        {2, 4096, b::packed_gf2, {54887100, 0, 1346180000, 11307100}},
+        {3, 8, b::generic, {1081, 1326, 1241, 582}},
+        {3, 16, b::generic, {3027, 4032, 2775, 1654}},
+        {3, 32, b::generic, {15260, 18936, 11715, 12462}},
+        {3, 64, b::generic, {82707, 98227, 47328, 45987}},
+        {3, 128, b::generic, {376850, 621028, 128006, 128852}},
+        {3, 256, b::generic, {1900940, 3746370, 861240, 848273}},
+        {3, 512, b::generic, {11885500, 32039200, 1362010, 1284510}},
+        {3, 1024, b::generic, {101167000, 224128000, 4257110, 3066900}},
+        {3, 2048, b::generic, {741917000, 2068430000, 39987100, 21017800}},
+        {3, 4096, b::ntt, {0, 0, 1854040000, 1697890000}},
+        {251, 8, b::generic, {3490, 3301, 2623, 2694}},
+        {251, 16, b::generic, {11884, 11127, 6760, 6347}},
+        {251, 32, b::generic, {60203, 59151, 22872, 21507}},
+        {251, 64, b::generic, {414424, 419732, 137862, 130871}},
+        {251, 128, b::generic, {2854380, 3123910, 1606760, 1565410}},
+        {251, 256, b::generic, {11410000, 13149600, 1979480, 2116560}},
+        {251, 512, b::generic, {58852100, 83288000, 22968900, 21798800}},
+        {251, 1024, b::generic, {352148000, 491992000, 73850700, 70603300}},
+        {251, 2048, b::generic, {2587690000, 3424490000, 257628000, 253878000}},
+        {251, 4096, b::ntt, {0, 0, 992129000, 1003160000}},
+        {65521, 8, b::generic, {8147, 4658, 4010, 4021}},
+        {65521, 16, b::generic, {27832, 15304, 11405, 11413}},
+        {65521, 32, b::generic, {122447, 79725, 33876, 34741}},
+        {65521, 64, b::generic, {712164, 492548, 142618, 131892}},
+        {65521, 128, b::generic, {4781380, 3245600, 980266, 937780}},
+        {65521, 256, b::generic, {21693300, 23911400, 8401030, 8179420}},
+        {65521, 512, b::generic, {150334000, 191654000, 37665700, 36995300}},
+        {65521, 1024, b::generic, {1135960000, 1367860000, 272798000, 259908000}},
+        {65521, 2048, b::generic, {0, 0, 2326560000, 2330060000}},
+        {2147483647, 8, b::generic, {9172, 8250, 9498, 7986}},
+        {2147483647, 16, b::generic, {30026, 27933, 27382, 25987}},
+        {2147483647, 32, b::generic, {121422, 119206, 89116, 83074}},
+        {2147483647, 64, b::generic, {679985, 833840, 341164, 315318}},
+        {2147483647, 128, b::generic, {4336880, 4836060, 1847160, 1731150}},
+        {2147483647, 256, b::generic, {29111100, 30685100, 8258730, 7819400}},
+        {2147483647, 512, b::generic, {237610000, 232198000, 90972300, 85394500}},
+        {2147483647, 1024, b::generic, {1647930000, 1744080000, 395067000, 375508000}},
+        {2147483647, 2048, b::generic, {0, 0, 4598770000, 4516020000}},
+    });
+}
+
+namespace detail {
+
+struct cost_state {
+    std::mutex mutex;
+    std::shared_ptr<const cost_table> table = std::make_shared<const cost_table>(cost_table::builtin());
+    std::atomic<uint64_t> generation{0};
+};
+
+[[nodiscard]]
+inline
+auto costs() -> cost_state & {
+    static cost_state res;
+    return res;
+}
+
+/**
+ * Returns the choice of the current table, the last one is cached per thread,
+ * so candidates of the same base and degree don't search the table.
+ */
+[[nodiscard]]
+inline
+auto pick_irreducible(const uintmax_t base, const uintmax_t degree) -> irreducible_choice {
+    struct cached {
+        uint64_t generation = UINT64_MAX;
+        uintmax_t base = 0, degree = 0;
+        irreducible_choice choice{};
+    };
+    static thread_local cached last;
+    auto &state = costs();
+    const auto generation = state.generation.load(std::memory_order_acquire);
+    if (last.generation != generation || last.base != base || last.degree != degree) {
+        std::shared_ptr<const cost_table> table;
+        {
+            const std::lock_guard<std::mutex> lg(state.mutex);
+            table = state.table;
+        }
+        last = cached{generation, base, degree, table->pick(base, degree)};
+    }
+    return last.choice;
+}
+
+} // namespace detail
+
+/**
+ * Returns copy of the table is_irreducible dispatches by.
+ */
+[[nodiscard]]
+inline
+auto irreducible_costs() -> cost_table {
+    auto &state = detail::costs();
+    const std::lock_guard<std::mutex> lg(state.mutex);
+    return *state.table;
+}
+
+/**
+ * Replaces the table is_irreducible dispatches by, takes effect for the checks
+ * started afterwards.
+ */
+inline
+void set_irreducible_costs(cost_table table) {
+    auto &state = detail::costs();
+    const std::lock_guard<std::mutex> lg(state.mutex);
+    state.table = std::make_shared<const cost_table>(std::move(table));
+    state.generation.fetch_add(1, std::memory_order_release);
+}
+
+/**
+ * Loads the table is_irreducible dispatches by from file in text form
+ * (usually written by tests/sweep --costs), meant to be called at startup.
+ */
+inline
+void load_irreducible_costs(const std::string &path) {
+    std::ifstream in(path);
+    if (!in) {
+        throw std::runtime_error("can't open cost table " + path);
+    }
+    cost_table table;
+    in >> table;
+    set_irreducible_costs(std::move(table));
+}
+
+} // namespace irrpoly
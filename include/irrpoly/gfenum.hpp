@@ -0,0 +1,150 @@
+/**
+ * @file    gfenum.hpp
+ * @author  Vadim Piven <vadim@piven.tech>
+ * @license Free use of this library is permitted under the
+ * guidelines and in accordance with the MIT License (MIT).
+ * @url     https://github.com/irreducible-polynoms/irrpoly
+ */
+
+#pragma once
+
+#include "gfcheck.hpp"
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <iterator>
+#include <exception>
+#include <stdexcept>
+#include <algorithm>
+
+namespace irrpoly {
+
+/**
+ * Returns the number of monic polynomials of given degree over GF[P], which is P^degree.
+ * Throws if it doesn't fit uintmax_t.
+ */
+template<typename Field>
+[[nodiscard]]
+auto monic_count(const Field &field, const uintmax_t degree) -> uintmax_t {
+    const auto P = field->base();
+    uintmax_t total = 1;
+    for (uintmax_t i = 0; i < degree; ++i) {
+        if (total > UINTMAX_MAX / P) {
+            throw std::invalid_argument("too many polynomials to enumerate");
+        }
+        total *= P;
+    }
+    return total;
+}
+
+/**
+ * Returns monic polynomial of given degree with the index in canonical order:
+ * lower coefficients are base P digits of index, the lowest one is zero-indexed term.
+ * So polynomials are ordered by coefficients starting from the highest one.
+ */
+template<typename Field>
+[[nodiscard]]
+auto make_monic(const Field &field, const uintmax_t degree, uintmax_t index) -> basic_gfpoly<Field> {
+    const auto P = field->base();
+    std::vector<uintmax_t> data(degree + 1, 0);
+    for (uintmax_t i = 0; i < degree; ++i, index /= P) {
+        data[i] = index % P;
+    }
+    data[degree] = 1;
+    return basic_gfpoly<Field>(field, std::move(data));
+}
+
+namespace multithread {
+
+/**
+ * Finds all monic polynomials of given degree for which filter returns true.
+ * Index range [0, P^degree) is split into blocks, which threads take one by one and
+ * process sequentially, each block result is stored separately. So the result is in
+ * canonical order (see make_monic) regardless of scheduling, and no sort is required.
+ * Filter is called concurrently and must be thread-safe.
+ */
+template<typename Field, typename Filter>
+[[nodiscard]]
+auto enumerate(const Field &field, const uintmax_t degree, const Filter &filter,
+               unsigned threads = std::thread::hardware_concurrency())
+-> std::vector<basic_gfpoly<Field>> {
+    const auto total = monic_count(field, degree);
+    const auto P = field->base();
+    threads = std::max(1U, threads);
+
+    // several blocks per thread to balance uneven checks
+    const uintmax_t block = std::max<uintmax_t>(1, total / (static_cast<uintmax_t>(threads) * 64));
+    const uintmax_t blocks = total / block + (total % block ? 1 : 0);
+    std::vector<std::vector<basic_gfpoly<Field>>> found(blocks);
+    std::atomic<uintmax_t> next(0);
+    std::atomic<bool> failed(false);
+    std::exception_ptr error;
+
+    auto work = [&]() {
+        try {
+            std::vector<uintmax_t> data(degree + 1, 0);
+            for (auto b = next++; b < blocks && !failed; b = next++) {
+                const auto begin = b * block, end = std::min(total, begin + block);
+                auto index = begin;
+                for (uintmax_t i = 0; i < degree; ++i, index /= P) {
+                    data[i] = index % P;
+                }
+                data[degree] = 1;
+                for (index = begin; index < end; ++index) {
+                    basic_gfpoly<Field> poly(field, data);
+                    if (filter(poly)) {
+                        found[b].emplace_back(std::move(poly));
+                    }
+                    // next index, lower digit goes first
+                    for (uintmax_t i = 0; i < degree && ++data[i] == P; ++i) {
+                        data[i] = 0;
+                    }
+                }
+            }
+        } catch (...) {
+            if (!failed.exchange(true)) {
+                error = std::current_exception();
+            }
+        }
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(threads - 1);
+    for (unsigned i = 1; i < threads; ++i) {
+        pool.emplace_back(work);
+    }
+    work();
+    for (auto &t : pool) {
+        t.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+
+    std::vector<basic_gfpoly<Field>> res;
+    for (auto &f : found) {
+        std::move(f.begin(), f.end(), std::back_inserter(res));
+    }
+    return res;
+}
+
+/**
+ * Finds all monic polynomials of given degree which pass the tests selected.
+ * In case nil method is selected - the test is passed.
+ */
+template<typename Field>
+[[nodiscard]]
+auto enumerate(const Field &field, const uintmax_t degree,
+               irreducible_method irr_meth, primitive_method prim_meth,
+               unsigned threads = std::thread::hardware_concurrency())
+-> std::vector<basic_gfpoly<Field>> {
+    return enumerate(field, degree, [=](const basic_gfpoly<Field> &poly) {
+        const auto res = check(poly, irr_meth, prim_meth);
+        return res.irreducible && res.primitive;
+    }, threads);
+}
+
+} // namespace multithread
+
+} // namespace irrpoly
@@ -0,0 +1,231 @@
+/**
+ * @file    gfeval.hpp
+ * @author  Vadim Piven <vadim@piven.tech>
+ * @license Free use of this library is permitted under the
+ * guidelines and in accordance with the MIT License (MIT).
+ * @url     https://github.com/irreducible-polynoms/irrpoly
+ */
+
+#pragma once
+
+#include "gfpoly.hpp"
+#include "gfmod.hpp"
+#include "gfcheck.hpp"
+
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdint>
+
+namespace irrpoly {
+
+namespace detail {
+
+/**
+ * Leaves of the subproduct tree hold this many points, their remainders are
+ * evaluated by Horner's method. Polynomials and point sets not exceeding it are
+ * evaluated by Horner's method without the tree.
+ */
+inline uintmax_t multipoint_threshold = 32;
+
+/**
+ * Roots over fields with base up to this value are separated by evaluation
+ * at every element of the field, larger ones by random splitting.
+ */
+inline uintmax_t root_scan_max = 64;
+
+/**
+ * Returns subproduct tree of points: level 0 holds products of (x - a) over blocks
+ * of block points, node j of the next level is the product of nodes 2j and 2j + 1,
+ * the last level holds the single product of all (x - a).
+ */
+template<typename Field>
+[[nodiscard]]
+auto subproduct_tree(const Field &field, const std::vector<uintmax_t> &points, const uintmax_t block)
+-> std::vector<std::vector<basic_gfpoly<Field>>> {
+    std::vector<std::vector<basic_gfpoly<Field>>> tree(1);
+    for (uintmax_t first = 0; first < points.size(); first += block) {
+        const auto last = std::min<uintmax_t>(first + block, points.size());
+        basic_gfpoly<Field> leaf(field, 1);
+        for (auto i = first; i < last; ++i) {
+            // leaf * (x - a) is a shift followed by subtraction
+            leaf = (leaf << 1U) - leaf * points[i];
+        }
+        tree[0].emplace_back(std::move(leaf));
+    }
+    while (tree.back().size() > 1) {
+        const auto &prev = tree.back();
+        std::vector<basic_gfpoly<Field>> next;
+        next.reserve((prev.size() + 1) / 2);
+        for (std::size_t j = 0; j + 1 < prev.size(); j += 2) {
+            next.emplace_back(prev[j] * prev[j + 1]);
+        }
+        if (prev.size() % 2) {
+            next.emplace_back(prev.back());
+        }
+        tree.emplace_back(std::move(next));
+    }
+    return tree;
+}
+
+template<typename Field>
+[[nodiscard]]
+auto monic(basic_gfpoly<Field> poly) -> basic_gfpoly<Field> {
+    const auto lead = poly[poly.degree()];
+    if (lead != 1) {
+        poly *= poly.field()->mul_inv(lead);
+    }
+    return poly;
+}
+
+} // namespace detail
+
+/**
+ * Returns values of polynomial at all the points. Points are split by the subproduct
+ * tree (see detail::subproduct_tree), polynomial is reduced modulo its nodes from the
+ * root down, so the cost is O(M(n) log n) for n points instead of n * deg(poly)
+ * for separate Horner evaluations.
+ */
+template<typename Field>
+[[nodiscard]]
+auto eval(const basic_gfpoly<Field> &poly, const std::vector<uintmax_t> &points) -> std::vector<uintmax_t> {
+    const auto &field = poly.field();
+    const auto block = std::max<uintmax_t>(detail::multipoint_threshold, 1);
+    std::vector<uintmax_t> res(points.size());
+    if (points.size() <= block || poly.size() <= block) {
+        for (std::size_t i = 0; i < points.size(); ++i) {
+            res[i] = poly.eval(points[i]);
+        }
+        return res;
+    }
+    std::vector<uintmax_t> reduced(points.size());
+    for (std::size_t i = 0; i < points.size(); ++i) {
+        reduced[i] = field->reduce(points[i]);
+    }
+    const auto tree = detail::subproduct_tree(field, reduced, block);
+    std::vector<basic_gfpoly<Field>> rem{poly % tree.back().front()}, next;
+    for (auto level = tree.size() - 1; level > 0; --level) {
+        const auto &nodes = tree[level - 1];
+        next.assign(nodes.size(), basic_gfpoly<Field>(field));
+        for (std::size_t j = 0; j < nodes.size(); ++j) {
+            next[j] = rem[j / 2] % nodes[j];
+        }
+        rem.swap(next);
+    }
+    for (std::size_t i = 0; i < points.size(); ++i) {
+        res[i] = rem[i / block].eval(reduced[i]);
+    }
+    return res;
+}
+
+/**
+ * Returns the product of all distinct linear factors of polynomial, which is
+ * gcd(f, x^P - x), monic. x^P is computed modulo f, so the cost is log(P)
+ * modular squarings and single gcd.
+ */
+template<typename Field>
+[[nodiscard]]
+auto root_product(const basic_gfmod<Field> &mod) -> basic_gfpoly<Field> {
+    const auto &f = mod.modulus();
+    const auto &field = mod.field();
+    if (f.degree() == 0) {
+        return basic_gfpoly<Field>(field, 1);
+    }
+    auto w = mod.x_powmod(field->base()) - basic_gfpoly<Field>(field, {0, 1});
+    if (w.is_zero()) { // f itself divides x^P - x
+        return f;
+    }
+    return detail::monic(gcd(f, std::move(w)));
+}
+
+template<typename Field>
+[[nodiscard]]
+auto root_product(const basic_gfpoly<Field> &poly) -> basic_gfpoly<Field> {
+    if (poly.is_zero()) {
+        throw std::domain_error("zero polynomial has all the field elements as roots");
+    }
+    return root_product(basic_gfmod<Field>(poly));
+}
+
+/**
+ * Returns true if polynomial has a root in GF[P], no values are tried.
+ */
+template<typename Field>
+[[nodiscard]]
+auto has_root(const basic_gfpoly<Field> &poly) -> bool {
+    return root_product(poly).degree() > 0;
+}
+
+/**
+ * Returns sorted distinct roots of non-zero polynomial in GF[P]. Roots are
+ * separated from root_product: over small fields it is evaluated at all
+ * the elements (see detail::root_scan_max), otherwise it is split by
+ * gcd(g, (x + a)^((P - 1) / 2) - 1) for random a (Cantor-Zassenhaus),
+ * or by the trace of a x when P is a power of two (extension of GF[2], see gfext),
+ * every split halves the roots on average.
+ */
+template<typename Field>
+[[nodiscard]]
+auto roots(const basic_gfpoly<Field> &poly) -> std::vector<uintmax_t> {
+    const auto &field = poly.field();
+    const auto P = field->base();
+    auto g = root_product(poly);
+    std::vector<uintmax_t> res;
+    if (g.degree() == 0) {
+        return res;
+    }
+    if (P <= std::max<uintmax_t>(detail::root_scan_max, 2)) {
+        std::vector<uintmax_t> points(P);
+        for (uintmax_t a = 0; a < P; ++a) {
+            points[a] = a;
+        }
+        const auto val = eval(g, points);
+        for (uintmax_t a = 0; a < P; ++a) {
+            if (val[a] == 0) {
+                res.push_back(a);
+            }
+        }
+        return res;
+    }
+    std::uniform_int_distribution<uintmax_t> dis(0, P - 1);
+    std::vector<basic_gfpoly<Field>> stack{std::move(g)};
+    while (!stack.empty()) {
+        auto h = std::move(stack.back());
+        stack.pop_back();
+        if (h.degree() == 1) {
+            res.push_back(field->neg(h[0]));
+            continue;
+        }
+        const basic_gfmod<Field> mod(h);
+        for (;;) {
+            detail::throw_if_stopped();
+            basic_gfpoly<Field> w(field);
+            if (P % 2) {
+                const basic_gfpoly<Field> shift(field, {dis(detail::thread_engine()), 1});
+                w = mod.powmod(shift, (P - 1) / 2) - basic_gfpoly<Field>(field, 1);
+            } else {
+                // even P is a power of two: trace a x + (a x)^2 + ... + (a x)^(P / 2)
+                // takes values 0 and 1 at the roots
+                basic_gfpoly<Field> t(field, {0, dis(detail::thread_engine())});
+                for (uintmax_t e = 1; e < P; e <<= 1U) {
+                    w += t;
+                    mod.sqrmod_inplace(t);
+                }
+            }
+            if (w.is_zero()) {
+                continue;
+            }
+            auto d = detail::monic(gcd(h, std::move(w)));
+            if (d.degree() > 0 && d.degree() < h.degree()) {
+                stack.emplace_back(h / d);
+                stack.emplace_back(std::move(d));
+                break;
+            }
+        }
+    }
+    std::sort(res.begin(), res.end());
+    return res;
+}
+
+} // namespace irrpoly
@@ -0,0 +1,598 @@
+/**
+ * @file    gfext.hpp
+ * @author  Vadim Piven <vadim@piven.tech>
+ * @license Free use of this library is permitted under the
+ * guidelines and in accordance with the MIT License (MIT).
+ * @url     https://github.com/irreducible-polynoms/irrpoly
+ */
+
+#pragma once
+
+#include "gfcheck.hpp"
+#include "biguint.hpp"
+
+#include <array>
+#include <algorithm>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+
+namespace irrpoly {
+
+/**
+ * Binary operations for two gfn instances are correctly defined only
+ * when field is the same for both of them. By default this is checked
+ * only in Debug configuration and no checks performed in Release to speed
+ * up computations. If you are not sure in correctness of your code add
+ * #define IRRPOLY_RELEASE_CHECKED before #include <irrpoly.h> to enable
+ * checks for Release configuration.
+ */
+#if !defined(NDEBUG) || defined(IRRPOLY_RELEASE_CHECKED) // Debug or Release Checked
+#define CHECK_FIELD(comparison) \
+    if (!(comparison)) { \
+        throw std::logic_error("field check failed"); \
+    }
+#else // Release
+#define CHECK_FIELD(comparison)
+#endif
+
+class gfextbase;
+
+/**
+ * Strategies of arithmetic in gfext.
+ */
+enum class gfext_arithmetic {
+    tables, ///< Zech logarithm tables built during field construction, O(P^k) memory
+    reduction, ///< residues are multiplied as polynomials and reduced by the modulus, O(1) memory
+    recommended, ///< tables for small fields, reduction for large fields
+};
+
+/**
+ * gfext type represents EXTENSION Galois field GF[P^k] = GF[P][x] / f, where f is
+ * irreducible polynomial of degree k over GF[P]. Like gf it is a shared pointer that
+ * couldn't contain nullptr value. Element a0 + a1 x + ... + a(k-1) x^(k-1) is stored
+ * as packed residue a0 + a1 P + ... + a(k-1) P^(k-1), so gfext provides the same
+ * interface as gf with base() equal to P^k and could be used as Field of numbers,
+ * polynomials, modulus contexts and checks. Residues are not integers modulo base(),
+ * characteristic() tells them apart (see detail::integer_residues).
+ * Small fields tabulate powers of a primitive element g, their discrete logarithms
+ * and Zech logarithms log(1 + g^i), so every operation is a few lookups. Large fields
+ * keep normalized modulus and multiply residues as polynomials with reduction by it.
+ * Fields with the same base and different moduli are different fields.
+ * The largest field is the same as for gf, P^k must not exceed 2^63 - 1.
+ */
+using gfext = dropbox::oxygen::nn_shared_ptr<gfextbase>;
+
+class gfextbase final {
+private:
+    static constexpr uintmax_t max_degree = 63; ///< P^k fits 63 bits, so k is below 64
+    static constexpr uint32_t zech_zero = UINT32_MAX; ///< Zech logarithm of i with 1 + g^i = 0
+
+    using digits = std::array<uintmax_t, 2 * max_degree>;
+
+    const gf m_prime; ///< prime subfield GF[P]
+    uintmax_t m_base; ///< P^k
+    gfpoly m_mod; ///< monic modulus f of degree k
+    std::vector<uintmax_t> m_tail; ///< negated lower coefficients of f, x^k = sum m_tail[i] x^i
+    uintmax_t m_bits; ///< f packed with its leading term when P = 2, residues are bit vectors then
+    std::vector<uint32_t> m_log; ///< discrete logarithms by g, empty if tables are not used
+    std::vector<uint32_t> m_exp; ///< g^i for i in [0, 2(P^k - 1)), sums of logarithms need no reduction
+    std::vector<uint32_t> m_zech; ///< log(1 + g^i) for i in [0, P^k - 1)
+
+    gfextbase(const gfpoly & /*modulus*/, gfext_arithmetic /*arithmetic*/);
+
+    friend auto make_gfext(const gfpoly & /*modulus*/, gfext_arithmetic /*arithmetic*/) -> gfext;
+
+    void unpack(uintmax_t /*val*/, uintmax_t * /*res*/) const;
+
+    [[nodiscard]]
+    auto pack(const uintmax_t * /*val*/) const -> uintmax_t;
+
+    [[nodiscard]]
+    auto add_digits(uintmax_t /*lb*/, uintmax_t /*rb*/) const -> uintmax_t;
+
+    [[nodiscard]]
+    auto neg_digits(uintmax_t /*rb*/) const -> uintmax_t;
+
+    [[nodiscard]]
+    auto mul_digits(uintmax_t /*lb*/, uintmax_t /*rb*/) const -> uintmax_t;
+
+    [[nodiscard]]
+    auto pow_digits(uintmax_t /*val*/, uintmax_t /*exp*/) const -> uintmax_t;
+
+    [[nodiscard]]
+    auto inv_digits(uintmax_t /*val*/) const -> uintmax_t;
+
+    void build_tables();
+
+public:
+    /**
+     * Fields with base up to this value use tables for recommended strategy.
+     */
+    static constexpr uintmax_t table_limit = UINT16_MAX + 1U;
+
+    /**
+     * Returns number of elements P^k.
+     */
+    [[nodiscard]]
+    auto base() const -> uintmax_t;
+
+    /**
+     * Returns P, the base of prime subfield.
+     */
+    [[nodiscard]]
+    auto characteristic() const -> uintmax_t;
+
+    /**
+     * Returns k, the degree of extension.
+     */
+    [[nodiscard]]
+    auto degree() const -> uintmax_t;
+
+    [[nodiscard]]
+    auto prime_field() const -> const gf &;
+
+    /**
+     * Returns monic modulus, the field is GF[P][x] / modulus().
+     */
+    [[nodiscard]]
+    auto modulus() const -> const gfpoly &;
+
+    /**
+     * Returns packed residue of poly % modulus().
+     */
+    [[nodiscard]]
+    auto pack(const gfpoly & /*poly*/) const -> uintmax_t;
+
+    /**
+     * Returns polynomial of degree below k represented by residue val % base().
+     */
+    [[nodiscard]]
+    auto unpack(uintmax_t /*val*/) const -> gfpoly;
+
+    /**
+     * Returns multiplicative inverse for given number.
+     */
+    [[nodiscard]]
+    auto mul_inv(uintmax_t /*val*/) const -> uintmax_t;
+
+    /**
+     * Returns val % base().
+     */
+    [[nodiscard]]
+    auto reduce(uintmax_t /*val*/) const -> uintmax_t;
+
+    /**
+     * UNSAFE! Requires lb and rb to lay between 0 and base().
+     * Returned number also lays between 0 and base().
+     */
+    [[nodiscard]]
+    auto add(uintmax_t /*lb*/, uintmax_t /*rb*/) const -> uintmax_t;
+
+    /**
+     * UNSAFE! Requires lb and rb to lay between 0 and base().
+     * Returned number also lays between 0 and base().
+     */
+    [[nodiscard]]
+    auto sub(uintmax_t /*lb*/, uintmax_t /*rb*/) const -> uintmax_t;
+
+    /**
+     * UNSAFE! Requires rb to lay between 0 and base().
+     * Returned number also lays between 0 and base().
+     */
+    [[nodiscard]]
+    auto neg(uintmax_t /*rb*/) const -> uintmax_t;
+
+    /**
+     * UNSAFE! Requires lb and rb to lay between 0 and base().
+     * Returned number also lays between 0 and base().
+     */
+    [[nodiscard]]
+    auto mul(uintmax_t /*lb*/, uintmax_t /*rb*/) const -> uintmax_t;
+};
+
+inline
+auto operator==(const gfext &lb, const gfext &rb) -> bool {
+    return &*lb == &*rb || (lb->base() == rb->base() && lb->modulus() == rb->modulus());
+}
+
+inline
+auto operator!=(const gfext &lb, const gfext &rb) -> bool {
+    return !(lb == rb);
+}
+
+/**
+ * gfext_view is a non-owning handle of gfext, see gf_view.
+ */
+class gfext_view final {
+private:
+    const gfextbase *m_ptr;
+
+public:
+    gfext_view(const gfext &field) : m_ptr(&*field) {} // NOLINT(google-explicit-constructor)
+
+    auto operator->() const -> const gfextbase * {
+        return m_ptr;
+    }
+
+    auto operator*() const -> const gfextbase & {
+        return *m_ptr;
+    }
+
+    friend
+    auto operator==(const gfext_view lb, const gfext_view rb) -> bool {
+        return lb.m_ptr == rb.m_ptr || (lb->base() == rb->base() && lb->modulus() == rb->modulus());
+    }
+
+    friend
+    auto operator!=(const gfext_view lb, const gfext_view rb) -> bool {
+        return !(lb == rb);
+    }
+
+    /// gfext_view is never uninitialised
+    friend
+    auto operator==(const gfext_view /*lb*/, std::nullptr_t /*rb*/) -> bool {
+        return false;
+    }
+};
+
+/**
+ * Returns non-owning handle of the field, see gfext_view.
+ */
+[[nodiscard]]
+inline
+auto field_view(const gfext &field) -> gfext_view {
+    return gfext_view(field);
+}
+
+[[nodiscard]]
+inline
+auto field_view(const gfext_view field) -> gfext_view {
+    return field;
+}
+
+/**
+ * gfextn type represents number in GF[P^k].
+ */
+using gfextn = basic_gfn<gfext>;
+
+/**
+ * gfextn_view is a lightweight number in GF[P^k], see gfn_view.
+ */
+using gfextn_view = basic_gfn<gfext_view>;
+
+/**
+ * gfextpoly type represents polynomial over GF[P^k].
+ */
+using gfextpoly = basic_gfpoly<gfext>;
+
+using gfextmod = basic_gfmod<gfext>;
+
+inline
+gfextbase::gfextbase(const gfpoly &modulus, const gfext_arithmetic arithmetic) :
+    m_prime(modulus.field()), m_base(1), m_mod(modulus), m_tail(), m_bits(0), m_log(), m_exp(), m_zech() {
+    if (modulus.is_zero() || modulus.degree() == 0) {
+        throw std::logic_error("modulus must have positive degree");
+    }
+    const auto P = m_prime->base(), k = modulus.degree();
+    for (uintmax_t i = 0; i < std::min(k, max_degree + 1); ++i) {
+        if (m_base > static_cast<uintmax_t>(INTMAX_MAX) / P) {
+            throw std::logic_error("too large field");
+        }
+        m_base *= P;
+    }
+    if (!is_irreducible(modulus)) {
+        throw std::logic_error("multiplicative inverse don't exist");
+    }
+    if (m_mod[k] != 1) {
+        m_mod *= m_prime->mul_inv(m_mod[k]);
+    }
+    m_tail.resize(k);
+    for (uintmax_t i = 0; i < k; ++i) {
+        m_tail[i] = m_prime->neg(m_mod[i]);
+    }
+    if (P == 2) {
+        m_bits = m_base | pack(m_mod.value().data());
+    }
+
+    if (arithmetic == gfext_arithmetic::reduction ||
+        (arithmetic == gfext_arithmetic::recommended && m_base > table_limit)) {
+        return;
+    }
+    if (m_base > UINT32_MAX) {
+        throw std::logic_error("too large field");
+    }
+    build_tables();
+}
+
+inline
+void gfextbase::build_tables() {
+    const auto order = m_base - 1;
+    std::vector<uintmax_t> cofactors;
+    for (const auto &q : detail::prime_divisors(detail::biguint(order))) {
+        cofactors.push_back(order / q.value());
+    }
+    // primitive element is the one of order P^k - 1
+    uintmax_t g = 1;
+    for (bool primitive = false; !primitive;) {
+        primitive = true;
+        for (const auto c : cofactors) {
+            primitive = primitive && pow_digits(g, c) != 1;
+        }
+        g += !primitive;
+    }
+
+    m_log.assign(m_base, 0);
+    m_exp.assign(2 * order, 0);
+    for (uintmax_t i = 0, x = 1; i < order; ++i, x = mul_digits(x, g)) {
+        m_exp[i] = m_exp[i + order] = static_cast<uint32_t>(x);
+        m_log[x] = static_cast<uint32_t>(i);
+    }
+    m_zech.assign(order, zech_zero);
+    for (uintmax_t i = 0; i < order; ++i) {
+        const auto s = add_digits(1, m_exp[i]);
+        if (s) {
+            m_zech[i] = m_log[s];
+        }
+    }
+}
+
+inline
+void gfextbase::unpack(uintmax_t val, uintmax_t *res) const {
+    const auto P = m_prime->base();
+    for (uintmax_t i = 0; i < m_tail.size(); ++i, val /= P) {
+        res[i] = val % P;
+    }
+}
+
+[[nodiscard]]
+inline
+auto gfextbase::pack(const uintmax_t *val) const -> uintmax_t {
+    const auto P = m_prime->base();
+    uintmax_t res = 0;
+    for (auto i = m_tail.size(); i > 0; --i) {
+        res = res * P + val[i - 1];
+    }
+    return res;
+}
+
+[[nodiscard]]
+inline
+auto gfextbase::add_digits(uintmax_t lb, uintmax_t rb) const -> uintmax_t {
+    const auto P = m_prime->base();
+    uintmax_t res = 0;
+    for (uintmax_t pw = 1; lb || rb; lb /= P, rb /= P, pw *= P) {
+        res += m_prime->add(lb % P, rb % P) * pw;
+    }
+    return res;
+}
+
+[[nodiscard]]
+inline
+auto gfextbase::neg_digits(uintmax_t rb) const -> uintmax_t {
+    const auto P = m_prime->base();
+    uintmax_t res = 0;
+    for (uintmax_t pw = 1; rb; rb /= P, pw *= P) {
+        res += m_prime->neg(rb % P) * pw;
+    }
+    return res;
+}
+
+[[nodiscard]]
+inline
+auto gfextbase::mul_digits(const uintmax_t lb, const uintmax_t rb) const -> uintmax_t {
+    const auto k = m_tail.size();
+    if (m_bits) {
+        // carry-less multiplication, x^k is replaced by the lower terms of f at once
+        uintmax_t res = 0, a = lb;
+        for (auto b = rb; b; b >>= 1U) {
+            res ^= (b & 1U) ? a : 0;
+            a <<= 1U;
+            a ^= (a >> k) ? m_bits : 0;
+        }
+        return res;
+    }
+    digits a{}, b{}, prod{};
+    unpack(lb, a.data());
+    unpack(rb, b.data());
+    for (uintmax_t i = 0; i < k; ++i) {
+        if (a[i]) {
+            for (uintmax_t j = 0; j < k; ++j) {
+                prod[i + j] = m_prime->add(prod[i + j], m_prime->mul(a[i], b[j]));
+            }
+        }
+    }
+    // x^i = x^(i - k) * sum m_tail[j] x^j, the highest term goes first
+    for (auto i = 2 * k - 1; i-- > k;) {
+        if (prod[i]) {
+            for (uintmax_t j = 0; j < k; ++j) {
+                prod[i - k + j] = m_prime->add(prod[i - k + j], m_prime->mul(prod[i], m_tail[j]));
+            }
+        }
+    }
+    return pack(prod.data());
+}
+
+[[nodiscard]]
+inline
+auto gfextbase::pow_digits(uintmax_t val, uintmax_t exp) const -> uintmax_t {
+    uintmax_t res = 1;
+    for (; exp; exp >>= 1U, val = mul_digits(val, val)) {
+        if (exp & 1U) {
+            res = mul_digits(res, val);
+        }
+    }
+    return res;
+}
+
+/**
+ * Extended Euclid's algorithm for val and f, the invariant is s * val = r mod f.
+ */
+[[nodiscard]]
+inline
+auto gfextbase::inv_digits(const uintmax_t val) const -> uintmax_t {
+    const auto k = m_tail.size();
+    digits r0{}, r1{}, s0{}, s1{};
+    for (uintmax_t i = 0; i <= k; ++i) {
+        r0[i] = m_mod[i];
+    }
+    unpack(val, r1.data());
+    s1[0] = 1;
+    uintmax_t d0 = k, d1 = k - 1;
+    while (d1 > 0 && r1[d1] == 0) {
+        --d1;
+    }
+    while (d1 > 0) {
+        const auto inv = m_prime->mul_inv(r1[d1]);
+        // r0 -= c x^sh r1 and s0 -= c x^sh s1 until deg(r0) < deg(r1),
+        // r0 doesn't vanish because f is irreducible
+        while (d0 >= d1) {
+            const auto c = m_prime->mul(r0[d0], inv), sh = d0 - d1;
+            for (uintmax_t j = 0; j <= d1; ++j) {
+                r0[sh + j] = m_prime->sub(r0[sh + j], m_prime->mul(c, r1[j]));
+            }
+            for (uintmax_t j = 0; j + sh < k; ++j) {
+                s0[sh + j] = m_prime->sub(s0[sh + j], m_prime->mul(c, s1[j]));
+            }
+            while (d0 > 0 && r0[d0] == 0) {
+                --d0;
+            }
+        }
+        std::swap(r0, r1);
+        std::swap(s0, s1);
+        std::swap(d0, d1);
+    }
+    const auto inv = m_prime->mul_inv(r1[0]);
+    for (uintmax_t j = 0; j < k; ++j) {
+        s1[j] = m_prime->mul(s1[j], inv);
+    }
+    return pack(s1.data());
+}
+
+[[nodiscard]]
+inline
+auto gfextbase::base() const -> uintmax_t {
+    return m_base;
+}
+
+[[nodiscard]]
+inline
+auto gfextbase::characteristic() const -> uintmax_t {
+    return m_prime->base();
+}
+
+[[nodiscard]]
+inline
+auto gfextbase::degree() const -> uintmax_t {
+    return m_tail.size();
+}
+
+[[nodiscard]]
+inline
+auto gfextbase::prime_field() const -> const gf & {
+    return m_prime;
+}
+
+[[nodiscard]]
+inline
+auto gfextbase::modulus() const -> const gfpoly & {
+    return m_mod;
+}
+
+[[nodiscard]]
+inline
+auto gfextbase::pack(const gfpoly &poly) const -> uintmax_t {
+    CHECK_FIELD(poly.field() == m_prime)
+    const auto rem = poly % m_mod;
+    digits val{};
+    for (uintmax_t i = 0; i < rem.size(); ++i) {
+        val[i] = rem[i];
+    }
+    return pack(val.data());
+}
+
+[[nodiscard]]
+inline
+auto gfextbase::unpack(const uintmax_t val) const -> gfpoly {
+    std::vector<uintmax_t> res(degree());
+    unpack(reduce(val), res.data());
+    return gfpoly(m_prime, std::move(res));
+}
+
+[[nodiscard]]
+inline
+auto gfextbase::mul_inv(const uintmax_t val) const -> uintmax_t {
+    switch (reduce(val)) {
+    case 0:throw std::logic_error("multiplicative inverse don't exist");
+    default:return m_log.empty() ?
+                   inv_digits(reduce(val)) :
+                   m_exp[m_base - 1 - m_log[reduce(val)]];
+    }
+}
+
+[[nodiscard]]
+inline
+auto gfextbase::reduce(const uintmax_t val) const -> uintmax_t {
+    return val % m_base;
+}
+
+[[nodiscard]]
+inline
+auto gfextbase::add(const uintmax_t lb, const uintmax_t rb) const -> uintmax_t {
+    if (characteristic() == 2) {
+        return lb ^ rb;
+    }
+    if (m_log.empty()) {
+        return add_digits(lb, rb);
+    }
+    if (!lb || !rb) {
+        return lb | rb;
+    }
+    // g^a + g^b = g^a (1 + g^(b - a))
+    const auto la = m_log[lb], lr = m_log[rb];
+    const auto z = m_zech[(lr >= la) ? (lr - la) : (lr + m_base - 1 - la)];
+    return (z == zech_zero) ? 0 : m_exp[la + z];
+}
+
+[[nodiscard]]
+inline
+auto gfextbase::sub(const uintmax_t lb, const uintmax_t rb) const -> uintmax_t {
+    return add(lb, neg(rb));
+}
+
+[[nodiscard]]
+inline
+auto gfextbase::neg(const uintmax_t rb) const -> uintmax_t {
+    if (characteristic() == 2 || !rb) {
+        return rb;
+    }
+    // -1 = g^((P^k - 1) / 2)
+    return m_log.empty() ? neg_digits(rb) : m_exp[m_log[rb] + (m_base - 1) / 2];
+}
+
+[[nodiscard]]
+inline
+auto gfextbase::mul(const uintmax_t lb, const uintmax_t rb) const -> uintmax_t {
+    if (m_log.empty()) {
+        return mul_digits(lb, rb);
+    }
+    return (lb && rb) ? m_exp[m_log[lb] + m_log[rb]] : 0;
+}
+
+/**
+ * Creates extension field GF[P][x] / modulus, where modulus must be irreducible.
+ * Strategy of arithmetic could be selected with arithmetic.
+ */
+[[nodiscard]]
+inline
+auto make_gfext(const gfpoly &modulus,
+                const gfext_arithmetic arithmetic = gfext_arithmetic::recommended) -> gfext {
+    return dropbox::oxygen::nn<std::shared_ptr<gfextbase>>(dropbox::oxygen::nn(
+        dropbox::oxygen::i_promise_i_checked_for_null_t{}, new gfextbase(modulus, arithmetic)));
+}
+
+#undef CHECK_FIELD
+
+} // namespace irrpoly
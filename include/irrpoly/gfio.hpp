@@ -0,0 +1,430 @@
+/**
+ * @file    gfio.hpp
+ * @author  Vadim Piven <vadim@piven.tech>
+ * @license Free use of this library is permitted under the
+ * guidelines and in accordance with the MIT License (MIT).
+ * @url     https://github.com/irreducible-polynoms/irrpoly
+ */
+
+#pragma once
+
+#include "gfpoly.hpp"
+#include "gfbatch.hpp"
+
+#include <vector>
+#include <string>
+#include <istream>
+#include <ostream>
+#include <optional>
+#include <charconv>
+#include <cstring>
+#include <cstdint>
+#include <stdexcept>
+
+namespace irrpoly {
+
+/**
+ * Binary operations for two gfn instances are correctly defined only
+ * when field is the same for both of them. By default this is checked
+ * only in Debug configuration and no checks performed in Release to speed
+ * up computations. If you are not sure in correctness of your code add
+ * #define IRRPOLY_RELEASE_CHECKED before #include <irrpoly.h> to enable
+ * checks for Release configuration.
+ */
+#if !defined(NDEBUG) || defined(IRRPOLY_RELEASE_CHECKED) // Debug or Release Checked
+#define CHECK_FIELD(comparison) \
+    if (!(comparison)) { \
+        throw std::logic_error("field check failed"); \
+    }
+#else // Release
+#define CHECK_FIELD(comparison)
+#endif
+
+/**
+ * Stream formats of polynomial sequences.
+ * Text one is the format of operator<< and operator>>, polynomial per line.
+ * Binary one starts with 8 byte magic and varint base of the field, then each
+ * polynomial is varint number of coefficients followed by coefficients packed
+ * by bit length of P - 1 from lower bits, padded to the byte boundary.
+ * It doesn't depend on byte order and for P = 2 takes n / 8 bytes per polynomial.
+ */
+enum class gfpoly_format {
+    text, ///< { a, b, c } per line
+    binary, ///< varint sizes and bit-packed coefficients
+};
+
+namespace detail {
+
+/// first bytes of binary stream
+inline constexpr char gfpoly_magic[8] = {'I', 'R', 'R', 'P', 'O', 'L', 'Y', 'S'};
+
+/// size of buffers readers refill and writers flush
+inline std::size_t io_buffer_size = 1U << 16U;
+
+[[nodiscard]]
+inline
+auto coef_bits(const uintmax_t P) -> unsigned {
+    unsigned res = 0;
+    for (auto v = P - 1; v; v >>= 1U) {
+        ++res;
+    }
+    return res;
+}
+
+inline
+void put_varint(std::string &out, uintmax_t val) {
+    for (; val >= 0x80; val >>= 7U) {
+        out.push_back(static_cast<char>((val & 0x7FU) | 0x80U));
+    }
+    out.push_back(static_cast<char>(val));
+}
+
+/**
+ * Appends coefficients packed by bits bits from lower one, last byte is zero-padded.
+ */
+inline
+void put_packed(std::string &out, const uintmax_t *coef, const uintmax_t size, const unsigned bits) {
+    uint64_t acc = 0; // below 8 pending bits
+    unsigned fill = 0;
+    for (uintmax_t i = 0; i < size; ++i) {
+        const uint64_t c = coef[i];
+        acc |= c << fill;
+        if (fill + bits > 64) { // upper part of coefficient doesn't fit
+            for (unsigned b = 0; b < 8; ++b) {
+                out.push_back(static_cast<char>(static_cast<uint8_t>(acc >> (8 * b))));
+            }
+            acc = c >> (64 - fill);
+            fill = fill + bits - 64;
+        } else {
+            fill += bits;
+        }
+        for (; fill >= 8; fill -= 8) {
+            out.push_back(static_cast<char>(static_cast<uint8_t>(acc)));
+            acc >>= 8U;
+        }
+    }
+    if (fill) {
+        out.push_back(static_cast<char>(static_cast<uint8_t>(acc)));
+    }
+}
+
+} // namespace detail
+
+/**
+ * basic_gfpoly_reader reads sequence of polynomials over the field provided from
+ * text or binary stream. Input is read by large blocks into the buffer and numbers
+ * are parsed by std::from_chars, so it is suitable for multi-gigabyte files and pipes.
+ * Malformed input throws std::invalid_argument.
+ */
+template<typename Field>
+class basic_gfpoly_reader final {
+private:
+    std::istream &m_is;
+    Field m_field;
+    gfpoly_format m_format;
+    std::vector<char> m_buf;
+    std::size_t m_pos; ///< first unparsed byte in m_buf
+    std::size_t m_end; ///< end of data in m_buf
+    bool m_eof;
+    std::vector<uintmax_t> m_coef; ///< reused coefficient buffer
+
+    /**
+     * Makes at least n bytes available from m_pos unless the stream ends, returns whether it succeeded.
+     */
+    auto ensure(const std::size_t n) -> bool {
+        while (m_end - m_pos < n && !m_eof) {
+            if (m_pos) {
+                std::memmove(m_buf.data(), m_buf.data() + m_pos, m_end - m_pos);
+                m_end -= m_pos;
+                m_pos = 0;
+            }
+            if (m_buf.size() - m_end < detail::io_buffer_size / 2) {
+                m_buf.resize(std::max(m_buf.size() * 2, m_end + detail::io_buffer_size));
+            }
+            m_is.read(m_buf.data() + m_end, static_cast<std::streamsize>(m_buf.size() - m_end));
+            const auto got = static_cast<std::size_t>(m_is.gcount());
+            m_end += got;
+            m_eof = got == 0;
+        }
+        return m_end - m_pos >= n;
+    }
+
+    [[nodiscard]]
+    static auto is_space(const char c) -> bool {
+        return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+    }
+
+    [[noreturn]]
+    static void wrong_input() {
+        throw std::invalid_argument("wrong input");
+    }
+
+    auto read_varint() -> uintmax_t {
+        uintmax_t res = 0;
+        for (unsigned shift = 0;; shift += 7) {
+            if (shift >= 64 || !ensure(1)) {
+                wrong_input();
+            }
+            const auto byte = static_cast<uint8_t>(m_buf[m_pos++]);
+            res |= static_cast<uintmax_t>(byte & 0x7FU) << shift;
+            if (!(byte & 0x80U)) {
+                return res;
+            }
+        }
+    }
+
+    void read_header() {
+        if (!ensure(sizeof(detail::gfpoly_magic)) ||
+            std::memcmp(m_buf.data() + m_pos, detail::gfpoly_magic, sizeof(detail::gfpoly_magic)) != 0) {
+            wrong_input();
+        }
+        m_pos += sizeof(detail::gfpoly_magic);
+        if (read_varint() != m_field->base()) {
+            throw std::invalid_argument("stream base differs from field base");
+        }
+    }
+
+    auto next_binary() -> bool {
+        if (!ensure(1)) {
+            return false;
+        }
+        const auto size = read_varint();
+        const auto bits = detail::coef_bits(m_field->base());
+        if (size > (UINTMAX_MAX - 7) / bits) {
+            wrong_input();
+        }
+        const auto bytes = static_cast<std::size_t>((size * bits + 7) / 8);
+        if (!ensure(bytes)) {
+            wrong_input();
+        }
+        const auto *ptr = reinterpret_cast<const uint8_t *>(m_buf.data() + m_pos);
+        const uintmax_t mask = bits == 64 ? UINTMAX_MAX : (uintmax_t(1) << bits) - 1;
+        m_coef.resize(size);
+        uint64_t acc = 0;
+        unsigned fill = 0;
+        for (uintmax_t i = 0; i < size; ++i) {
+            for (; fill < bits && fill <= 56; fill += 8) {
+                acc |= uint64_t(*ptr++) << fill;
+            }
+            if (fill >= bits) {
+                m_coef[i] = acc & mask;
+                acc = (bits == 64) ? 0 : acc >> bits;
+                fill -= bits;
+            } else { // coefficient ends in the byte which doesn't fit into acc
+                const uint64_t byte = *ptr++;
+                m_coef[i] = (acc | byte << fill) & mask;
+                const auto used = bits - fill;
+                acc = byte >> used;
+                fill = 8 - used;
+            }
+        }
+        m_pos += bytes;
+        return true;
+    }
+
+    auto next_text() -> bool {
+        for (;;) {
+            while (m_pos < m_end && is_space(m_buf[m_pos])) {
+                ++m_pos;
+            }
+            if (m_pos < m_end || !ensure(1)) {
+                break;
+            }
+        }
+        if (m_pos == m_end) {
+            return false;
+        }
+        if (m_buf[m_pos] != '{') {
+            wrong_input();
+        }
+        // whole polynomial is made available, so it's parsed without further checks of the end
+        std::size_t close = m_pos;
+        for (;;) {
+            const auto *found = static_cast<const char *>(
+                std::memchr(m_buf.data() + close, '}', m_end - close));
+            if (found) {
+                close = static_cast<std::size_t>(found - m_buf.data());
+                break;
+            }
+            const auto offset = m_end - m_pos;
+            if (!ensure(offset + 1)) {
+                wrong_input();
+            }
+            close = m_pos + offset;
+        }
+        const char *ptr = m_buf.data() + m_pos + 1, *last = m_buf.data() + close;
+        m_coef.clear();
+        while (ptr < last) {
+            if (*ptr == ',' || is_space(*ptr)) {
+                ++ptr;
+                continue;
+            }
+            uintmax_t num;
+            const auto res = std::from_chars(ptr, last, num);
+            if (res.ec != std::errc() || (res.ptr < last && *res.ptr != ',' && !is_space(*res.ptr))) {
+                wrong_input();
+            }
+            m_coef.push_back(num);
+            ptr = res.ptr;
+        }
+        m_pos = close + 1;
+        return true;
+    }
+
+public:
+    /**
+     * Creates reader from stream is, which must stay alive while reader is used.
+     * Header of binary stream is checked at once.
+     */
+    basic_gfpoly_reader(std::istream &is, const Field &field,
+                        const gfpoly_format format = gfpoly_format::text) :
+        m_is(is), m_field(field), m_format(format), m_buf(detail::io_buffer_size),
+        m_pos(0), m_end(0), m_eof(false), m_coef() {
+        if (m_format == gfpoly_format::binary) {
+            read_header();
+        }
+    }
+
+    basic_gfpoly_reader(const basic_gfpoly_reader &) = delete;
+
+    auto operator=(const basic_gfpoly_reader &) -> basic_gfpoly_reader & = delete;
+
+    /**
+     * Returns next polynomial or nullopt if the stream is over.
+     */
+    [[nodiscard]]
+    auto next() -> std::optional<basic_gfpoly<Field>> {
+        const bool ok = (m_format == gfpoly_format::text) ? next_text() : next_binary();
+        if (!ok) {
+            return std::nullopt;
+        }
+        return basic_gfpoly<Field>(m_field, m_coef);
+    }
+
+    /**
+     * Returns up to count next polynomials, fewer only if the stream is over.
+     */
+    [[nodiscard]]
+    auto read(const std::size_t count = SIZE_MAX) -> std::vector<basic_gfpoly<Field>> {
+        std::vector<basic_gfpoly<Field>> res;
+        while (res.size() < count) {
+            auto poly = next();
+            if (!poly) {
+                break;
+            }
+            res.emplace_back(std::move(*poly));
+        }
+        return res;
+    }
+};
+
+using gfpoly_reader = basic_gfpoly_reader<gf>;
+
+/**
+ * basic_gfpoly_writer writes sequence of polynomials over the field provided to
+ * text or binary stream. Output is formatted by std::to_chars into the buffer
+ * written by large blocks, so buffered part is written on destruction or by flush.
+ */
+template<typename Field>
+class basic_gfpoly_writer final {
+private:
+    std::ostream &m_os;
+    Field m_field;
+    gfpoly_format m_format;
+    unsigned m_bits;
+    std::string m_buf;
+
+    void put_text(const uintmax_t *coef, const uintmax_t size) {
+        char num[24];
+        m_buf += "{ ";
+        for (uintmax_t i = 0; i < size; ++i) {
+            if (i) {
+                m_buf += ", ";
+            }
+            const auto res = std::to_chars(num, num + sizeof(num), coef[i]);
+            m_buf.append(num, res.ptr);
+        }
+        m_buf += " }\n";
+    }
+
+    void put(const uintmax_t *coef, const uintmax_t size) {
+        if (m_format == gfpoly_format::text) {
+            put_text(coef, size);
+        } else {
+            detail::put_varint(m_buf, size);
+            detail::put_packed(m_buf, coef, size, m_bits);
+        }
+        if (m_buf.size() >= detail::io_buffer_size) {
+            m_os.write(m_buf.data(), static_cast<std::streamsize>(m_buf.size()));
+            m_buf.clear();
+        }
+    }
+
+public:
+    /**
+     * Creates writer to stream os, which must stay alive while writer is used.
+     * Header of binary stream is written at once.
+     */
+    basic_gfpoly_writer(std::ostream &os, const Field &field,
+                        const gfpoly_format format = gfpoly_format::text) :
+        m_os(os), m_field(field), m_format(format),
+        m_bits(detail::coef_bits(field->base())), m_buf() {
+        if (m_format == gfpoly_format::binary) {
+            m_buf.append(detail::gfpoly_magic, sizeof(detail::gfpoly_magic));
+            detail::put_varint(m_buf, m_field->base());
+        }
+    }
+
+    basic_gfpoly_writer(const basic_gfpoly_writer &) = delete;
+
+    auto operator=(const basic_gfpoly_writer &) -> basic_gfpoly_writer & = delete;
+
+    ~basic_gfpoly_writer() {
+        m_os.write(m_buf.data(), static_cast<std::streamsize>(m_buf.size()));
+    }
+
+    void write(const basic_gfpoly<Field> &poly) {
+        CHECK_FIELD(m_field == poly.field())
+        std::vector<uintmax_t> coef(poly.size());
+        for (uintmax_t i = 0; i < poly.size(); ++i) {
+            coef[i] = poly[i];
+        }
+        put(coef.data(), coef.size());
+    }
+
+    void write(const std::vector<basic_gfpoly<Field>> &polys) {
+        for (const auto &poly : polys) {
+            write(poly);
+        }
+    }
+
+    /**
+     * Writes all the batch polynomials with degree + 1 coefficients each,
+     * so zero upper coefficients of lower degree polynomials are written too.
+     */
+    void write(const basic_gfpoly_batch<Field> &batch) {
+        CHECK_FIELD(m_field == batch.field())
+        std::vector<uintmax_t> coef(batch.degree() + 1);
+        for (uintmax_t r = 0; r < batch.count(); ++r) {
+            for (uintmax_t j = 0; j < coef.size(); ++j) {
+                coef[j] = batch(r, j);
+            }
+            put(coef.data(), coef.size());
+        }
+    }
+
+    /**
+     * Writes buffered output to the stream and flushes it.
+     */
+    void flush() {
+        m_os.write(m_buf.data(), static_cast<std::streamsize>(m_buf.size()));
+        m_buf.clear();
+        m_os.flush();
+    }
+};
+
+using gfpoly_writer = basic_gfpoly_writer<gf>;
+
+#undef CHECK_FIELD
+
+} // namespace irrpoly
@@ -0,0 +1,232 @@
+/**
+ * @file    gfmod.hpp
+ * @author  Vadim Piven <vadim@piven.tech>
+ * @license Free use of this library is permitted under the
+ * guidelines and in accordance with the MIT License (MIT).
+ * @url     https://github.com/irreducible-polynoms/irrpoly
+ */
+
+#pragma once
+
+#include "gfpoly.hpp"
+#include "biguint.hpp"
+#include "stop.hpp"
+#include "stats.hpp"
+
+#include <vector>
+#include <stdexcept>
+#include <cstdint>
+
+namespace irrpoly {
+
+/**
+ * Binary operations for two gfn instances are correctly defined only
+ * when field is the same for both of them. By default this is checked
+ * only in Debug configuration and no checks performed in Release to speed
+ * up computations. If you are not sure in correctness of your code add
+ * #define IRRPOLY_RELEASE_CHECKED before #include <irrpoly.h> to enable
+ * checks for Release configuration.
+ */
+#if !defined(NDEBUG) || defined(IRRPOLY_RELEASE_CHECKED) // Debug or Release Checked
+#define CHECK_FIELD(comparison) \
+    if (!(comparison)) { \
+        throw std::logic_error("field check failed"); \
+    }
+#else // Release
+#define CHECK_FIELD(comparison)
+#endif
+
+/**
+ * basic_gfmod is a modulus context for repeated reductions by the same polynomial f.
+ * Modulus is normalized once (remainder by monic polynomial is the same but
+ * division by it needs no multiplicative inverses), for large degrees reciprocal
+ * of reversed f is precomputed, so reduction of a product is the Barrett reduction
+ * costing two multiplications (see detail::barrett_division). Operations reuse
+ * internal buffers, so object must not be used by several threads at once,
+ * copy it for each thread instead.
+ */
+template<typename Field>
+class basic_gfmod final {
+private:
+    basic_gfpoly<Field> m_mod; ///< normalized modulus
+    std::vector<uintmax_t> m_inv; ///< reciprocal of reversed modulus, empty for small degrees
+    mutable std::vector<uintmax_t> m_buf; ///< product buffer
+    mutable detail::division_scratch m_scratch; ///< Barrett reduction buffers
+
+    void reduce_data(std::vector<uintmax_t> &u) const {
+        const auto n = m_mod.degree();
+        if (u.size() <= n) {
+            return;
+        }
+        if (!m_inv.empty() && u.size() - n >= detail::newton_threshold && u.size() - n <= m_inv.size()) {
+            detail::barrett_division(m_mod.field(), u, m_mod.m_data, m_inv, nullptr, m_scratch);
+        } else {
+            detail::long_division(m_mod.field(), u, m_mod.m_data, 1, nullptr);
+        }
+    }
+
+    template<typename Bits>
+    auto pow_impl(basic_gfpoly<Field> val, uintmax_t len, const Bits &bit) const -> basic_gfpoly<Field> {
+        reduce(val);
+        basic_gfpoly<Field> res(m_mod.field(), 1);
+        for (; len > 0; --len) {
+            detail::throw_if_stopped();
+            detail::count(counter::pow_steps);
+            sqrmod_inplace(res);
+            if (bit(len - 1)) {
+                mulmod_inplace(res, val);
+            }
+        }
+        return reduce(res);
+    }
+
+    template<typename Bits>
+    auto x_pow_impl(uintmax_t len, const Bits &bit) const -> basic_gfpoly<Field> {
+        const auto n = m_mod.degree();
+        basic_gfpoly<Field> res(m_mod.field(), 1);
+        for (; len > 0; --len) {
+            detail::throw_if_stopped();
+            detail::count(counter::x_pow_steps);
+            sqrmod_inplace(res);
+            // multiplication by x is a shift followed by single reduction step
+            if (bit(len - 1)) {
+                res <<= 1U;
+                if (res.size() > n) {
+                    reduce(res);
+                }
+            }
+        }
+        return reduce(res);
+    }
+
+    [[nodiscard]]
+    static auto bit_length(uintmax_t pow) -> uintmax_t {
+        uintmax_t len = 0;
+        for (; pow; pow >>= 1U) {
+            ++len;
+        }
+        return len;
+    }
+
+public:
+    /**
+     * Creates modulus context for non-zero polynomial mod.
+     */
+    explicit
+    basic_gfmod(const basic_gfpoly<Field> &mod) :
+        m_mod(mod), m_inv(), m_buf(), m_scratch() {
+        if (mod.is_zero()) {
+            throw std::domain_error("modulus must be non-zero");
+        }
+        const auto n = mod.degree();
+        if (m_mod[n] != 1) {
+            m_mod *= mod.field()->mul_inv(mod[n]);
+        }
+        if (n >= detail::newton_threshold) {
+            // products of reduced polynomials need quotients of length below n
+            std::vector<uintmax_t> rv(m_mod.m_data.rbegin(), m_mod.m_data.rend());
+            detail::series_inverse(m_mod.field(), m_inv, rv, n);
+        }
+    }
+
+    /**
+     * Returns normalized modulus.
+     */
+    [[nodiscard]]
+    auto modulus() const -> const basic_gfpoly<Field> & {
+        return m_mod;
+    }
+
+    [[nodiscard]]
+    auto field() const -> const Field & {
+        return m_mod.field();
+    }
+
+    [[nodiscard]]
+    auto degree() const -> uintmax_t {
+        return m_mod.degree();
+    }
+
+    /**
+     * Replaces val by val % f.
+     */
+    auto reduce(basic_gfpoly<Field> &val) const -> basic_gfpoly<Field> & {
+        CHECK_FIELD(field() == val.field())
+        reduce_data(val.m_data);
+        return val;
+    }
+
+    /**
+     * Replaces a by a * b % f, buffers are reused.
+     */
+    auto mulmod_inplace(basic_gfpoly<Field> &a, const basic_gfpoly<Field> &b) const -> basic_gfpoly<Field> & {
+        CHECK_FIELD(field() == a.field() && field() == b.field())
+        detail::poly_mul(m_mod.field(), m_buf, a.m_data, b.m_data);
+        a.m_data.swap(m_buf);
+        reduce_data(a.m_data);
+        return a;
+    }
+
+    /**
+     * Replaces a by a^2 % f, buffers are reused.
+     */
+    auto sqrmod_inplace(basic_gfpoly<Field> &a) const -> basic_gfpoly<Field> & {
+        return mulmod_inplace(a, a);
+    }
+
+    /**
+     * Returns a * b % f.
+     */
+    [[nodiscard]]
+    auto mulmod(basic_gfpoly<Field> a, const basic_gfpoly<Field> &b) const -> basic_gfpoly<Field> {
+        return mulmod_inplace(a, b);
+    }
+
+    /**
+     * Returns a^2 % f.
+     */
+    [[nodiscard]]
+    auto sqrmod(basic_gfpoly<Field> a) const -> basic_gfpoly<Field> {
+        return sqrmod_inplace(a);
+    }
+
+    /**
+     * Returns val^pow % f by binary exponentiation.
+     */
+    [[nodiscard]]
+    auto powmod(basic_gfpoly<Field> val, const uintmax_t pow) const -> basic_gfpoly<Field> {
+        return pow_impl(std::move(val), bit_length(pow),
+                        [pow](uintmax_t i) { return (pow >> i) & 1U; });
+    }
+
+    /**
+     * Returns val^pow % f for exponents exceeding uintmax_t, such as P^n - 1.
+     */
+    [[nodiscard]]
+    auto powmod(basic_gfpoly<Field> val, const detail::biguint &pow) const -> basic_gfpoly<Field> {
+        return pow_impl(std::move(val), pow.bit_length(),
+                        [&pow](uintmax_t i) { return pow.bit(i); });
+    }
+
+    /**
+     * Returns x^pow % f, multiplication by x is a shift and not a full multiplication.
+     */
+    [[nodiscard]]
+    auto x_powmod(const uintmax_t pow) const -> basic_gfpoly<Field> {
+        return x_pow_impl(bit_length(pow), [pow](uintmax_t i) { return (pow >> i) & 1U; });
+    }
+
+    /**
+     * Returns x^pow % f for exponents exceeding uintmax_t.
+     */
+    [[nodiscard]]
+    auto x_powmod(const detail::biguint &pow) const -> basic_gfpoly<Field> {
+        return x_pow_impl(pow.bit_length(), [&pow](uintmax_t i) { return pow.bit(i); });
+    }
+};
+
+using gfmod = basic_gfmod<gf>;
+
+#undef CHECK_FIELD
+
+} // namespace irrpoly
@@ -0,0 +1,516 @@
+/**
+ * @file    gfmul.hpp
+ * @author  Vadim Piven <vadim@piven.tech>
+ * @license Free use of this library is permitted under the
+ * guidelines and in accordance with the MIT License (MIT).
+ * @url     https://github.com/irreducible-polynoms/irrpoly
+ */
+
+#pragma once
+
+#include "gf.hpp"
+#include "stats.hpp"
+
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+#include <type_traits>
+
+namespace irrpoly::detail {
+
+/**
+ * Products with both operands of at least this length use Karatsuba method,
+ * shorter ones use schoolbook multiplication. Must be at least 2.
+ * Could be changed before computations are started, default value is picked
+ * by the "multiplication tiers" benchmark.
+ */
+inline uintmax_t karatsuba_threshold = 64;
+
+/**
+ * Products with both operands of at least this length use number theoretic transform,
+ * which is available when field base is below 2^31. Default value is picked by the
+ * "multiplication tiers" benchmark.
+ */
+inline uintmax_t ntt_threshold = 3072;
+
+/**
+ * Division with both divisor degree and quotient length of at least this uses
+ * Newton iteration for the reciprocal of divisor, otherwise long division is used.
+ * Default value is picked by the "multiplication tiers" benchmark.
+ */
+inline uintmax_t newton_threshold = 4096;
+
+/**
+ * Whether residues are integers modulo field base, so that sums and products could
+ * be accumulated in machine words and reduced later. False for extension fields,
+ * which residues are packed polynomials (see gfext).
+ */
+template<typename Field>
+[[nodiscard]]
+auto integer_residues(const Field &field) -> bool {
+    return field->characteristic() == field->base();
+}
+
+/**
+ * Row operation dst[i] -= coef * src[i] for reduced residues, applied to len elements.
+ * When products fit machine word (base < 2^32) subtraction is replaced by addition
+ * of (P - coef) * src[i], so every element costs one multiply-add and single reduction
+ * without branches, and compiler is free to unroll and vectorize the loop.
+ */
+template<typename Field>
+void row_sub_mul(const Field &field, uintmax_t *dst, const uintmax_t *src,
+                 const uintmax_t coef, const uintmax_t len) {
+    const auto P = field->base();
+    if (P <= UINT32_MAX && integer_residues(field)) {
+        const auto neg = field->neg(coef);
+        for (uintmax_t i = 0; i < len; ++i) {
+            dst[i] = field->reduce(dst[i] + neg * src[i]);
+        }
+        return;
+    }
+    for (uintmax_t i = 0; i < len; ++i) {
+        dst[i] = field->sub(dst[i], field->mul(coef, src[i]));
+    }
+}
+
+/**
+ * Returns how many products of reduced residues could be added to a reduced residue
+ * without overflow of uintmax_t, so reductions could be delayed until that many
+ * accumulations are done. Zero when products don't fit machine word (base > 2^32)
+ * or residues are not integers (see integer_residues).
+ */
+template<typename Field>
+[[nodiscard]]
+auto lazy_bound(const Field &field) -> uintmax_t {
+    const auto P = field->base();
+    if (P > UINT32_MAX || !integer_residues(field)) {
+        return 0;
+    }
+    return (UINTMAX_MAX - (P - 1)) / ((P - 1) * (P - 1));
+}
+
+/**
+ * Row operation dst[i] += coef * src[i] without reduction, see lazy_bound.
+ * There are no branches and no divisions, so the loop is vectorized.
+ */
+inline void row_add_mul_lazy(uintmax_t *dst, const uintmax_t *src,
+                             const uintmax_t coef, const uintmax_t len) {
+    for (uintmax_t i = 0; i < len; ++i) {
+        dst[i] += coef * src[i];
+    }
+}
+
+/**
+ * Reduces len elements accumulated by row_add_mul_lazy.
+ */
+template<typename Field>
+void reduce_range(const Field &field, uintmax_t *dst, const uintmax_t len) {
+    for (uintmax_t i = 0; i < len; ++i) {
+        dst[i] = field->reduce(dst[i]);
+    }
+}
+
+/**
+ * res[0, na + nb - 1) += a * b using schoolbook method.
+ * Products are accumulated without reduction while lazy_bound allows, for small
+ * bases the whole product costs a single reduction per coefficient.
+ */
+template<typename Field>
+void mul_add_schoolbook(const Field &field, uintmax_t *res,
+                        const uintmax_t *a, const uintmax_t na,
+                        const uintmax_t *b, const uintmax_t nb) {
+    const auto bound = lazy_bound(field);
+    if (bound < 2) {
+        for (uintmax_t i = 0; i < na; ++i) {
+            if (a[i]) {
+                // res[i + j] -= (-a[i]) * b[j]
+                row_sub_mul(field, res + i, b, field->neg(a[i]), nb);
+            }
+        }
+        return;
+    }
+    // rows [first, i) were accumulated since the last reduction
+    uintmax_t first = 0;
+    for (uintmax_t i = 0; i < na; ++i) {
+        if (i - first == bound) {
+            reduce_range(field, res + first, i - first + nb - 1);
+            first = i;
+        }
+        if (a[i]) {
+            row_add_mul_lazy(res + i, b, a[i], nb);
+        }
+    }
+    reduce_range(field, res + first, na - first + nb - 1);
+}
+
+template<typename Field>
+void mul_add(const Field &field, uintmax_t *res,
+             const uintmax_t *a, uintmax_t na,
+             const uintmax_t *b, uintmax_t nb);
+
+/**
+ * res[0, 2n - 1) += a * b, both operands have length n, using Karatsuba method:
+ * (a0 + x^h a1)(b0 + x^h b1) = z0 + x^h ((a0 + a1)(b0 + b1) - z0 - z2) + x^2h z2.
+ */
+template<typename Field>
+void mul_add_karatsuba(const Field &field, uintmax_t *res,
+                       const uintmax_t *a, const uintmax_t *b, const uintmax_t n) {
+    const uintmax_t h = n / 2, k = n - h;
+    std::vector<uintmax_t> sa(k), sb(k), z0(2 * h - 1, 0), z1(2 * k - 1, 0), z2(2 * k - 1, 0);
+    for (uintmax_t i = 0; i < k; ++i) {
+        sa[i] = (i < h) ? field->add(a[i], a[h + i]) : a[h + i];
+        sb[i] = (i < h) ? field->add(b[i], b[h + i]) : b[h + i];
+    }
+    mul_add(field, z0.data(), a, h, b, h);
+    mul_add(field, z2.data(), a + h, k, b + h, k);
+    mul_add(field, z1.data(), sa.data(), k, sb.data(), k);
+    for (uintmax_t i = 0; i < z0.size(); ++i) {
+        z1[i] = field->sub(z1[i], z0[i]);
+        res[i] = field->add(res[i], z0[i]);
+    }
+    for (uintmax_t i = 0; i < z2.size(); ++i) {
+        z1[i] = field->sub(z1[i], z2[i]);
+        res[2 * h + i] = field->add(res[2 * h + i], z2[i]);
+    }
+    for (uintmax_t i = 0; i < z1.size(); ++i) {
+        res[h + i] = field->add(res[h + i], z1[i]);
+    }
+}
+
+/**
+ * res[0, na + nb - 1) += a * b, selects schoolbook or Karatsuba method.
+ * Unbalanced operands are split by the length of the shorter one.
+ */
+template<typename Field>
+void mul_add(const Field &field, uintmax_t *res,
+             const uintmax_t *a, uintmax_t na,
+             const uintmax_t *b, uintmax_t nb) {
+    if (na < nb) {
+        std::swap(a, b);
+        std::swap(na, nb);
+    }
+    if (nb < std::max<uintmax_t>(2, karatsuba_threshold)) {
+        mul_add_schoolbook(field, res, b, nb, a, na);
+        return;
+    }
+    for (uintmax_t off = 0; off < na; off += nb) {
+        const auto len = std::min(nb, na - off);
+        if (len == nb) {
+            mul_add_karatsuba(field, res + off, a + off, b, nb);
+        } else {
+            mul_add(field, res + off, a + off, len, b, nb);
+        }
+    }
+}
+
+/**
+ * Primes of the form c * 2^k + 1 with primitive root 3. Product of the three exceeds
+ * 2^86, so coefficients of product of polynomials with length up to 2^23 over
+ * field with base below 2^31 are recovered exactly by the Chinese remainder theorem.
+ */
+constexpr std::array<uint32_t, 3> ntt_primes = {998244353U, 167772161U, 469762049U};
+constexpr uintmax_t ntt_max_size = uintmax_t(1) << 23U;
+
+constexpr auto pow_mod32(uint64_t b, uint64_t e, const uint32_t m) -> uint32_t {
+    uint64_t r = 1;
+    for (b %= m; e; e >>= 1U, b = b * b % m) {
+        if (e & 1U) {
+            r = r * b % m;
+        }
+    }
+    return static_cast<uint32_t>(r);
+}
+
+/**
+ * In-place iterative number theoretic transform modulo prime m, size is a power of two.
+ * Modulus is a template parameter, so compiler replaces divisions by multiplications.
+ */
+template<uint32_t m>
+void ntt(std::vector<uint32_t> &a, const bool invert) {
+    const auto n = a.size();
+    for (std::size_t i = 1, j = 0; i < n; ++i) {
+        auto bit = n >> 1U;
+        for (; j & bit; bit >>= 1U) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            std::swap(a[i], a[j]);
+        }
+    }
+    for (std::size_t len = 2; len <= n; len <<= 1U) {
+        auto w = pow_mod32(3, (m - 1) / len, m);
+        if (invert) {
+            w = pow_mod32(w, m - 2, m);
+        }
+        for (std::size_t i = 0; i < n; i += len) {
+            uint64_t wk = 1;
+            for (std::size_t j = 0; j < len / 2; ++j, wk = wk * w % m) {
+                const uint32_t u = a[i + j];
+                const auto v = static_cast<uint32_t>(a[i + j + len / 2] * wk % m);
+                a[i + j] = (u + v >= m) ? u + v - m : u + v;
+                a[i + j + len / 2] = (u >= v) ? u - v : u + m - v;
+            }
+        }
+    }
+    if (invert) {
+        const uint64_t inv = pow_mod32(n, m - 2, m);
+        for (auto &x : a) {
+            x = static_cast<uint32_t>(x * inv % m);
+        }
+    }
+}
+
+/**
+ * Whether a * b could be computed by mul_ntt.
+ */
+template<typename Field>
+[[nodiscard]]
+auto ntt_applicable(const Field &field, const uintmax_t na, const uintmax_t nb) -> bool {
+    return field->base() < (uintmax_t(1) << 31U) && integer_residues(field) &&
+           na + nb - 1 <= ntt_max_size;
+}
+
+/**
+ * res[0, na + nb - 1) = a * b using transforms modulo three primes and CRT,
+ * squaring is detected and needs one forward transform per prime instead of two.
+ */
+template<typename Field>
+void mul_ntt(const Field &field, uintmax_t *res,
+             const uintmax_t *a, const uintmax_t na,
+             const uintmax_t *b, const uintmax_t nb) {
+    const bool square = (a == b && na == nb);
+    std::size_t size = 1;
+    while (size < na + nb - 1) {
+        size <<= 1U;
+    }
+    std::array<std::vector<uint32_t>, 3> r;
+    std::vector<uint32_t> fb;
+    auto transform = [&](auto prime, std::vector<uint32_t> &fa) {
+        constexpr uint32_t m = decltype(prime)::value;
+        fa.assign(size, 0);
+        for (uintmax_t i = 0; i < na; ++i) {
+            fa[i] = static_cast<uint32_t>(a[i] % m);
+        }
+        ntt<m>(fa, false);
+        if (square) {
+            for (auto &x : fa) {
+                x = static_cast<uint32_t>(uint64_t(x) * x % m);
+            }
+        } else {
+            fb.assign(size, 0);
+            for (uintmax_t i = 0; i < nb; ++i) {
+                fb[i] = static_cast<uint32_t>(b[i] % m);
+            }
+            ntt<m>(fb, false);
+            for (std::size_t i = 0; i < size; ++i) {
+                fa[i] = static_cast<uint32_t>(uint64_t(fa[i]) * fb[i] % m);
+            }
+        }
+        ntt<m>(fa, true);
+    };
+    transform(std::integral_constant<uint32_t, ntt_primes[0]>(), r[0]);
+    transform(std::integral_constant<uint32_t, ntt_primes[1]>(), r[1]);
+    transform(std::integral_constant<uint32_t, ntt_primes[2]>(), r[2]);
+
+    // Garner's algorithm: x = r0 + m0 * t1 + m0 * m1 * t2, evaluated modulo field base
+    constexpr uint64_t m0 = ntt_primes[0], m1 = ntt_primes[1], m2 = ntt_primes[2];
+    constexpr uint64_t m0_inv = pow_mod32(m0, m1 - 2, m1);
+    constexpr uint64_t m01_inv = pow_mod32(m0 * m1 % m2, m2 - 2, m2);
+    const auto m01_p = field->reduce(m0 * m1);
+    for (uintmax_t i = 0; i < na + nb - 1; ++i) {
+        const uint64_t r0 = r[0][i], r1 = r[1][i], r2 = r[2][i];
+        const auto t1 = (r1 + m1 - r0 % m1) % m1 * m0_inv % m1;
+        const auto x01 = r0 + m0 * t1; // below m0 * m1 < 2^60
+        const auto t2 = (r2 + m2 - x01 % m2) % m2 * m01_inv % m2;
+        res[i] = field->add(field->reduce(x01), field->mul(m01_p, field->reduce(t2)));
+    }
+}
+
+/**
+ * Stores a * b into res buffer, which must not be a or b. Selects multiplication
+ * method by the length of the shorter operand, result is trimmed.
+ */
+template<typename Field>
+void poly_mul(const Field &field, std::vector<uintmax_t> &res,
+              const std::vector<uintmax_t> &a, const std::vector<uintmax_t> &b) {
+    if (a.empty() || b.empty()) {
+        res.clear();
+        return;
+    }
+    count(counter::multiplications);
+    if (res.capacity() < a.size() + b.size() - 1) {
+        count(counter::allocations);
+    }
+    res.assign(a.size() + b.size() - 1, 0);
+    if (std::min(a.size(), b.size()) >= ntt_threshold &&
+        ntt_applicable(field, a.size(), b.size())) {
+        mul_ntt(field, res.data(), a.data(), a.size(), b.data(), b.size());
+    } else {
+        mul_add(field, res.data(), a.data(), a.size(), b.data(), b.size());
+    }
+    while (!res.empty() && res.back() == 0) {
+        res.pop_back();
+    }
+}
+
+/**
+ * Stores f^-1 mod x^k into g, f[0] must be non-zero.
+ * Newton iteration g = g * (2 - f * g) doubles the number of correct terms each step.
+ */
+template<typename Field>
+void series_inverse(const Field &field, std::vector<uintmax_t> &g,
+                    const std::vector<uintmax_t> &f, const uintmax_t k) {
+    g.assign(1, field->mul_inv(f[0]));
+    std::vector<uintmax_t> head, t, e;
+    for (uintmax_t len = 1; len < k;) {
+        len = std::min(2 * len, k);
+        head.assign(f.begin(), f.begin() + std::min<uintmax_t>(len, f.size()));
+        poly_mul(field, t, head, g);
+        t.resize(len, 0);
+        for (auto &x : t) {
+            x = field->neg(x);
+        }
+        t[0] = field->add(t[0], field->reduce(2 % field->characteristic()));
+        poly_mul(field, e, g, t);
+        e.resize(len, 0);
+        g.swap(e);
+    }
+}
+
+/**
+ * Replaces u by u % v, if q is provided stores u / v into it, requires deg(u) >= deg(v).
+ * inv is the inverse of leading coefficient of v, so there are no divisions inside
+ * the loop. Reduction is delayed while lazy_bound allows, only the leading term
+ * is reduced at each step.
+ */
+template<typename Field>
+void long_division(const Field &field, std::vector<uintmax_t> &u,
+                   const std::vector<uintmax_t> &v, const uintmax_t inv,
+                   std::vector<uintmax_t> *q) {
+    const uintmax_t m = u.size() - 1, n = v.size() - 1;
+    count(counter::remainders);
+    if (q) {
+        q->assign(m - n + 1, 0);
+    }
+    const auto bound = lazy_bound(field);
+    if (bound < 2) {
+        for (uintmax_t k = m - n + 1; k > 0;) {
+            --k;
+            const auto c = (inv == 1) ? u[n + k] : field->mul(u[n + k], inv);
+            if (q) {
+                (*q)[k] = c;
+            }
+            if (c) {
+                row_sub_mul(field, u.data() + k, v.data(), c, n);
+            }
+        }
+    } else {
+        // pending steps since the last reduction have touched u[k + 1, top)
+        uintmax_t pending = 0, top = 0;
+        for (uintmax_t k = m - n + 1; k > 0;) {
+            --k;
+            if (pending == bound) {
+                reduce_range(field, u.data() + k + 1, top - k - 1);
+                pending = 0;
+            }
+            u[n + k] = field->reduce(u[n + k]);
+            const auto c = (inv == 1) ? u[n + k] : field->mul(u[n + k], inv);
+            if (q) {
+                (*q)[k] = c;
+            }
+            if (c) {
+                if (!pending) {
+                    top = n + k;
+                }
+                row_add_mul_lazy(u.data() + k, v.data(), field->neg(c), n);
+                ++pending;
+            }
+        }
+        reduce_range(field, u.data(), n);
+    }
+    u.resize(n);
+    while (!u.empty() && u.back() == 0) {
+        u.pop_back();
+    }
+}
+
+/**
+ * Buffers of barrett_division, kept by the caller to avoid allocations.
+ */
+struct division_scratch {
+    std::vector<uintmax_t> top, inv, quot, prod;
+};
+
+/**
+ * Replaces u by u % v, if q is provided stores u / v into it, requires deg(u) >= deg(v).
+ * inv is the reciprocal of reversed v modulo x^k (see series_inverse), k must be
+ * at least the quotient length deg(u) - deg(v) + 1. Quotient is computed as reversed
+ * product of reversed u and inv, so division costs two multiplications.
+ */
+template<typename Field>
+void barrett_division(const Field &field, std::vector<uintmax_t> &u,
+                      const std::vector<uintmax_t> &v, const std::vector<uintmax_t> &inv,
+                      std::vector<uintmax_t> *q, division_scratch &buf) {
+    const uintmax_t m = u.size() - 1, n = v.size() - 1, k = m - n + 1;
+    count(counter::remainders);
+
+    // quotient of length k is determined by the top k terms of u
+    buf.top.assign(u.rbegin(), u.rbegin() + k);
+    buf.inv.assign(inv.begin(), inv.begin() + k);
+    poly_mul(field, buf.quot, buf.top, buf.inv);
+    buf.quot.resize(k, 0);
+    std::reverse(buf.quot.begin(), buf.quot.end());
+    while (!buf.quot.empty() && buf.quot.back() == 0) {
+        buf.quot.pop_back();
+    }
+
+    poly_mul(field, buf.prod, buf.quot, v);
+    for (uintmax_t i = 0; i < n && i < buf.prod.size(); ++i) {
+        u[i] = field->sub(u[i], buf.prod[i]);
+    }
+    u.resize(n);
+    while (!u.empty() && u.back() == 0) {
+        u.pop_back();
+    }
+    if (q) {
+        q->swap(buf.quot);
+    }
+}
+
+/**
+ * Replaces u by u % v, if q is provided stores u / v into it, requires deg(u) >= deg(v).
+ * Uses barrett_division, reciprocal of the last divisor is cached per thread,
+ * so repeated reductions by the same modulus compute it once.
+ */
+template<typename Field>
+void newton_division(const Field &field, std::vector<uintmax_t> &u,
+                     const std::vector<uintmax_t> &v, std::vector<uintmax_t> *q) {
+    struct cache_t {
+        uintmax_t base = 0;
+        std::vector<uintmax_t> divisor, inverse;
+        division_scratch buf;
+    };
+    static thread_local cache_t cache;
+
+    const uintmax_t k = u.size() - v.size() + 1, n = v.size() - 1;
+    if (!integer_residues(field)) {
+        // packed residues depend on the field modulus as well, so base is not a key
+        std::vector<uintmax_t> rv(v.rbegin(), v.rend()), inverse;
+        series_inverse(field, inverse, rv, std::max(k, n));
+        barrett_division(field, u, v, inverse, q, cache.buf);
+        return;
+    }
+    if (cache.base != field->base() || cache.divisor != v || cache.inverse.size() < k) {
+        std::vector<uintmax_t> rv(v.rbegin(), v.rend());
+        series_inverse(field, cache.inverse, rv, std::max(k, n));
+        cache.divisor = v;
+        cache.base = field->base();
+    }
+    barrett_division(field, u, v, cache.inverse, q, cache.buf);
+}
+
+} // namespace irrpoly::detail
@@ -9,6 +9,7 @@
 #pragma once
 
 #include "gf.hpp"
+#include "gfmul.hpp"
 
 #include <vector>
 #include <functional>
@@ -36,30 +37,34 @@ namespace irrpoly {
 #define CHECK_FIELD(comparison)
 #endif
 
+template<typename Field>
+class basic_gfmod;
+
 /**
- * gfpoly represents a polynomial over Galois field.
+ * basic_gfpoly represents a polynomial over Galois field.
  * This class is originally taken from Boost library but was significantly changed.
  * Get by index operation [i] returns polynomial term x^i.
  * Polynomial is either zero or reduced which means that leading term is non-zero.
+ * Field type could be either gf (field base is known at runtime) or
+ * gf_static<P> (field base is known at compile time).
  */
-class gfpoly final {
+template<typename Field>
+class basic_gfpoly final {
 private:
-    gf m_field;
+    Field m_field;
     std::vector<uintmax_t> m_data; ///< polynomial coefficients
 
+    friend class basic_gfmod<Field>;
+
 public:
     /**
-     * Generates random polynomial over provided Galois field of given degree.
+     * Generates random monic polynomial over provided Galois field of given degree
+     * with non-zero constant term using provided generator.
      */
+    template<typename Gen>
     static
-    auto random(const gf &field, uintmax_t degree) -> gfpoly {
-        static std::random_device rd;
-#ifdef __LP64__
-        static std::mt19937_64 gen(rd());
-#else
-        static std::mt19937 gen(rd());
-#endif
-        std::uniform_int_distribution<uint_fast64_t> dis(0, field->base() - 1);
+    auto random(const Field &field, uintmax_t degree, Gen &gen) -> basic_gfpoly {
+        std::uniform_int_distribution<uintmax_t> dis(0, field->base() - 1);
         std::vector<uintmax_t> data;
         data.reserve(degree + 1);
         for (uintmax_t i = 0; i < degree; ++i) {
@@ -69,7 +74,16 @@ public:
         while (data[0] == 0) {
             data[0] = dis(gen);
         }
-        return gfpoly(field, std::move(data));
+        return basic_gfpoly(field, std::move(data));
+    }
+
+    /**
+     * Generates random polynomial using generator of the calling thread,
+     * so it could be called from several threads at once.
+     */
+    static
+    auto random(const Field &field, uintmax_t degree) -> basic_gfpoly {
+        return random(field, degree, detail::thread_engine());
     }
 
     [[nodiscard]]
@@ -81,7 +95,7 @@ private:
     /**
      * Removes leading zeroes.
      */
-    auto reduce() -> gfpoly & {
+    auto reduce() -> basic_gfpoly & {
         m_data.erase(std::find_if(
             m_data.rbegin(), m_data.rend(),
             [](uintmax_t x) { return x != 0; }
@@ -91,45 +105,49 @@ private:
 
 public:
     explicit
-    gfpoly(const gf &field) : m_field(field), m_data() {}
+    basic_gfpoly(const Field &field) : m_field(field), m_data() {}
 
-    gfpoly(const gf &field, const std::vector<uintmax_t> &l) :
+    basic_gfpoly(const Field &field, const std::vector<uintmax_t> &l) :
         m_field(field), m_data() {
         m_data.reserve(l.size());
         for (uintmax_t v : l) {
-            m_data.push_back(v % base());
+            m_data.push_back(m_field->reduce(v));
         }
         reduce();
     }
 
-    gfpoly(const gf &field, std::vector<uintmax_t> &&l) :
+    basic_gfpoly(const Field &field, std::vector<uintmax_t> &&l) :
         m_field(field), m_data(l) {
         for (uintmax_t &v : m_data) {
-            v %= base();
+            v = m_field->reduce(v);
         }
         reduce();
     }
 
-    auto operator=(const std::vector<uintmax_t> &l) -> gfpoly & {
-        gfpoly copy(m_field, l);
-        std::swap(*this, copy);
-        return *this;
+    auto operator=(const std::vector<uintmax_t> &l) -> basic_gfpoly & {
+        if (&l != &m_data) {
+            m_data.assign(l.begin(), l.end()); // reuses existing buffer
+        }
+        for (uintmax_t &v : m_data) {
+            v = m_field->reduce(v);
+        }
+        return reduce();
     }
 
-    gfpoly(const gf &field, std::initializer_list<uintmax_t> l) :
-        gfpoly(field, std::move(std::vector<uintmax_t>{l})) {}
+    basic_gfpoly(const Field &field, std::initializer_list<uintmax_t> l) :
+        basic_gfpoly(field, std::move(std::vector<uintmax_t>{l})) {}
 
-    auto operator=(std::initializer_list<uintmax_t> l) -> gfpoly & {
-        gfpoly copy(m_field, l);
+    auto operator=(std::initializer_list<uintmax_t> l) -> basic_gfpoly & {
+        basic_gfpoly copy(m_field, l);
         std::swap(*this, copy);
         return *this;
     }
 
-    gfpoly(const gfpoly &p) = default;
+    basic_gfpoly(const basic_gfpoly &p) = default;
 
-    gfpoly(gfpoly &&p) = default;
+    basic_gfpoly(basic_gfpoly &&p) = default;
 
-    auto operator=(const gfpoly &p) -> gfpoly & {
+    auto operator=(const basic_gfpoly &p) -> basic_gfpoly & {
         if (this != &p) {
             // m_field == nullptr means that gfn instance is uninitialised
             // this happens during std::move, std::swap and inside some std::vector methods
@@ -140,38 +158,57 @@ public:
         return *this;
     }
 
+    auto operator=(basic_gfpoly &&p) -> basic_gfpoly & {
+        if (this != &p) {
+            CHECK_FIELD(m_field == nullptr || m_field == p.m_field)
+            m_field = std::move(p.m_field);
+            m_data = std::move(p.m_data);
+        }
+        return *this;
+    }
+
+    /**
+     * Exchanges polynomials without copying coefficients, buffers are exchanged too.
+     */
+    friend
+    void swap(basic_gfpoly &a, basic_gfpoly &b) noexcept {
+        using std::swap;
+        swap(a.m_field, b.m_field);
+        a.m_data.swap(b.m_data);
+    }
+
     explicit
-    gfpoly(const gfn &value) :
+    basic_gfpoly(const basic_gfn<Field> &value) :
         m_field(value.field()), m_data() {
         if (value) {
             m_data.push_back(value.value());
         }
     }
 
-    auto operator=(const gfn &value) -> gfpoly & {
+    auto operator=(const basic_gfn<Field> &value) -> basic_gfpoly & {
         // m_field == nullptr means that gfn instance is uninitialised
         // this happens during std::move, std::swap and inside some std::vector methods
         CHECK_FIELD(m_field == nullptr || m_field == value.field())
-        gfpoly copy(value);
+        basic_gfpoly copy(value);
         std::swap(*this, copy);
         return *this;
     }
 
-    gfpoly(const gf &field, uintmax_t value) :
+    basic_gfpoly(const Field &field, uintmax_t value) :
         m_field(field), m_data() {
-        if (value % base() != 0) {
-            m_data.push_back(value % base());
+        if (m_field->reduce(value) != 0) {
+            m_data.push_back(m_field->reduce(value));
         }
     }
 
-    auto operator=(uintmax_t value) -> gfpoly & {
-        gfpoly copy(m_field, value);
+    auto operator=(uintmax_t value) -> basic_gfpoly & {
+        basic_gfpoly copy(m_field, value);
         std::swap(*this, copy);
         return *this;
     }
 
     [[nodiscard]]
-    auto field() const -> const gf & {
+    auto field() const -> const Field & {
         return m_field;
     }
 
@@ -214,11 +251,33 @@ public:
     }
 
     [[maybe_unused]]
-    auto set_zero() -> gfpoly & {
+    auto set_zero() -> basic_gfpoly & {
         m_data.clear();
         return *this;
     }
 
+    /**
+     * Returns polynomial value at point x by Horner's method,
+     * see irrpoly::eval for evaluation at many points.
+     */
+    [[nodiscard]]
+    auto eval(const uintmax_t x) const -> uintmax_t {
+        const auto px = m_field->reduce(x);
+        const bool lazy = detail::lazy_bound(m_field) > 0;
+        uintmax_t acc = 0;
+        for (auto i = size(); i > 0; --i) {
+            acc = lazy ? m_field->reduce(acc * px + m_data[i - 1])
+                       : m_field->add(m_field->mul(acc, px), m_data[i - 1]);
+        }
+        return acc;
+    }
+
+    [[nodiscard]]
+    auto eval(const basic_gfn<Field> &x) const -> basic_gfn<Field> {
+        CHECK_FIELD(field() == x.field())
+        return basic_gfn<Field>(m_field, eval(x.value()));
+    }
+
 private:
     /**
      * UNSAFE! Requires lb and rb to lay between 0 and base().
@@ -226,7 +285,7 @@ private:
      */
     [[nodiscard]]
     auto add(uintmax_t lb, uintmax_t rb) const -> uintmax_t {
-        return (lb + rb) % base();
+        return m_field->add(lb, rb);
     }
 
     /**
@@ -235,7 +294,7 @@ private:
      */
     [[nodiscard]]
     auto sub(uintmax_t lb, uintmax_t rb) const -> uintmax_t {
-        return (base() + lb - rb) % base();
+        return m_field->sub(lb, rb);
     }
 
     /**
@@ -244,7 +303,7 @@ private:
      */
     [[nodiscard]]
     auto mul(uintmax_t lb, uintmax_t rb) const -> uintmax_t {
-        return (lb * rb) % base();
+        return m_field->mul(lb, rb);
     }
 
     /**
@@ -255,7 +314,7 @@ private:
     auto div(uintmax_t lb, uintmax_t rb) const -> uintmax_t {
         switch (rb) {
         case 0:throw std::invalid_argument("division by zero");
-        default:return (lb * field()->mul_inv(rb)) % base();
+        default:return m_field->mul(lb, m_field->mul_inv(rb));
         }
     }
 
@@ -265,20 +324,20 @@ private:
      */
     [[nodiscard]]
     auto neg(uintmax_t rb) const -> uintmax_t {
-        return (base() - rb) % base();
+        return m_field->neg(rb);
     }
 
-    using OP = uintmax_t (gfpoly::*)(uintmax_t, uintmax_t) const;
+    using OP = uintmax_t (basic_gfpoly::*)(uintmax_t, uintmax_t) const;
 
-    auto transform(uintmax_t value, OP op) -> gfpoly & {
+    auto transform(uintmax_t value, OP op) -> basic_gfpoly & {
         if (m_data.empty()) {
             m_data.resize(1, 0);
         }
-        m_data[0] = std::invoke(op, this, m_data[0], value);
+        m_data[0] = std::invoke(op, this, m_data[0], m_field->reduce(value));
         return reduce();
     }
 
-    auto transform(const gfn &value, OP op) -> gfpoly & {
+    auto transform(const basic_gfn<Field> &value, OP op) -> basic_gfpoly & {
         CHECK_FIELD(field() == value.field())
         if (m_data.empty()) {
             m_data.resize(1, 0);
@@ -287,7 +346,7 @@ private:
         return reduce();
     }
 
-    auto transform(const gfpoly &value, OP op) -> gfpoly & {
+    auto transform(const basic_gfpoly &value, OP op) -> basic_gfpoly & {
         CHECK_FIELD(field() == value.field())
         if (m_data.size() < value.size()) {
             m_data.resize(value.size(), 0);
@@ -299,138 +358,168 @@ private:
     }
 
 public:
-    auto operator+=(uintmax_t value) -> gfpoly & {
-        return transform(value, &gfpoly::add);
+    auto operator+=(uintmax_t value) -> basic_gfpoly & {
+        return transform(value, &basic_gfpoly::add);
     }
 
-    auto operator+=(const gfn &value) -> gfpoly & {
-        return transform(value.value(), &gfpoly::add);
+    auto operator+=(const basic_gfn<Field> &value) -> basic_gfpoly & {
+        return transform(value.value(), &basic_gfpoly::add);
     }
 
-    auto operator+=(const gfpoly &value) -> gfpoly & {
-        return transform(value, &gfpoly::add);
+    auto operator+=(const basic_gfpoly &value) -> basic_gfpoly & {
+        return transform(value, &basic_gfpoly::add);
     }
 
-    auto operator-=(uintmax_t value) -> gfpoly & {
-        return transform(value, &gfpoly::sub);
+    auto operator-=(uintmax_t value) -> basic_gfpoly & {
+        return transform(value, &basic_gfpoly::sub);
     }
 
-    auto operator-=(const gfn &value) -> gfpoly & {
-        return transform(value.value(), &gfpoly::sub);
+    auto operator-=(const basic_gfn<Field> &value) -> basic_gfpoly & {
+        return transform(value.value(), &basic_gfpoly::sub);
     }
 
-    auto operator-=(const gfpoly &value) -> gfpoly & {
-        return transform(value, &gfpoly::sub);
+    auto operator-=(const basic_gfpoly &value) -> basic_gfpoly & {
+        return transform(value, &basic_gfpoly::sub);
     }
 
-    auto operator*=(uintmax_t value) -> gfpoly & {
+    auto operator*=(uintmax_t value) -> basic_gfpoly & {
+        value = m_field->reduce(value);
         std::transform(m_data.begin(), m_data.end(), m_data.begin(),
                        [&](uintmax_t x) -> uintmax_t { return mul(x, value); });
         return reduce();
     }
 
-    auto operator*=(const gfn &value) -> gfpoly & {
+    auto operator*=(const basic_gfn<Field> &value) -> basic_gfpoly & {
         std::transform(m_data.begin(), m_data.end(), m_data.begin(),
                        [&](uintmax_t x) -> uintmax_t { return mul(x, value.value()); });
         return reduce();
     }
 
-    auto operator/=(uintmax_t value) -> gfpoly & {
+    auto operator/=(uintmax_t value) -> basic_gfpoly & {
+        value = m_field->reduce(value);
         std::transform(m_data.begin(), m_data.end(), m_data.begin(),
                        [&](uintmax_t x) -> uintmax_t { return div(x, value); });
         return reduce();
     }
 
-    auto operator/=(const gfn &value) -> gfpoly & {
+    auto operator/=(const basic_gfn<Field> &value) -> basic_gfpoly & {
         std::transform(m_data.begin(), m_data.end(), m_data.begin(),
                        [&](uintmax_t x) -> uintmax_t { return div(x, value.value()); });
         return reduce();
     }
 
     template<class U>
-    auto operator%=(const U & /*value*/) -> gfpoly & {
+    auto operator%=(const U & /*value*/) -> basic_gfpoly & {
         // we can always divide by a scalar, so there is no remainder
         return set_zero();
     }
 
 private:
-    auto multiply(const gfpoly &a, const gfpoly &b) -> gfpoly & {
-        CHECK_FIELD(a.field() == b.field())
-        if (!a || !b) {
-            return set_zero();
-        }
-        std::vector<uintmax_t> prod(a.size() + b.size() - 1, 0);
-        for (uintmax_t i = 0; i < a.size(); ++i) {
-            for (uintmax_t j = 0; j < b.size(); ++j) {
-                prod[i + j] = add(prod[i + j], mul(a.m_data[i], b.m_data[j]));
+    /**
+     * Per-thread buffer for operations which can't be done in place. After the operation
+     * it holds the previous buffer of the polynomial, so memory is recycled and
+     * repeated operations do not allocate.
+     */
+    static auto scratch() -> std::vector<uintmax_t> & {
+        static thread_local std::vector<uintmax_t> buf;
+        return buf;
+    }
+
+    /**
+     * Stores a * b into res buffer, which must not be a or b.
+     * Method is selected by operand lengths, see detail::poly_mul.
+     */
+    static void multiply(const Field &field, std::vector<uintmax_t> &res,
+                         const std::vector<uintmax_t> &a, const std::vector<uintmax_t> &b) {
+        detail::poly_mul(field, res, a, b);
+    }
+
+    /**
+     * Replaces u by u % v, if q is provided stores u / v into it.
+     * Small divisions use detail::long_division, large ones detail::newton_division.
+     */
+    static void division(const Field &field, std::vector<uintmax_t> &u,
+                         const std::vector<uintmax_t> &v, std::vector<uintmax_t> *q) {
+        if (u.size() < v.size()) {
+            if (q) {
+                q->clear();
             }
+            return;
         }
-        m_data.swap(prod);
-        return reduce();
+        const uintmax_t m = u.size() - 1, n = v.size() - 1;
+        if (n >= detail::newton_threshold && m - n + 1 >= detail::newton_threshold) {
+            detail::newton_division(field, u, v, q);
+            return;
+        }
+        detail::long_division(field, u, v, (v[n] == 1) ? 1 : field->mul_inv(v[n]), q);
     }
 
 public:
-    auto operator*=(const gfpoly &value) -> gfpoly & {
-        return multiply(*this, value);
+    auto operator*=(const basic_gfpoly &value) -> basic_gfpoly & {
+        CHECK_FIELD(field() == value.field())
+        auto &buf = scratch();
+        multiply(m_field, buf, m_data, value.m_data);
+        m_data.swap(buf);
+        return *this;
     }
 
-private:
     /**
-     * This is the core method of the whole class. It takes the most time during computations.
-     * TODO: try implementing polynomial division using Discrete Fourier Transform.
+     * Stores a * b into res reusing its buffer. res must not be a or b.
      */
-    static auto division(gfpoly u, const gfpoly &v) -> std::pair<gfpoly, gfpoly> {
-        CHECK_FIELD(u.field() == v.field() && v.size() <= u.size() && v && u)
-        uintmax_t const m = u.size() - 1, n = v.size() - 1;
-        uintmax_t k = m - n;
-        gfpoly q(u.field());
-        q.m_data.resize(m - n + 1, 0);
-
-        auto division_impl = [](gfpoly *q, gfpoly *u, const gfpoly &v, auto n, auto k) {
-            CHECK_FIELD(q->field() == u->field() && u->field() == v.field())
-            q->m_data[k] = q->div(u->m_data[n + k], v.m_data[n]);
-            for (auto j = n + k; j > k;) {
-                j--;
-                u->m_data[j] = u->sub(u->m_data[j],
-                                      q->mul(q->m_data[k], v.m_data[j - k]));
-            }
-        };
-
-        do {
-            division_impl(&q, &u, v, n, k);
-        } while (k-- != 0);
-        u.m_data.resize(n, 0);
-        return std::make_pair(q.reduce(), u.reduce());
+    static void mul_into(basic_gfpoly &res, const basic_gfpoly &a, const basic_gfpoly &b) {
+        CHECK_FIELD(a.field() == b.field() && &res != &a && &res != &b)
+        if (!(res.m_field == a.m_field)) {
+            res.m_field = a.m_field;
+        }
+        multiply(a.m_field, res.m_data, a.m_data, b.m_data);
     }
 
     /**
-     * Calculates a / b and a % b, returning the pair (quotient, remainder) together
-     * because the same amount of computation yields both.
-     * This function is not defined for division by zero: user beware.
+     * Stores u / v into q and u % v into r reusing their buffers.
+     * q and r must be distinct objects, different from u and v.
      */
-    static auto quotient_remainder(const gfpoly &dividend, const gfpoly &divisor)
-    -> std::pair<gfpoly, gfpoly> {
-        CHECK_FIELD(dividend.field() == divisor.field() && divisor)
-        if (dividend.size() < divisor.size()) {
-            return std::make_pair(gfpoly(dividend.field()), dividend);
+    static void divrem_into(basic_gfpoly &q, basic_gfpoly &r,
+                            const basic_gfpoly &u, const basic_gfpoly &v) {
+        CHECK_FIELD(u.field() == v.field() && v && &q != &r && &q != &u && &q != &v &&
+                    &r != &u && &r != &v)
+        if (!(q.m_field == u.m_field)) {
+            q.m_field = u.m_field;
         }
-        return division(dividend, divisor);
+        r = u;
+        division(u.m_field, r.m_data, v.m_data, &q.m_data);
+    }
+
+    /**
+     * Replaces polynomial by the remainder of division by v, quotient is not computed.
+     */
+    auto rem_inplace(const basic_gfpoly &v) -> basic_gfpoly & {
+        CHECK_FIELD(field() == v.field() && v)
+        division(m_field, m_data, v.m_data, nullptr);
+        return *this;
     }
 
 public:
-    auto operator/=(const gfpoly &value) -> gfpoly & {
-        return *this = quotient_remainder(*this, value).first;
+    /**
+     * Division is the core method of the whole class, it takes the most time during
+     * computations. Quotient goes to scratch buffer, remainder is discarded.
+     */
+    auto operator/=(const basic_gfpoly &value) -> basic_gfpoly & {
+        CHECK_FIELD(field() == value.field() && value)
+        auto &buf = scratch();
+        division(m_field, m_data, value.m_data, &buf);
+        m_data.swap(buf);
+        return *this;
     }
 
-    auto operator%=(const gfpoly &value) -> gfpoly & {
-        return *this = quotient_remainder(*this, value).second;
+    auto operator%=(const basic_gfpoly &value) -> basic_gfpoly & {
+        return rem_inplace(value);
     }
 
     /**
      * Logically equal to operation this /= x^n. Defined only when such devision is possible.
      */
     template<typename U>
-    auto operator>>=(U const &n) -> gfpoly & {
+    auto operator>>=(U const &n) -> basic_gfpoly & {
         if (n > degree() || !std::all_of(
             m_data.begin(), m_data.begin() + n,
             [](uintmax_t x) { return x == 0; })) {
@@ -444,189 +533,239 @@ public:
      * Logically equal to operation this *= x^n.
      */
     template<typename U>
-    auto operator<<=(U const &n) -> gfpoly & {
+    auto operator<<=(U const &n) -> basic_gfpoly & {
         reduce();
         m_data.insert(m_data.begin(), n, 0);
         return *this;
     }
 
-    friend auto operator-(gfpoly /*a*/) -> gfpoly;
+    friend
+    auto operator-(basic_gfpoly a) -> basic_gfpoly {
+        std::transform(a.m_data.begin(), a.m_data.end(), a.m_data.begin(),
+                       [&](uintmax_t x) { return a.neg(x); });
+        return a.reduce();
+    }
 
-    friend auto operator*(const gfpoly & /*a*/, const gfpoly & /*b*/) -> gfpoly;
+    friend
+    auto operator+(const basic_gfpoly &a, const basic_gfpoly &b) -> basic_gfpoly {
+        CHECK_FIELD(a.field() == b.field())
+        basic_gfpoly result(a);
+        result += b;
+        return result;
+    }
 
-    friend auto operator/(const gfpoly & /*a*/, const gfpoly & /*b*/) -> gfpoly;
+    friend
+    auto operator+(basic_gfpoly &&a, const basic_gfpoly &b) -> basic_gfpoly {
+        CHECK_FIELD(a.field() == b.field())
+        a += b;
+        return a;
+    }
 
-    friend auto operator%(const gfpoly & /*a*/, const gfpoly & /*b*/) -> gfpoly;
+    friend
+    auto operator+(const basic_gfpoly &a, basic_gfpoly &&b) -> basic_gfpoly {
+        CHECK_FIELD(a.field() == b.field())
+        b += a;
+        return b;
+    }
 
-    friend auto operator==(const gfpoly & /*a*/, const gfpoly & /*b*/) -> bool;
+    friend
+    auto operator+(basic_gfpoly &&a, basic_gfpoly &&b) -> basic_gfpoly {
+        CHECK_FIELD(a.field() == b.field())
+        a += b;
+        return a;
+    }
 
-    friend auto operator!=(const gfpoly & /*a*/, const gfpoly & /*b*/) -> bool;
-};
+    friend
+    auto operator-(const basic_gfpoly &a, const basic_gfpoly &b) -> basic_gfpoly {
+        CHECK_FIELD(a.field() == b.field())
+        basic_gfpoly result(a);
+        result -= b;
+        return result;
+    }
 
-inline
-auto operator-(gfpoly a) -> gfpoly {
-    std::transform(a.m_data.begin(), a.m_data.end(), a.m_data.begin(),
-                   [&](uintmax_t x) { return a.neg(x); });
-    return a.reduce();
-}
+    friend
+    auto operator-(basic_gfpoly &&a, const basic_gfpoly &b) -> basic_gfpoly {
+        CHECK_FIELD(a.field() == b.field())
+        a -= b;
+        return a;
+    }
 
-inline
-auto operator+(const gfpoly &a, const gfpoly &b) -> gfpoly {
-    CHECK_FIELD(a.field() == b.field())
-    gfpoly result(a);
-    result += b;
-    return result;
-}
+    friend
+    auto operator-(const basic_gfpoly &a, basic_gfpoly &&b) -> basic_gfpoly {
+        CHECK_FIELD(a.field() == b.field())
+        b -= a;
+        return -b;
+    }
 
-inline
-auto operator+(gfpoly &&a, const gfpoly &b) -> gfpoly {
-    CHECK_FIELD(a.field() == b.field())
-    a += b;
-    return a;
-}
+    friend
+    auto operator-(basic_gfpoly &&a, basic_gfpoly &&b) -> basic_gfpoly {
+        CHECK_FIELD(a.field() == b.field())
+        a -= b;
+        return a;
+    }
 
-inline
-auto operator+(const gfpoly &a, gfpoly &&b) -> gfpoly {
-    CHECK_FIELD(a.field() == b.field())
-    b += a;
-    return b;
-}
+    friend
+    auto operator*(const basic_gfpoly &a, const basic_gfpoly &b) -> basic_gfpoly {
+        basic_gfpoly result(a.field());
+        mul_into(result, a, b);
+        return result;
+    }
 
-inline
-auto operator+(gfpoly &&a, gfpoly &&b) -> gfpoly {
-    CHECK_FIELD(a.field() == b.field())
-    a += b;
-    return a;
-}
+    friend
+    auto operator/(basic_gfpoly a, const basic_gfpoly &b) -> basic_gfpoly {
+        a /= b;
+        return a;
+    }
 
-inline
-auto operator-(const gfpoly &a, const gfpoly &b) -> gfpoly {
-    CHECK_FIELD(a.field() == b.field())
-    gfpoly result(a);
-    result -= b;
-    return result;
-}
+    friend
+    auto operator%(basic_gfpoly a, const basic_gfpoly &b) -> basic_gfpoly {
+        a.rem_inplace(b);
+        return a;
+    }
 
-inline
-auto operator-(gfpoly &&a, const gfpoly &b) -> gfpoly {
-    CHECK_FIELD(a.field() == b.field())
-    a -= b;
-    return a;
-}
+    template<class U>
+    friend
+    auto operator+(basic_gfpoly a, const U &b) -> basic_gfpoly {
+        a += b;
+        return a;
+    }
 
-inline
-auto operator-(const gfpoly &a, gfpoly &&b) -> gfpoly {
-    CHECK_FIELD(a.field() == b.field())
-    b -= a;
-    return -b;
-}
+    template<class U>
+    friend
+    auto operator-(basic_gfpoly a, const U &b) -> basic_gfpoly {
+        a -= b;
+        return a;
+    }
 
-inline
-auto operator-(gfpoly &&a, gfpoly &&b) -> gfpoly {
-    CHECK_FIELD(a.field() == b.field())
-    a -= b;
-    return a;
-}
+    template<class U>
+    friend
+    auto operator*(basic_gfpoly a, const U &b) -> basic_gfpoly {
+        a *= b;
+        return a;
+    }
 
-inline
-auto operator*(const gfpoly &a, const gfpoly &b) -> gfpoly {
-    gfpoly result(a.field());
-    return result.multiply(a, b);
-}
+    template<class U>
+    friend
+    auto operator/(basic_gfpoly a, const U &b) -> basic_gfpoly {
+        a /= b;
+        return a;
+    }
 
-inline
-auto operator/(const gfpoly &a, const gfpoly &b) -> gfpoly {
-    return gfpoly::quotient_remainder(a, b).first;
-}
+    template<class U>
+    friend
+    auto operator%(const basic_gfpoly &a, const U & /*unused*/) -> basic_gfpoly {
+        return basic_gfpoly(a.field());
+    }
 
-inline
-auto operator%(const gfpoly &a, const gfpoly &b) -> gfpoly {
-    return gfpoly::quotient_remainder(a, b).second;
-}
+    template<class U>
+    friend
+    auto operator+(const U &a, basic_gfpoly b) -> basic_gfpoly {
+        b += a;
+        return b;
+    }
 
-template<class U>
-inline
-auto operator+(gfpoly a, const U &b) -> gfpoly {
-    a += b;
-    return a;
-}
+    template<class U>
+    friend
+    auto operator-(const U &a, basic_gfpoly b) -> basic_gfpoly {
+        b -= a;
+        return -b;
+    }
 
-template<class U>
-inline
-auto operator-(gfpoly a, const U &b) -> gfpoly {
-    a -= b;
-    return a;
-}
+    template<class U>
+    friend
+    auto operator*(const U &a, basic_gfpoly b) -> basic_gfpoly {
+        b *= a;
+        return b;
+    }
 
-template<class U>
-inline
-auto operator*(gfpoly a, const U &b) -> gfpoly {
-    a *= b;
-    return a;
-}
+    friend
+    auto operator==(const basic_gfpoly &a, const basic_gfpoly &b) -> bool {
+        CHECK_FIELD(a.field() == b.field())
+        return a.m_data == b.m_data;
+    }
 
-template<class U>
-inline
-auto operator/(gfpoly a, const U &b) -> gfpoly {
-    a /= b;
-    return a;
-}
+    friend
+    auto operator!=(const basic_gfpoly &a, const basic_gfpoly &b) -> bool {
+        CHECK_FIELD(a.field() == b.field())
+        return a.m_data != b.m_data;
+    }
 
-template<class U>
-inline
-auto operator%(const gfpoly &a, const U & /*unused*/) -> gfpoly {
-    return gfpoly(a.field());
-}
+    template<typename U>
+    friend
+    auto operator>>(basic_gfpoly a, const U &b) -> basic_gfpoly {
+        a >>= b;
+        return a;
+    }
 
-template<class U>
-inline
-auto operator+(const U &a, gfpoly b) -> gfpoly {
-    b += a;
-    return b;
-}
+    template<typename U>
+    friend
+    auto operator<<(basic_gfpoly a, const U &b) -> basic_gfpoly {
+        a <<= b;
+        return a;
+    }
+};
 
-template<class U>
-inline
-auto operator-(const U &a, gfpoly b) -> gfpoly {
-    b -= a;
-    return -b;
-}
+/**
+ * gfpoly represents a polynomial over Galois field with field base known at runtime.
+ */
+using gfpoly = basic_gfpoly<gf>;
 
-template<class U>
-inline
-auto operator*(const U &a, gfpoly b) -> gfpoly {
-    b *= a;
-    return b;
-}
+namespace detail {
 
+/**
+ * Writes coefficients of candidate number index of the random sequence seed to out[0..degree].
+ * Candidate is monic with non-zero constant term and depends only on (P, degree, seed, index).
+ */
 inline
-auto operator==(const gfpoly &a, const gfpoly &b) -> bool {
-    CHECK_FIELD(a.field() == b.field())
-    return a.m_data == b.m_data;
+void random_monic(const uintmax_t P, const uintmax_t degree, const uint64_t seed,
+                  const uint64_t index, uintmax_t *out) {
+    splitmix64 gen(seed, index);
+    out[degree] = 1;
+    if (degree == 0) {
+        return;
+    }
+    out[0] = 1 + random_below(gen, P - 1);
+    for (uintmax_t i = 1; i < degree; ++i) {
+        out[i] = random_below(gen, P);
+    }
 }
 
-inline
-auto operator!=(const gfpoly &a, const gfpoly &b) -> bool {
-    CHECK_FIELD(a.field() == b.field())
-    return a.m_data != b.m_data;
-}
+} // namespace detail
 
-template<typename U>
-inline
-auto operator>>(gfpoly a, const U &b) -> gfpoly {
-    a >>= b;
-    return a;
+/**
+ * Returns candidate number index of the random sequence seed: monic polynomial of
+ * given degree with non-zero constant term. Candidate depends only on arguments,
+ * so results of concurrent or distributed search could be replayed from the seed.
+ */
+template<typename Field>
+[[nodiscard]]
+auto random_indexed(const Field &field, const uintmax_t degree,
+                    const uint64_t seed, const uint64_t index) -> basic_gfpoly<Field> {
+    std::vector<uintmax_t> data(degree + 1);
+    detail::random_monic(field->base(), degree, seed, index, data.data());
+    return basic_gfpoly<Field>(field, std::move(data));
 }
 
-template<typename U>
-inline
-auto operator<<(gfpoly a, const U &b) -> gfpoly {
-    a <<= b;
-    return a;
+/**
+ * Generates count candidates [first, first + count) of the random sequence seed
+ * (see random_indexed) into one contiguous buffer: candidate i occupies
+ * [i * (degree + 1), (i + 1) * (degree + 1)), lower coefficient goes first.
+ * Function has no shared state, workers could fill disjoint ranges concurrently.
+ */
+template<typename Field>
+[[nodiscard]]
+auto random_batch(const Field &field, const uintmax_t degree, const uintmax_t count,
+                  const uint64_t seed, const uint64_t first = 0) -> std::vector<uintmax_t> {
+    const auto P = field->base();
+    std::vector<uintmax_t> res(count * (degree + 1));
+    for (uintmax_t i = 0; i < count; ++i) {
+        detail::random_monic(P, degree, seed, first + i, res.data() + i * (degree + 1));
+    }
+    return res;
 }
 
-template<class charT, class traits>
-auto operator<<(std::basic_ostream<charT, traits> &os, const gfpoly &poly)
+template<class charT, class traits, typename Field>
+auto operator<<(std::basic_ostream<charT, traits> &os, const basic_gfpoly<Field> &poly)
 -> std::basic_ostream<charT, traits> & {
     os << "{ ";
     for (uintmax_t i = 0; i < poly.size(); ++i) {
@@ -639,12 +778,12 @@ auto operator<<(std::basic_ostream<charT, traits> &os, const gfpoly &poly)
     return os;
 }
 
-template<class charT, class traits>
-auto operator>>(std::basic_istream<charT, traits> &is, gfpoly &poly)
+template<class charT, class traits, typename Field>
+auto operator>>(std::basic_istream<charT, traits> &is, basic_gfpoly<Field> &poly)
 -> std::basic_istream<charT, traits> & {
     charT tmp;
     uintmax_t num = 0;
-    std::string str;
+    bool digits = false; // number is being read
     std::vector<uintmax_t> vec;
     while (is.good() && is.get(tmp) && tmp != '{') {
         if (tmp != ' ' && tmp != '\n') {
@@ -654,15 +793,21 @@ auto operator>>(std::basic_istream<charT, traits> &is, gfpoly &poly)
     if (tmp != '{') {
         throw std::invalid_argument("wrong input");
     }
+    // digits are accumulated at once, see gfpoly_reader for bulk input
     while (is.good() && is.get(tmp) && tmp != '}') {
         if (tmp == ',' || tmp == ' ' || tmp == '\n') {
-            if (!str.empty()) {
-                std::stringstream(str) >> num;
-                str.clear();
+            if (digits) {
                 vec.emplace_back(num);
+                num = 0;
+                digits = false;
             }
         } else if (std::isdigit(tmp)) {
-            str += tmp;
+            const auto d = static_cast<uintmax_t>(tmp - '0');
+            if (num > (UINTMAX_MAX - d) / 10) {
+                throw std::invalid_argument("wrong input");
+            }
+            num = num * 10 + d;
+            digits = true;
         } else {
             throw std::invalid_argument("wrong input");
         }
@@ -670,7 +815,10 @@ auto operator>>(std::basic_istream<charT, traits> &is, gfpoly &poly)
     if (tmp != '}') {
         throw std::invalid_argument("wrong input");
     }
-    poly = gfpoly(poly.field(), vec);
+    if (digits) {
+        vec.emplace_back(num);
+    }
+    poly = basic_gfpoly<Field>(poly.field(), std::move(vec));
     return is;
 }
 
@@ -0,0 +1,334 @@
+/**
+ * @file    gftable.hpp
+ * @author  Vadim Piven <vadim@piven.tech>
+ * @license Free use of this library is permitted under the
+ * guidelines and in accordance with the MIT License (MIT).
+ * @url     https://github.com/irreducible-polynoms/irrpoly
+ */
+
+#pragma once
+
+#include "gfcheck.hpp"
+
+#include <map>
+#include <tuple>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <optional>
+#include <random>
+#include <atomic>
+#include <cstring>
+#include <cstdint>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define IRRPOLY_TABLE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace irrpoly {
+
+/**
+ * gftable is a persistent table of known irreducible and primitive polynomials.
+ * File starts with 16 byte header (magic and byte order tag), then records follow:
+ * 8 byte base P, 4 byte degree n, 4 byte flags, then n lower coefficients
+ * (monic leading one is implied) packed by bit length of P - 1 into 64-bit words.
+ * Everything is 8 byte aligned and stored in host byte order, files with other
+ * byte order are rejected. Where mmap is available file is mapped, not read:
+ * opening scans only the record headers to build (P, n, flags) index, coefficients
+ * are decoded on lookup. New records are appended to the file and kept in memory.
+ * Lookups could be done concurrently, appends require exclusive access.
+ */
+class gftable final {
+public:
+    static constexpr uint32_t irreducible = 1; ///< record flag of irreducible polynomial
+    static constexpr uint32_t primitive = 2; ///< record flag of primitive polynomial
+
+private:
+    static constexpr char magic[8] = {'I', 'R', 'R', 'P', 'O', 'L', 'Y', 'T'};
+    static constexpr uint32_t byte_order = 0x01020304;
+    static constexpr std::size_t header_size = 16;
+    static constexpr std::size_t record_header_size = 16;
+
+    using key = std::tuple<uint64_t, uint64_t, uint32_t>;
+
+    /**
+     * Record position: in mapped file if in_file, otherwise in m_appended.
+     */
+    struct position {
+        bool in_file;
+        std::size_t offset; ///< offset of packed coefficients in bytes
+    };
+
+    std::string m_path;
+    const unsigned char *m_map; ///< mapped or read file contents
+    std::size_t m_size; ///< size of file part m_map refers to
+    std::vector<unsigned char> m_read; ///< file contents when mmap is unavailable
+    std::vector<uint64_t> m_appended; ///< packed coefficients of appended records
+    std::map<key, position> m_index; ///< the first record for each key
+    std::size_t m_count; ///< number of records
+
+    [[nodiscard]]
+    static auto bits(const uint64_t P) -> unsigned {
+        unsigned res = 0;
+        for (auto v = P - 1; v; v >>= 1U) {
+            ++res;
+        }
+        return res;
+    }
+
+    [[nodiscard]]
+    static auto words(const uint64_t P, const uint64_t n) -> std::size_t {
+        return static_cast<std::size_t>((n * bits(P) + 63) / 64);
+    }
+
+    [[nodiscard]]
+    static auto read_u64(const unsigned char *ptr) -> uint64_t {
+        uint64_t res;
+        std::memcpy(&res, ptr, sizeof(res));
+        return res;
+    }
+
+    [[nodiscard]]
+    static auto read_u32(const unsigned char *ptr) -> uint32_t {
+        uint32_t res;
+        std::memcpy(&res, ptr, sizeof(res));
+        return res;
+    }
+
+    void load() {
+#ifdef IRRPOLY_TABLE_MMAP
+        const int fd = ::open(m_path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return; // table is created by the first append
+        }
+        struct stat st{};
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            throw std::runtime_error("can't stat polynomial table");
+        }
+        m_size = static_cast<std::size_t>(st.st_size);
+        if (m_size) {
+            void *map = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            ::close(fd);
+            if (map == MAP_FAILED) {
+                m_size = 0;
+                throw std::runtime_error("can't map polynomial table");
+            }
+            m_map = static_cast<const unsigned char *>(map);
+        } else {
+            ::close(fd);
+        }
+#else
+        std::ifstream in(m_path, std::ios::binary);
+        if (!in) {
+            return;
+        }
+        m_read.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        m_size = m_read.size();
+        m_map = m_read.data();
+#endif
+        if (!m_size) {
+            return;
+        }
+        if (m_size < header_size || std::memcmp(m_map, magic, sizeof(magic)) != 0 ||
+            read_u32(m_map + 8) != byte_order) {
+            release();
+            throw std::runtime_error("not a polynomial table or wrong byte order");
+        }
+        for (std::size_t pos = header_size; pos < m_size;) {
+            if (m_size - pos < record_header_size) {
+                release();
+                throw std::runtime_error("polynomial table is truncated");
+            }
+            const auto P = read_u64(m_map + pos);
+            const auto n = read_u32(m_map + pos + 8), flags = read_u32(m_map + pos + 12);
+            const auto len = words(P, n) * 8;
+            if (P < 2 || m_size - pos - record_header_size < len) {
+                release();
+                throw std::runtime_error("polynomial table is truncated");
+            }
+            add(P, n, flags, position{true, pos + record_header_size});
+            pos += record_header_size + len;
+        }
+    }
+
+    void release() {
+#ifdef IRRPOLY_TABLE_MMAP
+        if (m_map) {
+            ::munmap(const_cast<unsigned char *>(m_map), m_size);
+        }
+#endif
+        m_map = nullptr;
+        m_size = 0;
+        m_read.clear();
+    }
+
+    void add(const uint64_t P, const uint64_t n, const uint32_t flags, const position pos) {
+        // primitive polynomial is found by irreducible lookups too
+        for (const uint32_t f : {irreducible, primitive}) {
+            if (flags & f) {
+                m_index.emplace(key(P, n, f), pos);
+            }
+        }
+        ++m_count;
+    }
+
+    [[nodiscard]]
+    auto data(const position pos) const -> const unsigned char * {
+        return pos.in_file ? m_map + pos.offset
+                           : reinterpret_cast<const unsigned char *>(m_appended.data()) + pos.offset;
+    }
+
+public:
+    /**
+     * Opens table stored in file path, if file doesn't exist it is created by the first append.
+     * Throws std::runtime_error if file is not a valid table.
+     */
+    explicit
+    gftable(std::string path) :
+        m_path(std::move(path)), m_map(nullptr), m_size(0), m_read(),
+        m_appended(), m_index(), m_count(0) {
+        load();
+    }
+
+    gftable(const gftable &) = delete;
+
+    auto operator=(const gftable &) -> gftable & = delete;
+
+    ~gftable() {
+        release();
+    }
+
+    /**
+     * Returns the number of records.
+     */
+    [[nodiscard]]
+    auto size() const -> std::size_t {
+        return m_count;
+    }
+
+    /**
+     * Returns the first stored monic polynomial of given degree with flags
+     * (irreducible or primitive) over the field provided.
+     */
+    template<typename Field>
+    [[nodiscard]]
+    auto find(const Field &field, const uintmax_t degree, const uint32_t flags) const
+    -> std::optional<basic_gfpoly<Field>> {
+        const auto P = field->base();
+        const auto it = m_index.find(key(P, degree, flags & primitive ? primitive : irreducible));
+        if (it == m_index.end()) {
+            return std::nullopt;
+        }
+        const auto *ptr = data(it->second);
+        const auto b = bits(P);
+        const uint64_t mask = (b == 64) ? UINT64_MAX : (uint64_t(1) << b) - 1;
+        std::vector<uintmax_t> coef(degree + 1, 0);
+        for (uintmax_t i = 0; i < degree; ++i) {
+            const auto bit = i * b, word = bit / 64, shift = bit % 64;
+            uint64_t v = read_u64(ptr + word * 8) >> shift;
+            if (shift + b > 64) {
+                v |= read_u64(ptr + (word + 1) * 8) << (64 - shift);
+            }
+            coef[i] = v & mask;
+        }
+        coef[degree] = 1;
+        return basic_gfpoly<Field>(field, std::move(coef));
+    }
+
+    /**
+     * Appends polynomial with flags (irreducible, primitive or both) to the file.
+     * Polynomial is normalized first, it's our caller's duty to check it.
+     */
+    template<typename Field>
+    void append(const basic_gfpoly<Field> &poly, const uint32_t flags) {
+        if (poly.is_zero() || poly.degree() == 0) {
+            throw std::invalid_argument("polynomial must have positive degree");
+        }
+        const uint64_t P = poly.base();
+        const uint64_t n = poly.degree();
+        if (n > UINT32_MAX) {
+            throw std::invalid_argument("polynomial degree is too large");
+        }
+        const auto norm = poly * poly.field()->mul_inv(poly[n]);
+        const auto b = bits(P);
+        std::vector<uint64_t> packed(words(P, n), 0);
+        for (uint64_t i = 0; i < n; ++i) {
+            const auto bit = i * b, word = bit / 64, shift = bit % 64;
+            packed[word] |= uint64_t(norm[i]) << shift;
+            if (shift + b > 64) {
+                packed[word + 1] |= uint64_t(norm[i]) >> (64 - shift);
+            }
+        }
+        const uint32_t flag = (flags & primitive) ? (primitive | irreducible) : irreducible;
+
+        std::ofstream out(m_path, std::ios::binary | std::ios::app);
+        if (!out) {
+            throw std::runtime_error("can't open polynomial table for writing");
+        }
+        out.seekp(0, std::ios::end);
+        if (out.tellp() == 0) {
+            uint32_t tag[2] = {byte_order, 0};
+            out.write(magic, sizeof(magic));
+            out.write(reinterpret_cast<const char *>(tag), sizeof(tag));
+        }
+        const uint32_t head[2] = {static_cast<uint32_t>(n), flag};
+        out.write(reinterpret_cast<const char *>(&P), sizeof(P));
+        out.write(reinterpret_cast<const char *>(head), sizeof(head));
+        out.write(reinterpret_cast<const char *>(packed.data()),
+                  static_cast<std::streamsize>(packed.size() * sizeof(uint64_t)));
+        if (!out) {
+            throw std::runtime_error("can't write polynomial table");
+        }
+
+        const auto offset = m_appended.size() * sizeof(uint64_t);
+        m_appended.insert(m_appended.end(), packed.begin(), packed.end());
+        add(P, n, flag, position{false, offset});
+    }
+
+    /**
+     * Returns stored polynomial of given degree with flags (irreducible or primitive),
+     * if there is no such one searches for it using pipeline with threads threads
+     * and appends the result to the table.
+     */
+    template<typename Field>
+    [[nodiscard]]
+    auto find_or_search(const Field &field, const uintmax_t degree, const uint32_t flags,
+                        const unsigned threads = std::thread::hardware_concurrency())
+    -> basic_gfpoly<Field> {
+        if (degree == 0) {
+            throw std::invalid_argument("degree must be positive");
+        }
+        if (auto found = find(field, degree, flags)) {
+            return std::move(*found);
+        }
+        using namespace multithread;
+        const bool prim = flags & primitive;
+        const uint64_t seed = std::random_device{}();
+        std::atomic<uint64_t> index(0);
+        std::optional<basic_gfpoly<Field>> res;
+        basic_polychecker<Field> ch(threads);
+        ch.chain_batch(
+            [&]() { return random_indexed(field, degree, seed, index++); },
+            make_batch_check_func<Field>(irreducible_method::recommended,
+                                         prim ? primitive_method::recommended : primitive_method::nil),
+            [&](const basic_gfpoly<Field> &poly, const check_result &r) {
+                if (r.irreducible && r.primitive) {
+                    res.emplace(poly);
+                    return true;
+                }
+                return false;
+            });
+        append(*res, prim ? primitive : irreducible);
+        return std::move(*res);
+    }
+};
+
+} // namespace irrpoly
+
+#undef IRRPOLY_TABLE_MMAP
@@ -8,6 +8,9 @@
 
 #pragma once
 
+#include "stop.hpp"
+#include "stats.hpp"
+
 #include <thread>
 #include <cassert>
 #include <functional>
@@ -18,13 +21,30 @@
 #include <memory>
 #include <optional>
 #include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <chrono>
+#include <exception>
 
 namespace irrpoly::multithread {
 
 /**
  * Chains the input_fn, payload_fn and callback_fn provided. Executes this chain in several
  * threads at the same time.
- * TODO: change architecture to make checks faster.
+ * Each worker owns a lock-free deque of tasks. Worker takes tasks from its own deque,
+ * when it is empty tries to steal from other workers, and only then generates new batch
+ * of inputs by itself (input_fn calls are serialized, so it needs no synchronization).
+ * Finished tasks are handed to the calling thread in groups, there callback_fn is
+ * executed sequentially.
+ * Every task holds a chunk of inputs. With batch_payload_fn whole chunk is processed
+ * by single call, this amortizes synchronization and std::function overhead when
+ * payload takes only microseconds. Chunk size is either fixed or adapted to the
+ * measured payload latency.
+ * Payloads run under stop_scope: once the result is found in strict mode checks still
+ * in flight throw operation_cancelled, so workers abandon them instead of finishing.
+ * Results could also be pulled one by one with stream and next instead of callback_fn.
+ * Exception thrown by input_fn or payload in worker stops the session, it is rethrown
+ * by next (and so by chain) once all workers have finished.
  */
 template<typename input_t, typename output_t>
 class pipeline {
@@ -37,123 +57,372 @@ public:
     using callback_fn =
     std::function<bool(const input_t &, const output_t &)>;
 
-private:
-    class pod {
-        std::shared_ptr<std::mutex> s_mutex;
-        std::shared_ptr<std::condition_variable> s_cond;
+    /**
+     * Processes chunk of inputs, output vector has the same size as input one.
+     */
+    using batch_payload_fn =
+    std::function<void(const std::vector<input_t> &, std::vector<std::optional<output_t>> &)>;
 
-        payload_fn m_pl;
+    static constexpr unsigned max_chunk = 1024; ///< upper bound for adaptive chunk size
 
-        volatile bool m_terminate; ///< set to true when pod should be terminated
-        std::optional<input_t> m_val;
+private:
+    struct task {
+        std::vector<input_t> input;
+        std::vector<std::optional<output_t>> output;
+    };
+
+    /// chunk processing time adaptive mode aims at
+    static constexpr std::chrono::microseconds chunk_latency{50};
+
+    /**
+     * Chase-Lev work-stealing deque of fixed capacity. Only the owner pushes and pops
+     * at the bottom, any thread steals from the top. Owner pushes only into empty
+     * deque, so capacity is never exceeded and buffer never has to grow.
+     */
+    class deque {
+        std::vector<std::atomic<task *>> m_buf;
+        const int64_t m_mask;
+        std::atomic<int64_t> m_top;
+        std::atomic<int64_t> m_bottom;
 
-        bool m_busy; ///< set to true during payload_fn execution, otherwise false
-        std::optional<output_t> m_res;
+    public:
+        explicit
+        deque(const unsigned capacity) :
+            m_buf(capacity), m_mask(static_cast<int64_t>(capacity) - 1),
+            m_top(0), m_bottom(0) {
+            assert(capacity && !(capacity & (capacity - 1)));
+        }
 
-        std::thread m_thread;
-        std::mutex m_mutex;
-        std::condition_variable m_cond;
+        ~deque() {
+            while (auto t = pop()) {
+                delete t;
+            }
+        }
 
-        void execute() {
-            std::unique_lock<std::mutex> lk(m_mutex);
+        void push(task *t) {
+            const auto b = m_bottom.load(std::memory_order_relaxed);
+            m_buf[b & m_mask].store(t, std::memory_order_relaxed);
+            m_bottom.store(b + 1, std::memory_order_release);
+        }
 
-            while (!m_terminate) {
-                if (!(m_busy || m_terminate)) {
-                    m_cond.wait(lk);
-                    continue;
+        [[nodiscard]]
+        auto pop() -> task * {
+            const auto b = m_bottom.load(std::memory_order_relaxed) - 1;
+            m_bottom.store(b, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            auto t = m_top.load(std::memory_order_relaxed);
+            if (t > b) {
+                m_bottom.store(b + 1, std::memory_order_relaxed);
+                return nullptr;
+            }
+            auto res = m_buf[b & m_mask].load(std::memory_order_relaxed);
+            if (t == b) {
+                // last element, race against thieves
+                if (!m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                                   std::memory_order_relaxed)) {
+                    res = nullptr;
                 }
-
-                m_pl(m_val.value(), m_res);
-
-                std::lock_guard<std::mutex> lg(*s_mutex);
-                m_busy = false;
-                s_cond->notify_one();
+                m_bottom.store(b + 1, std::memory_order_relaxed);
             }
+            return res;
         }
 
-    public:
-        pod(std::shared_ptr<std::mutex> s_mutex,
-            std::shared_ptr<std::condition_variable> s_cond) :
-            s_mutex(std::move(s_mutex)), s_cond(std::move(s_cond)),
-            m_busy(false), m_terminate(false),
-            m_val(), m_res() {
-            m_thread = std::thread(&pod::execute, std::ref(*this));
+        [[nodiscard]]
+        auto steal() -> task * {
+            auto t = m_top.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            const auto b = m_bottom.load(std::memory_order_acquire);
+            if (t >= b) {
+                return nullptr;
+            }
+            auto res = m_buf[t & m_mask].load(std::memory_order_relaxed);
+            if (!m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                               std::memory_order_relaxed)) {
+                return nullptr;
+            }
+            return res;
         }
-
-        ~pod() {
-            // waits for thread to terminate, only then object resources will be freed
-            m_thread.join();
+    }; // class deque
+
+    struct worker {
+        deque tasks;
+        std::thread thread;
+
+        explicit
+        worker(const unsigned capacity) : tasks(capacity), thread() {}
+    };
+
+    std::vector<std::unique_ptr<worker>> m_workers;
+    const unsigned m_batch; ///< number of tasks generated at once by chain_batch and streams
+    const unsigned m_chunk_size; ///< configured chunk size, zero for adaptive
+    std::atomic<unsigned> m_chunk; ///< number of inputs per task
+
+    // session state, written by chain() under m_mutex before workers are woken
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    uint64_t m_session;
+    bool m_terminate;
+    bool m_adaptive; ///< chunk size adapts to payload latency during current session
+    unsigned m_tasks; ///< number of tasks generated at once during current session
+    input_fn m_in;
+    batch_payload_fn m_pl;
+
+    std::mutex m_gen_mutex; ///< serializes input_fn calls
+    std::atomic<bool> m_stop;
+    std::atomic<bool> m_cancel; ///< stop token of payloads, in-flight results are not needed
+
+    // results taken from m_results, but not returned by next() yet
+    std::vector<std::unique_ptr<task>> m_ready;
+    std::size_t m_ready_task;
+    std::size_t m_ready_item;
+
+    // finished tasks waiting for callback
+    std::mutex m_res_mutex;
+    std::condition_variable m_res_cond;
+    std::vector<std::unique_ptr<task>> m_results;
+    unsigned m_active;
+    std::exception_ptr m_error; ///< first exception thrown in worker during current session
+
+    void flush(std::vector<std::unique_ptr<task>> &done) {
+        if (done.empty()) {
+            return;
         }
-
-        void set_payload(payload_fn pl) {
-            m_pl = pl;
+        std::lock_guard<std::mutex> lg(m_res_mutex);
+        for (auto &t : done) {
+            m_results.push_back(std::move(t));
         }
+        done.clear();
+        m_res_cond.notify_one();
+    }
 
-        [[nodiscard]]
-        auto input() const -> const std::optional<input_t> & {
-            return m_val;
+    /**
+     * Stores the exception of worker and stops the session, checks in flight are abandoned.
+     */
+    void fail(std::exception_ptr error) {
+        {
+            std::lock_guard<std::mutex> lg(m_res_mutex);
+            if (!m_error) {
+                m_error = std::move(error);
+            }
         }
+        m_stop.store(true);
+        m_cancel.store(true);
+    }
 
-        void input(input_t v) {
-            std::lock_guard<std::mutex> lg(m_mutex);
-            m_val.emplace(std::move(v));
-            m_res.reset();
-            m_busy = true;
-            m_cond.notify_one();
+    auto make_task(const unsigned chunk) -> std::unique_ptr<task> {
+        auto t = std::make_unique<task>();
+        t->input.reserve(chunk);
+        for (unsigned i = 0; i < chunk; ++i) {
+            t->input.emplace_back(m_in());
         }
+        t->output.resize(chunk);
+        return t;
+    }
 
-        [[nodiscard]]
-        auto is_busy() const -> bool {
-            return m_busy;
+    /**
+     * Generates m_tasks tasks, first one is returned and others are pushed into own deque.
+     */
+    auto generate(worker &self) -> task * {
+        std::unique_lock<std::mutex> lk(m_gen_mutex, std::defer_lock);
+        {
+            const detail::stats_timer idle(counter::pipeline_idle_ns);
+            lk.lock();
+        }
+        if (m_stop.load(std::memory_order_relaxed)) {
+            return nullptr;
         }
+        const auto chunk = m_chunk.load(std::memory_order_relaxed);
+        auto first = make_task(chunk);
+        for (unsigned i = 1; i < m_tasks; ++i) {
+            self.tasks.push(make_task(chunk).release());
+        }
+        return first.release();
+    }
 
-        void terminate() {
-            std::lock_guard<std::mutex> lg(m_mutex);
-            m_terminate = true;
-            m_cond.notify_one();
+    /**
+     * Executes payload for the task, in adaptive mode also updates chunk size
+     * so that next tasks take about chunk_latency to process.
+     */
+    void process(task &t) {
+        const stop_scope scope{stop_token(m_cancel)};
+        detail::count(counter::pipeline_tasks);
+        if (!m_adaptive) {
+            try {
+                m_pl(t.input, t.output);
+            } catch (const operation_cancelled &) {} // unfinished outputs are skipped
+            return;
+        }
+        const auto begin = std::chrono::steady_clock::now();
+        try {
+            m_pl(t.input, t.output);
+        } catch (const operation_cancelled &) {
+            return;
         }
+        const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - begin).count();
+        const auto per_input = std::max<int64_t>(1, elapsed / static_cast<int64_t>(t.input.size()));
+        const auto chunk = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            chunk_latency).count() / per_input;
+        m_chunk.store(static_cast<unsigned>(std::clamp<int64_t>(chunk, 1, max_chunk)),
+                      std::memory_order_relaxed);
+    }
 
-        [[nodiscard]]
-        auto output() const -> const std::optional<output_t> & {
-            return m_res;
+    auto steal(const unsigned id) -> task * {
+        for (unsigned i = 1; i < m_workers.size(); ++i) {
+            if (auto t = m_workers[(id + i) % m_workers.size()]->tasks.steal()) {
+                return t;
+            }
         }
+        return nullptr;
+    }
 
-        void clean() {
-            std::lock_guard<std::mutex> lg(m_mutex);
-            m_val.reset();
-            m_res.reset();
-            m_busy = false;
+    void execute(const unsigned id) {
+        auto &self = *m_workers[id];
+        uint64_t session = 0;
+        std::vector<std::unique_ptr<task>> done;
+        done.reserve(m_batch);
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lk(m_mutex);
+                m_cond.wait(lk, [&] { return m_terminate || m_session != session; });
+                if (m_terminate) {
+                    return;
+                }
+                session = m_session;
+            }
+
+            while (!m_stop.load(std::memory_order_relaxed)) {
+                try {
+                    auto t = self.tasks.pop();
+                    if (!t) {
+                        flush(done); // own batch is over, results are handed out together
+                        t = steal(id);
+                    }
+                    if (!t) {
+                        t = generate(self);
+                    }
+                    if (!t) {
+                        break;
+                    }
+                    done.emplace_back(t);
+                    process(*t);
+                } catch (...) {
+                    fail(std::current_exception());
+                    break;
+                }
+                if (done.size() >= m_batch) {
+                    flush(done);
+                }
+            }
+            flush(done);
+            // tasks not started yet are discarded
+            while (auto t = self.tasks.pop()) {
+                delete t;
+            }
+
+            std::lock_guard<std::mutex> lg(m_res_mutex);
+            --m_active;
+            m_res_cond.notify_one();
         }
-    }; // class node
+    }
 
-    std::shared_ptr<std::mutex> s_mutex;
-    std::shared_ptr<std::condition_variable> s_cond;
+    /**
+     * Cancels current session and waits for its workers, exception of abandoned
+     * session is dropped as nobody waits for its results.
+     */
+    void drain() {
+        stop();
+        try {
+            while (next()) {}
+        } catch (...) {}
+    }
 
-    std::vector<std::unique_ptr<pod>> m_pods;
+    /**
+     * Starts new session with tasks of given chunk size, zero means adaptive size,
+     * workers generate given number of tasks at once. Unfinished previous session is cancelled.
+     */
+    void start(input_fn in, batch_payload_fn pl, const unsigned chunk, const unsigned tasks) {
+        drain();
+        m_chunk.store(chunk ? chunk : 1);
+        std::lock_guard<std::mutex> lg(m_mutex);
+        m_in = std::move(in);
+        m_pl = std::move(pl);
+        m_adaptive = !chunk;
+        m_tasks = tasks;
+        m_stop.store(false);
+        m_cancel.store(false);
+        if (!m_workers.empty()) {
+            m_active = static_cast<unsigned>(m_workers.size());
+            ++m_session;
+            m_cond.notify_all();
+        }
+    }
 
-    auto count_busy() -> unsigned {
-        return std::count_if(m_pods.begin(), m_pods.end(),
-                             std::mem_fn(&pod::is_busy));
+    /**
+     * Executes chain with tasks of given chunk size (zero means adaptive size),
+     * generated by given number at once.
+     */
+    void run(input_fn in, batch_payload_fn pl, const callback_fn &bk,
+             const bool strict, const unsigned chunk, const unsigned tasks) {
+        start(std::move(in), std::move(pl), chunk, tasks);
+        bool stopped = false;
+        while (auto res = next()) {
+            if (!stopped) {
+                if (bk(res->first, res->second)) {
+                    stopped = true;
+                    stop(strict);
+                }
+            } else if (!strict) {
+                // collect all results, by default excess results are discarded
+                bk(res->first, res->second);
+            }
+        }
     }
 
 public:
+    /**
+     * Creates pipeline with n threads in total: n - 1 workers and calling thread,
+     * which executes callbacks. Each task holds chunk inputs, zero chunk means that
+     * chunk size is selected by measured payload latency. With chain_batch and streams
+     * each worker generates batch tasks at once (rounded up to the power of two), so up to
+     * batch * chunk inputs per worker are requested ahead, chain generates single tasks.
+     */
     explicit
-    pipeline(unsigned n = std::thread::hardware_concurrency()) {
-        s_mutex = std::make_shared<std::mutex>();
-        s_cond = std::make_shared<std::condition_variable>();
-
+    pipeline(unsigned n = std::thread::hardware_concurrency(), unsigned batch = 8,
+             unsigned chunk = 0) :
+        m_workers(), m_batch(std::max(1U, batch)), m_chunk_size(std::min(chunk, max_chunk)),
+        m_chunk(1), m_mutex(), m_cond(), m_session(0),
+        m_terminate(false), m_adaptive(false), m_tasks(1), m_in(), m_pl(), m_gen_mutex(), m_stop(false),
+        m_cancel(false), m_ready(), m_ready_task(0), m_ready_item(0),
+        m_res_mutex(), m_res_cond(), m_results(), m_active(0), m_error() {
+        unsigned capacity = 1;
+        while (capacity < m_batch) {
+            capacity <<= 1U;
+        }
         if (n > 1) {
-            m_pods.reserve(--n);
+            m_workers.reserve(--n);
+            for (unsigned i = 0; i < n; ++i) {
+                m_workers.push_back(std::make_unique<worker>(capacity));
+            }
             for (unsigned i = 0; i < n; ++i) {
-                m_pods.push_back(std::make_unique<pod>(s_mutex, s_cond));
+                m_workers[i]->thread = std::thread(&pipeline::execute, this, i);
             }
         }
     }
 
+    pipeline(const pipeline &) = delete;
+
+    auto operator=(const pipeline &) -> pipeline & = delete;
+
+    /**
+     * Calls input_fn to get new input, payload_fn to process it and callback_fn
+     * for the result until callback_fn returns true. If strict is false,
+     * results of checks finished after that are passed to callback_fn too.
+     */
     void chain(input_fn in, payload_fn pl, callback_fn bk,
                const bool strict = true) {
         // if multithreading is unavailable - perform everything in main thread
-        if (m_pods.empty()) {
+        if (m_workers.empty()) {
             while (true) {
                 auto input = in();
                 std::optional<output_t> result;
@@ -164,48 +433,126 @@ public:
             }
         }
 
-        std::unique_lock<std::mutex> lk(*s_mutex);
-        std::this_thread::yield();
+        // tasks hold single input and are generated one by one, so like with
+        // one-slot workers at most one input per worker is requested ahead
+        run(std::move(in),
+            [pl = std::move(pl)](const std::vector<input_t> &input,
+                                 std::vector<std::optional<output_t>> &output) {
+                for (std::size_t i = 0; i < input.size(); ++i) {
+                    pl(input[i], output[i]);
+                }
+            }, bk, strict, 1, 1);
+    }
+
+    /**
+     * The same as chain, but payload receives inputs by chunks of the size
+     * passed to constructor (or adaptive one).
+     */
+    void chain_batch(input_fn in, batch_payload_fn pl, callback_fn bk,
+                     const bool strict = true) {
+        run(std::move(in), std::move(pl), std::move(bk), strict, m_chunk_size, m_batch);
+    }
 
-        for (const auto &sl : m_pods) {
-            sl->set_payload(pl);
-            sl->input(in());
-        }
+    /**
+     * Starts generating and processing inputs in background, results are taken by next,
+     * so the calling thread is free until it needs them. Tasks hold single input.
+     */
+    void stream(input_fn in, payload_fn pl) {
+        start(std::move(in),
+              [pl = std::move(pl)](const std::vector<input_t> &input,
+                                   std::vector<std::optional<output_t>> &output) {
+                  for (std::size_t i = 0; i < input.size(); ++i) {
+                      pl(input[i], output[i]);
+                  }
+              }, 1, m_batch);
+    }
+
+    /**
+     * The same as stream, but payload receives inputs by chunks (see chain_batch).
+     */
+    void stream_batch(input_fn in, batch_payload_fn pl) {
+        start(std::move(in), std::move(pl), m_chunk_size, m_batch);
+    }
+
+    /**
+     * Returns next (input, output) pair of the stream in order of completion, blocks until
+     * it is ready. Returns nullopt when stream is stopped and all its results are returned.
+     * Rethrows exception of input_fn or payload, then the stream is stopped.
+     * Must be called from one thread at a time.
+     */
+    [[nodiscard]]
+    auto next() -> std::optional<std::pair<input_t, output_t>> {
         while (true) {
-            while (count_busy() == m_pods.size()) {
-                s_cond->wait(lk);
+            for (; m_ready_task < m_ready.size(); ++m_ready_task, m_ready_item = 0) {
+                auto &t = *m_ready[m_ready_task];
+                while (m_ready_item < t.input.size()) {
+                    const auto i = m_ready_item++;
+                    if (t.output[i]) {
+                        return std::make_pair(std::move(t.input[i]), std::move(*t.output[i]));
+                    }
+                }
             }
-            for (unsigned i = 0; i < m_pods.size(); ++i) {
-                if (m_pods[i]->is_busy()) {
-                    continue;
+            m_ready.clear();
+            m_ready_task = m_ready_item = 0;
+
+            // if multithreading is unavailable - perform everything in calling thread
+            if (m_workers.empty()) {
+                if (m_stop.load() || !m_pl) {
+                    return std::nullopt;
                 }
-                if (bk(m_pods[i]->input().value(),
-                       m_pods[i]->output().value())) {
-                    m_pods[i]->clean();
-                    goto end;
+                try {
+                    m_ready.emplace_back(make_task(m_chunk.load(std::memory_order_relaxed)));
+                    process(*m_ready.back());
+                } catch (...) {
+                    stop();
+                    throw;
                 }
-                m_pods[i]->input(in());
+                continue;
             }
-        }
-        end:
-        while (count_busy()) {
-            s_cond->wait(lk);
-        }
-        if (!strict) {
-            // collect all results, by default excess results are discarded
-            for (const auto &sl : m_pods) {
-                if (sl->input().has_value() &&
-                    sl->output().has_value()) {
-                    bk(sl->input().value(), sl->output().value());
-                    sl->clean();
+
+            std::unique_lock<std::mutex> lk(m_res_mutex);
+            {
+                const detail::stats_timer wait(counter::pipeline_wait_ns);
+                m_res_cond.wait(lk, [&] { return !m_results.empty() || m_active == 0; });
+            }
+            if (m_results.empty()) {
+                if (m_error) {
+                    auto error = std::exchange(m_error, nullptr);
+                    lk.unlock();
+                    std::rethrow_exception(error);
                 }
+                return std::nullopt;
             }
+            m_ready.swap(m_results);
+            if (m_cancel.load()) {
+                m_ready.clear();
+            }
+        }
+    }
+
+    /**
+     * Stops generation of new inputs. If cancel is true checks in flight are abandoned
+     * and results not returned by next yet are discarded, otherwise next returns
+     * results of all the checks started before.
+     */
+    void stop(const bool cancel = true) {
+        m_stop.store(true);
+        if (cancel) {
+            m_cancel.store(true);
+            m_ready.clear();
+            m_ready_task = m_ready_item = 0;
         }
     }
 
     ~pipeline() {
-        for (const auto &sl : m_pods) {
-            sl->terminate();
+        drain();
+        {
+            std::lock_guard<std::mutex> lg(m_mutex);
+            m_terminate = true;
+        }
+        m_cond.notify_all();
+        for (const auto &w : m_workers) {
+            w->thread.join();
         }
     }
 };
@@ -0,0 +1,228 @@
+/**
+ * @file    stats.hpp
+ * @author  Vadim Piven <vadim@piven.tech>
+ * @license Free use of this library is permitted under the
+ * guidelines and in accordance with the MIT License (MIT).
+ * @url     https://github.com/irreducible-polynoms/irrpoly
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <cstdint>
+
+namespace irrpoly {
+
+/**
+ * Counters of the work done by operations and checks. By default they are not
+ * collected at all: counting functions are empty and vanish after inlining.
+ * Add #define IRRPOLY_STATS before #include <irrpoly.h> (the same way in all
+ * translation units) to collect them, then read them by stats().
+ */
+#ifdef IRRPOLY_STATS
+inline constexpr bool stats_enabled = true;
+#else
+inline constexpr bool stats_enabled = false;
+#endif
+
+enum class counter : unsigned {
+    multiplications, ///< polynomial products
+    remainders, ///< polynomial divisions and reductions
+    gcd_steps, ///< Euclid's algorithm steps
+    pow_steps, ///< square-and-multiply steps of powmod
+    x_pow_steps, ///< square-and-shift steps of x_pow_mod
+    allocations, ///< product buffer (re)allocations
+    checks, ///< candidates checked by multithread::check
+    rejected_constant, ///< candidates with zero constant term
+    rejected_sieve, ///< candidates with small factor found by has_small_factor
+    rejected_root_filter, ///< batch rows with roots rejected by root filter
+    rejected_berlekamp, ///< candidates rejected by Berlekamp's test
+    rejected_rabin, ///< candidates rejected by Rabin's test
+    rejected_benor, ///< candidates rejected by Ben-Or's test
+    rejected_primitive, ///< irreducible candidates which are not primitive
+    pipeline_tasks, ///< tasks processed by pipeline
+    pipeline_idle_ns, ///< time workers waited for the input generator
+    pipeline_wait_ns, ///< time calling thread waited for results
+};
+
+/// number of counters
+inline constexpr unsigned counter_count = static_cast<unsigned>(counter::pipeline_wait_ns) + 1;
+
+/// latency histogram buckets, bucket k counts checks taking [2^k, 2^(k+1)) nanoseconds
+inline constexpr unsigned latency_buckets = 64;
+
+[[nodiscard]]
+inline
+auto counter_name(const counter c) -> const char * {
+    constexpr const char *names[counter_count] = {
+        "multiplications", "remainders", "gcd_steps", "pow_steps", "x_pow_steps", "allocations",
+        "checks", "rejected_constant", "rejected_sieve", "rejected_root_filter",
+        "rejected_berlekamp", "rejected_rabin", "rejected_benor", "rejected_primitive",
+        "pipeline_tasks", "pipeline_idle_ns", "pipeline_wait_ns",
+    };
+    return names[static_cast<unsigned>(c)];
+}
+
+/**
+ * Sum of counters over all threads at the moment of stats() call.
+ */
+struct stats_snapshot {
+    std::array<uint64_t, counter_count> counters{};
+    std::array<uint64_t, latency_buckets> latency{};
+
+    [[nodiscard]]
+    auto operator[](const counter c) const -> uint64_t {
+        return counters[static_cast<unsigned>(c)];
+    }
+};
+
+namespace detail {
+
+/**
+ * Counters of single thread, written only by it, so increments need no atomic
+ * read-modify-write. Blocks are kept after thread exit, so nothing is lost.
+ */
+struct stats_block {
+    std::array<std::atomic<uint64_t>, counter_count + latency_buckets> values{};
+};
+
+struct stats_registry {
+    std::mutex mutex;
+    std::vector<std::shared_ptr<stats_block>> blocks;
+};
+
+[[nodiscard]]
+inline
+auto registry() -> stats_registry & {
+    static stats_registry res;
+    return res;
+}
+
+[[nodiscard]]
+inline
+auto thread_stats() -> stats_block & {
+    static thread_local std::shared_ptr<stats_block> block = []() {
+        auto res = std::make_shared<stats_block>();
+        auto &reg = registry();
+        const std::lock_guard<std::mutex> lg(reg.mutex);
+        reg.blocks.push_back(res);
+        return res;
+    }();
+    return *block;
+}
+
+inline
+void stats_add([[maybe_unused]] const unsigned index, [[maybe_unused]] const uint64_t n) {
+    if constexpr (stats_enabled) {
+        auto &v = thread_stats().values[index];
+        v.store(v.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * Adds n to counter c of the calling thread.
+ */
+inline
+void count([[maybe_unused]] const counter c, [[maybe_unused]] const uint64_t n = 1) {
+    stats_add(static_cast<unsigned>(c), n);
+}
+
+/**
+ * Records latency of a single check into histogram.
+ */
+inline
+void record_latency([[maybe_unused]] const uint64_t ns) {
+    if constexpr (stats_enabled) {
+        unsigned k = 0;
+        for (auto v = ns >> 1U; v && k + 1 < latency_buckets; v >>= 1U) {
+            ++k;
+        }
+        stats_add(counter_count + k, 1);
+    }
+}
+
+/**
+ * Measures its lifetime, on destruction adds it in nanoseconds to counter c,
+ * or with latency records it into the histogram and adds one to c.
+ * Does nothing when stats are disabled.
+ */
+class stats_timer final {
+private:
+#ifdef IRRPOLY_STATS
+    counter m_counter;
+    bool m_latency;
+    std::chrono::steady_clock::time_point m_begin;
+#endif
+
+public:
+    explicit
+    stats_timer([[maybe_unused]] const counter c, [[maybe_unused]] const bool latency = false)
+#ifdef IRRPOLY_STATS
+        : m_counter(c), m_latency(latency), m_begin(std::chrono::steady_clock::now())
+#endif
+    {}
+
+    stats_timer(const stats_timer &) = delete;
+
+    auto operator=(const stats_timer &) -> stats_timer & = delete;
+
+    ~stats_timer() {
+#ifdef IRRPOLY_STATS
+        const auto ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - m_begin).count());
+        if (m_latency) {
+            record_latency(ns);
+        }
+        count(m_counter, m_latency ? 1 : ns);
+#endif
+    }
+};
+
+} // namespace detail
+
+/**
+ * Returns counters summed over all threads, zeros when stats are disabled.
+ * Counters written concurrently may be slightly behind.
+ */
+[[nodiscard]]
+inline
+auto stats() -> stats_snapshot {
+    stats_snapshot res;
+    if constexpr (stats_enabled) {
+        auto &reg = detail::registry();
+        const std::lock_guard<std::mutex> lg(reg.mutex);
+        for (const auto &block : reg.blocks) {
+            for (unsigned i = 0; i < counter_count; ++i) {
+                res.counters[i] += block->values[i].load(std::memory_order_relaxed);
+            }
+            for (unsigned k = 0; k < latency_buckets; ++k) {
+                res.latency[k] += block->values[counter_count + k].load(std::memory_order_relaxed);
+            }
+        }
+    }
+    return res;
+}
+
+/**
+ * Sets all counters to zero. Should be called when no checks are running,
+ * otherwise concurrent increments may be lost or survive the reset.
+ */
+inline
+void reset_stats() {
+    if constexpr (stats_enabled) {
+        auto &reg = detail::registry();
+        const std::lock_guard<std::mutex> lg(reg.mutex);
+        for (const auto &block : reg.blocks) {
+            for (auto &v : block->values) {
+                v.store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+}
+
+} // namespace irrpoly
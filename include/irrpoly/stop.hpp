@@ -0,0 +1,100 @@
+/**
+ * @file    stop.hpp
+ * @author  Vadim Piven <vadim@piven.tech>
+ * @license Free use of this library is permitted under the
+ * guidelines and in accordance with the MIT License (MIT).
+ * @url     https://github.com/irreducible-polynoms/irrpoly
+ */
+
+#pragma once
+
+#include <atomic>
+#include <stdexcept>
+
+namespace irrpoly {
+
+/**
+ * Thrown by long computations when stop is requested for the calling thread.
+ */
+class operation_cancelled final : public std::runtime_error {
+public:
+    operation_cancelled() : std::runtime_error("operation cancelled") {}
+};
+
+/**
+ * stop_token is a non-owning view of a stop flag, default one is never stopped.
+ * Flag must outlive all the tokens referring to it.
+ */
+class stop_token final {
+private:
+    const std::atomic<bool> *m_flag;
+
+public:
+    constexpr
+    stop_token() noexcept : m_flag(nullptr) {}
+
+    explicit
+    stop_token(const std::atomic<bool> &flag) noexcept : m_flag(&flag) {}
+
+    [[nodiscard]]
+    auto stop_requested() const noexcept -> bool {
+        return m_flag && m_flag->load(std::memory_order_relaxed);
+    }
+};
+
+namespace detail {
+
+[[nodiscard]]
+inline
+auto current_stop() -> stop_token & {
+    static thread_local stop_token token;
+    return token;
+}
+
+/**
+ * Throws operation_cancelled if stop is requested for the calling thread.
+ * Called once per step of long loops, so its cost is a thread local load.
+ */
+inline
+void throw_if_stopped() {
+    if (current_stop().stop_requested()) {
+        throw operation_cancelled();
+    }
+}
+
+} // namespace detail
+
+/**
+ * Installs stop token for the calling thread during the scope lifetime: polynomial
+ * checks running in it throw operation_cancelled soon after stop is requested.
+ * Scopes could be nested, previous token is restored on exit.
+ */
+class stop_scope final {
+private:
+    stop_token m_prev;
+
+public:
+    explicit
+    stop_scope(const stop_token &token) : m_prev(detail::current_stop()) {
+        detail::current_stop() = token;
+    }
+
+    stop_scope(const stop_scope &) = delete;
+
+    auto operator=(const stop_scope &) -> stop_scope & = delete;
+
+    ~stop_scope() {
+        detail::current_stop() = m_prev;
+    }
+};
+
+/**
+ * Returns stop token of the calling thread, pipeline installs one for its payloads.
+ */
+[[nodiscard]]
+inline
+auto this_stop_token() -> stop_token {
+    return detail::current_stop();
+}
+
+} // namespace irrpoly
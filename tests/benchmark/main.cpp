@@ -12,29 +12,14 @@ auto fill_data(gf field, uintmax_t n) -> std::vector<gfpoly> {
 
     std::vector<gfpoly> data;
     data.push_back(gfpoly(field, {1}));
-    data.push_back(gfpoly(field, {0, 1}));
 
-    auto input = [&]() -> gfpoly {
-        static std::vector<uintmax_t> gear = {0};
-        static bool wrapped = false;
-        gear[0] = (gear[0] + 1) % field->base();
-        wrapped = !gear[0];
-        for (uintmax_t i = 1; wrapped && i < gear.size(); ++i) {
-            gear[i] = (gear[i] + 1) % field->base();
-            wrapped = !gear[i];
-        }
-        if (wrapped) {
-            gear.push_back(0);
-        }
-        std::vector<uintmax_t> copy(gear);
-        copy.push_back(1);
-        return gfpoly(field, copy);
-    };
-
-    while (n > 0) {
-        data.emplace_back(input());
-        if (is_primitive(data.back())) {
-            --n;
+    for (uintmax_t degree = 1; n > 0; ++degree) {
+        const auto total = monic_count(field, degree);
+        for (uintmax_t index = 0; index < total && n > 0; ++index) {
+            data.emplace_back(make_monic(field, degree, index));
+            if (is_primitive(data.back())) {
+                --n;
+            }
         }
     }
 
@@ -81,6 +66,14 @@ void bench_irreducible(const std::vector<gfpoly> &data, uintmax_t n) {
     }
 }
 
+void bench_sieve(const std::vector<gfpoly> &data, uintmax_t n) {
+    for (uintmax_t i = 0; n > 0; ++i) {
+        if (is_irreducible_sieved(data[i])) {
+            --n;
+        }
+    }
+}
+
 void bench_primitive(const std::vector<gfpoly> &data, uintmax_t n) {
     for (uintmax_t i = 0; n > 0; ++i) {
         if (is_primitive(data[i])) {
@@ -151,6 +144,9 @@ TEST_CASE("speed test") {
         BENCHMARK("gf2 200 recommended_irreducible") {
             bench_irreducible(data, N);
         };
+        BENCHMARK("gf2 200 sieve_irreducible") {
+            bench_sieve(data, N);
+        };
         BENCHMARK("gf2 200 recommended_primitive") {
             bench_primitive(data, N);
         };
@@ -171,6 +167,9 @@ TEST_CASE("speed test") {
         BENCHMARK("gf3 300 recommended_irreducible") {
             bench_irreducible(data, N);
         };
+        BENCHMARK("gf3 300 sieve_irreducible") {
+            bench_sieve(data, N);
+        };
         BENCHMARK("gf3 300 recommended_primitive") {
             bench_primitive(data, N);
         };
@@ -191,6 +190,9 @@ TEST_CASE("speed test") {
         BENCHMARK("gf5 400 recommended_irreducible") {
             bench_irreducible(data, N);
         };
+        BENCHMARK("gf5 400 sieve_irreducible") {
+            bench_sieve(data, N);
+        };
         BENCHMARK("gf5 400 recommended_primitive") {
             bench_primitive(data, N);
         };
@@ -211,6 +213,9 @@ TEST_CASE("speed test") {
         BENCHMARK("gf7 500 recommended_irreducible") {
             bench_irreducible(data, N);
         };
+        BENCHMARK("gf7 500 sieve_irreducible") {
+            bench_sieve(data, N);
+        };
         BENCHMARK("gf7 500 recommended_primitive") {
             bench_primitive(data, N);
         };
@@ -231,6 +236,9 @@ TEST_CASE("speed test") {
         BENCHMARK("gf11 600 recommended_irreducible") {
             bench_irreducible(data, N);
         };
+        BENCHMARK("gf11 600 sieve_irreducible") {
+            bench_sieve(data, N);
+        };
         BENCHMARK("gf11 600 recommended_primitive") {
             bench_primitive(data, N);
         };
@@ -242,3 +250,53 @@ TEST_CASE("speed test") {
         };
     }
 }
+
+/**
+ * Crossover points of detail::karatsuba_threshold, detail::ntt_threshold and
+ * detail::newton_threshold are selected by this test: every tier is forced
+ * for several operand lengths and the fastest one is picked.
+ */
+TEST_CASE("multiplication tiers") {
+    const auto karatsuba = detail::karatsuba_threshold, ntt = detail::ntt_threshold,
+        newton = detail::newton_threshold;
+    auto field = make_gf(3);
+    for (const uintmax_t n : {64U, 512U, 4096U}) {
+        const auto a = gfpoly::random(field, n - 1), b = gfpoly::random(field, n - 1);
+        const auto u = a * b + a, v = gfpoly::random(field, n);
+        gfpoly res(field);
+        const auto name = std::to_string(n);
+
+        detail::karatsuba_threshold = detail::ntt_threshold = detail::newton_threshold = UINTMAX_MAX;
+        BENCHMARK("schoolbook " + name) { gfpoly::mul_into(res, a, b); };
+        BENCHMARK("long division " + name) { return u % v; };
+        detail::karatsuba_threshold = karatsuba;
+        BENCHMARK("karatsuba " + name) { gfpoly::mul_into(res, a, b); };
+        detail::ntt_threshold = 1;
+        BENCHMARK("ntt " + name) { gfpoly::mul_into(res, a, b); };
+        detail::ntt_threshold = ntt;
+        detail::newton_threshold = 1;
+        BENCHMARK("newton division " + name) { return u % v; };
+        detail::newton_threshold = newton;
+    }
+}
+
+TEST_CASE("batch checks") {
+    using multithread::irreducible_method;
+    using multithread::primitive_method;
+    for (const uintmax_t P : {2U, 7U}) {
+        auto field = make_gf(P);
+        const auto batch = gfpoly_batch::random(field, 32, 256, P);
+        const auto polys = batch.rows();
+        const auto name = "gf" + std::to_string(P) + " 32";
+        BENCHMARK(name + " rabin single") {
+            uintmax_t found = 0;
+            for (const auto &p : polys) {
+                found += multithread::check(p, irreducible_method::rabin, primitive_method::nil).irreducible;
+            }
+            return found;
+        };
+        BENCHMARK(name + " rabin batch") {
+            return multithread::check(batch, irreducible_method::rabin, primitive_method::nil).size();
+        };
+    }
+}
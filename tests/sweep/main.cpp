@@ -0,0 +1,378 @@
+#include <irrpoly.h>
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <functional>
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <map>
+#include <array>
+#include <tuple>
+#include <cstring>
+
+using namespace irrpoly;
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+/// keeps results of measured calls alive
+volatile uintmax_t sink = 0;
+
+struct options {
+    std::vector<uintmax_t> bases{2, 3, 251, 65521, 2147483647};
+    uintmax_t max_degree = 4096;
+    unsigned threads = std::max(1U, std::thread::hardware_concurrency());
+    double min_time = 0.05; ///< seconds every timing sample lasts at least
+    double budget = 0.5; ///< degrees stop growing once a single call takes longer
+    std::string output;
+    std::string baseline;
+    std::string costs; ///< cost table of irreducibility tests is written there
+    double tolerance = 0.2; ///< allowed slowdown relative to the baseline
+};
+
+struct measurement {
+    double ns; ///< time of a single call
+    uintmax_t reps; ///< calls in the sample
+};
+
+/**
+ * Returns the best of three samples, each of them doubles number of calls
+ * until it lasts min_time. Calls longer than min_time are sampled once.
+ * Every sample makes at least min_reps calls, a multiple of it in general.
+ */
+auto measure(const std::function<uintmax_t()> &fn, const double min_time,
+             const uintmax_t min_reps = 1) -> measurement {
+    uintmax_t reps = min_reps;
+    double best = 0;
+    for (unsigned sample = 0; sample < 3; ++sample) {
+        for (;;) {
+            const auto start = clock_type::now();
+            for (uintmax_t r = 0; r < reps; ++r) {
+                sink = sink + fn();
+            }
+            const std::chrono::duration<double> elapsed = clock_type::now() - start;
+            if (elapsed.count() >= min_time || sample > 0) {
+                const auto ns = elapsed.count() * 1e9 / static_cast<double>(reps);
+                best = (sample == 0) ? ns : std::min(best, ns);
+                break;
+            }
+            reps *= 2;
+        }
+        if (best * 1e-9 >= min_time) {
+            break;
+        }
+    }
+    return measurement{best, reps};
+}
+
+/**
+ * Operation prepares operands for given field and degree and returns the measured call.
+ */
+struct operation {
+    const char *name;
+    std::function<std::function<uintmax_t()>(const gf &, uintmax_t, random_engine &)> prepare;
+    uintmax_t min_reps = 1; ///< calls every sample must make, see measure
+};
+
+/// candidates the tests cycle through, every sample checks all of them,
+/// so early exits are averaged even for slow tests sampled once
+constexpr uintmax_t pool_size = 32;
+
+[[nodiscard]]
+auto candidates(const gf &field, const uintmax_t n) -> std::shared_ptr<std::vector<gfmod>> {
+    auto pool = std::make_shared<std::vector<gfmod>>();
+    for (uintmax_t i = 0; i < pool_size; ++i) {
+        pool->emplace_back(random_indexed(field, n, 2020, i));
+    }
+    return pool;
+}
+
+template<typename Test>
+[[nodiscard]]
+auto test_operation(const char *name, Test test) -> operation {
+    return operation{name, [test](const gf &field, const uintmax_t n, random_engine &) {
+        auto pool = candidates(field, n);
+        auto index = std::make_shared<uintmax_t>(0);
+        return std::function<uintmax_t()>([pool, index, test]() -> uintmax_t {
+            return test((*pool)[(*index)++ % pool_size]);
+        });
+    }, pool_size};
+}
+
+[[nodiscard]]
+auto operations() -> std::vector<operation> {
+    return {
+        {"multiply", [](const gf &field, const uintmax_t n, random_engine &gen) {
+            auto a = gfpoly::random(field, n - 1, gen), b = gfpoly::random(field, n - 1, gen);
+            auto res = std::make_shared<gfpoly>(field);
+            return std::function<uintmax_t()>([a, b, res]() {
+                gfpoly::mul_into(*res, a, b);
+                return res->size();
+            });
+        }},
+        {"remainder", [](const gf &field, const uintmax_t n, random_engine &gen) {
+            auto u = gfpoly::random(field, 2 * n - 1, gen), v = gfpoly::random(field, n, gen);
+            return std::function<uintmax_t()>([u, v]() { return (u % v).size(); });
+        }},
+        {"gcd", [](const gf &field, const uintmax_t n, random_engine &gen) {
+            auto a = gfpoly::random(field, n, gen), b = gfpoly::random(field, n, gen);
+            return std::function<uintmax_t()>([a, b]() { return gcd(a, b).size(); });
+        }},
+        {"sqrmod", [](const gf &field, const uintmax_t n, random_engine &gen) {
+            auto mod = std::make_shared<gfmod>(random_indexed(field, n, 2020, 0));
+            auto a = gfpoly::random(field, n - 1, gen);
+            return std::function<uintmax_t()>([mod, a]() { return mod->sqrmod(a).size(); });
+        }},
+        {"x_pow_mod", [](const gf &field, const uintmax_t n, random_engine &) {
+            auto mod = std::make_shared<gfmod>(random_indexed(field, n, 2020, 0));
+            // 64-bit exponent, so the cost is 64 squarings for every field
+            return std::function<uintmax_t()>([mod]() { return mod->x_powmod(UINT64_MAX).size(); });
+        }},
+        test_operation("berlekamp", [](const gfmod &mod) -> uintmax_t {
+            // the packed test is the one dispatched over GF[2]
+            return (mod.modulus().base() == 2) ?
+                   is_irreducible_berlekamp(gf2poly(mod.modulus())) : is_irreducible_berlekamp(mod);
+        }),
+        test_operation("rabin", [](const gfmod &mod) -> uintmax_t {
+            return is_irreducible_rabin(mod);
+        }),
+        test_operation("benor", [](const gfmod &mod) -> uintmax_t {
+            return is_irreducible_benor(mod);
+        }),
+        test_operation("sieve", [](const gfmod &mod) -> uintmax_t {
+            return is_irreducible_sieved(mod);
+        }),
+        test_operation("recommended", [](const gfmod &mod) -> uintmax_t {
+            return is_irreducible(mod);
+        }),
+    };
+}
+
+/**
+ * Result line, one JSON object per line so results could be compared by line.
+ */
+[[nodiscard]]
+auto result_line(const std::string &op, const uintmax_t base, const uintmax_t degree,
+                 const unsigned threads, const measurement &m) -> std::string {
+    std::ostringstream os;
+    os << "{\"op\": \"" << op << "\", \"base\": " << base << ", \"degree\": " << degree;
+    if (threads) {
+        os << ", \"threads\": " << threads;
+    }
+    os << ", \"ns\": " << static_cast<uintmax_t>(m.ns) << ", \"reps\": " << m.reps << "}";
+    return os.str();
+}
+
+using result_key = std::tuple<std::string, uintmax_t, uintmax_t, uintmax_t>;
+
+/**
+ * Extracts number following "name": from the line, returns fallback if there is none.
+ */
+[[nodiscard]]
+auto field_value(const std::string &line, const std::string &name, const uintmax_t fallback) -> uintmax_t {
+    const auto pos = line.find("\"" + name + "\": ");
+    if (pos == std::string::npos) {
+        return fallback;
+    }
+    return std::stoull(line.substr(pos + name.size() + 4));
+}
+
+/**
+ * Reads results of previous run written by this program.
+ */
+[[nodiscard]]
+auto read_results(std::istream &is) -> std::map<result_key, uintmax_t> {
+    std::map<result_key, uintmax_t> res;
+    std::string line;
+    while (std::getline(is, line)) {
+        const auto pos = line.find("{\"op\": \"");
+        if (pos == std::string::npos) {
+            continue;
+        }
+        const auto begin = pos + 8, end = line.find('"', begin);
+        res[result_key(line.substr(begin, end - begin), field_value(line, "base", 0),
+                       field_value(line, "degree", 0), field_value(line, "threads", 0))] =
+            field_value(line, "ns", 0);
+    }
+    return res;
+}
+
+[[nodiscard]]
+auto parse(const int argc, char *argv[]) -> options {
+    options opt;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (arg == "--quick") {
+            opt.bases = {2, 3, 65521};
+            opt.max_degree = 256;
+            opt.min_time = 0.01;
+            opt.budget = 0.05;
+        } else if (arg == "--max-degree" && has_value) {
+            opt.max_degree = std::stoull(argv[++i]);
+        } else if (arg == "--threads" && has_value) {
+            opt.threads = std::max(1U, static_cast<unsigned>(std::stoul(argv[++i])));
+        } else if (arg == "--min-time" && has_value) {
+            opt.min_time = std::stod(argv[++i]);
+        } else if (arg == "--budget" && has_value) {
+            opt.budget = std::stod(argv[++i]);
+        } else if (arg == "--output" && has_value) {
+            opt.output = argv[++i];
+        } else if (arg == "--baseline" && has_value) {
+            opt.baseline = argv[++i];
+        } else if (arg == "--costs" && has_value) {
+            opt.costs = argv[++i];
+        } else if (arg == "--tolerance" && has_value) {
+            opt.tolerance = std::stod(argv[++i]);
+        } else {
+            throw std::invalid_argument("unknown argument " + arg);
+        }
+    }
+    return opt;
+}
+
+} // namespace
+
+/**
+ * Sweeps operations over fields and degrees 8..max_degree (powers of two),
+ * then measures thread scaling of the pipeline. Results are written as JSON,
+ * with --baseline they are compared to the previous run and slowdowns beyond
+ * tolerance are reported, in that case exit code is 1.
+ */
+auto main(int argc, char *argv[]) -> int {
+    const auto opt = parse(argc, argv);
+    std::vector<std::string> lines;
+
+    // measured costs of the tests, the sieve is followed by the cheapest of the others,
+    // so it is measured with the table of them set, "recommended" with the original one
+    const auto original = irreducible_costs();
+    std::map<std::pair<uintmax_t, uintmax_t>, std::array<double, irreducible_test_count>> costs;
+    const auto cost_entries = [&costs]() {
+        std::vector<cost_entry> res;
+        for (const auto &[key, ns] : costs) {
+            res.push_back(cost_entry{key.first, key.second, test_backend_for(key.first, key.second), ns});
+        }
+        return cost_table(std::move(res));
+    };
+
+    for (const auto &op : operations()) {
+        const std::string name = op.name;
+        if (name == "sieve") {
+            set_irreducible_costs(cost_entries());
+        } else if (name == "recommended") {
+            set_irreducible_costs(original);
+        }
+        for (const auto P : opt.bases) {
+            const auto field = make_gf(P);
+            random_engine gen(P);
+            for (uintmax_t n = 8; n <= opt.max_degree; n *= 2) {
+                const auto m = measure(op.prepare(field, n, gen), opt.min_time, op.min_reps);
+                lines.emplace_back(result_line(op.name, P, n, 0, m));
+                std::cerr << lines.back() << std::endl;
+                for (unsigned t = 0; t < irreducible_test_count; ++t) {
+                    if (name == test_name(static_cast<irreducible_test>(t))) {
+                        costs[{P, n}][t] = m.ns;
+                    }
+                }
+                if (m.ns * 1e-9 > opt.budget) {
+                    break; // larger degrees take even longer
+                }
+            }
+        }
+    }
+
+    // candidates are checked in batches, so the number of them is fixed for the whole run
+    const uintmax_t scaling_base = 3, scaling_degree = std::min<uintmax_t>(64, opt.max_degree);
+    const uintmax_t scaling_count = 4096;
+    const auto field = make_gf(scaling_base);
+    std::vector<unsigned> threads;
+    for (unsigned t = 1; t < opt.threads; t *= 2) {
+        threads.push_back(t);
+    }
+    threads.push_back(opt.threads);
+    for (const auto t : threads) {
+        multithread::polychecker ch(t);
+        const auto m = measure([&]() -> uintmax_t {
+            std::atomic<uint64_t> index(0);
+            uintmax_t done = 0, found = 0;
+            ch.chain_batch(
+                [&]() { return random_indexed(field, scaling_degree, 2020, index++); },
+                multithread::make_batch_check_func(multithread::irreducible_method::recommended,
+                                                   multithread::primitive_method::nil),
+                [&](const gfpoly &, const multithread::check_result &res) {
+                    found += res.irreducible;
+                    return ++done == scaling_count;
+                });
+            return found;
+        }, opt.min_time);
+        lines.emplace_back(result_line("pipeline", scaling_base, scaling_degree, t, m));
+        std::cerr << lines.back() << std::endl;
+    }
+
+    std::ofstream file;
+    if (!opt.output.empty()) {
+        file.open(opt.output);
+    }
+    std::ostream &out = opt.output.empty() ? std::cout : file;
+    out << "{\n  \"meta\": {\"compiler\": \"" << __VERSION__ << "\", \"optimized\": "
+#ifdef NDEBUG
+        << "true"
+#else
+        << "false"
+#endif
+        << ", \"hardware_threads\": " << std::thread::hardware_concurrency()
+        << ", \"min_time\": " << opt.min_time << "},\n  \"results\": [\n";
+    for (std::size_t i = 0; i < lines.size(); ++i) {
+        out << "    " << lines[i] << (i + 1 < lines.size() ? ",\n" : "\n");
+    }
+    out << "  ]\n}\n";
+    out.flush();
+
+    if (!opt.costs.empty()) {
+        std::ofstream costs_file(opt.costs);
+        costs_file << cost_entries();
+        if (!costs_file) {
+            std::cerr << "can't write cost table " << opt.costs << std::endl;
+            return 2;
+        }
+    }
+
+    if (opt.baseline.empty()) {
+        return 0;
+    }
+    std::ifstream in(opt.baseline);
+    if (!in) {
+        std::cerr << "can't open baseline " << opt.baseline << std::endl;
+        return 2;
+    }
+    const auto before = read_results(in);
+    std::istringstream now_in;
+    std::string now_text;
+    for (const auto &line : lines) {
+        now_text += line + "\n";
+    }
+    now_in.str(now_text);
+    bool regressed = false;
+    for (const auto &[key, ns] : read_results(now_in)) {
+        const auto it = before.find(key);
+        if (it == before.end() || it->second == 0) {
+            continue;
+        }
+        const auto ratio = static_cast<double>(ns) / static_cast<double>(it->second);
+        if (ratio > 1 + opt.tolerance) {
+            regressed = true;
+            std::cerr << "regression: " << std::get<0>(key) << " base " << std::get<1>(key)
+                      << " degree " << std::get<2>(key);
+            if (std::get<3>(key)) {
+                std::cerr << " threads " << std::get<3>(key);
+            }
+            std::cerr << " is " << ratio << "x slower" << std::endl;
+        }
+    }
+    return regressed ? 1 : 0;
+}
@@ -1,3 +1,5 @@
+// counters are checked by the stats test, the rest of tests run with them collected
+#define IRRPOLY_STATS
 #include <irrpoly.h>
 
 #define CATCH_CONFIG_MAIN
@@ -19,6 +21,41 @@ TEST_CASE("gf could be constructed when it exists", "[gf]") {
     }
 }
 
+TEST_CASE("gf inverse strategies work", "[gf]") {
+    SECTION("on demand for small field") {
+        REQUIRE_THROWS(make_gf(4, gf_inverse::euclid));
+        auto gf5 = make_gf(5, gf_inverse::euclid);
+        REQUIRE(gf5->mul_inv(2) == 3);
+        REQUIRE(gf5->mul_inv(4) == 4);
+        REQUIRE_THROWS(gf5->mul_inv(0));
+    }SECTION("on demand for large field") {
+        REQUIRE_THROWS(make_gf(4294967297));
+        auto field = make_gf(4294967291);
+        for (uintmax_t v : {1ULL, 2ULL, 12345ULL, 4294967290ULL}) {
+            REQUIRE(field->mul(v, field->mul_inv(v)) == 1);
+        }
+#ifdef __SIZEOF_INT128__
+        auto wide = make_gf(9223372036854775783ULL);
+        REQUIRE(gfn(wide, 9223372036854775782ULL) * gfn(wide, 9223372036854775782ULL) == 1);
+        REQUIRE(gfn(wide, 12345) / gfn(wide, 12345) == 1);
+        // wide products are reduced with precomputed reciprocal instead of 128-bit division
+        std::mt19937_64 gen(5);
+        for (uintmax_t base : {9223372036854775783ULL, 4294967311ULL}) {
+            auto field = make_gf(base);
+            std::vector<uintmax_t> vals = {0, 1, 2, base / 2, base - 2, base - 1};
+            for (int i = 0; i < 1000; ++i) {
+                vals.push_back(gen() % base);
+            }
+            for (std::size_t i = 0; i < vals.size(); ++i) {
+                const auto a = vals[i], b = vals[(i * 7 + 3) % vals.size()];
+                REQUIRE(field->mul(a, b) == detail::mul_mod(a, b, base));
+                REQUIRE(field->mul(a, a) == detail::mul_mod(a, a, base));
+            }
+        }
+#endif
+    }
+}
+
 TEST_CASE("gf comparison works", "[gf]") {
     auto gf2 = make_gf(2);
     SECTION("equal to self") {
@@ -48,6 +85,19 @@ TEST_CASE("gf methods work", "[gf]") {
     }
 }
 
+TEST_CASE("gf arithmetic matches plain modulo", "[gf]") {
+    auto field = make_gf(65521);
+    std::mt19937_64 gen(42);
+    for (auto _ : std::vector<int>(1000)) {
+        const uintmax_t a = gen() % 65521, b = gen() % 65521, c = gen();
+        REQUIRE(field->reduce(c) == c % 65521);
+        REQUIRE(field->add(a, b) == (a + b) % 65521);
+        REQUIRE(field->sub(a, b) == (65521 + a - b) % 65521);
+        REQUIRE(field->neg(a) == (65521 - a) % 65521);
+        REQUIRE(field->mul(a, b) == (a * b) % 65521);
+    }
+}
+
 TEST_CASE("gfn could be created correctly", "[gfn]") {
     auto gf5 = make_gf(5);
     SECTION("for direct constructed") {
@@ -217,6 +267,10 @@ TEST_CASE("gfpoly input works correctly", "[gfpoly]") {
     REQUIRE_THROWS(std::stringstream("{0, 1, ") >> poly);
     REQUIRE_THROWS(std::stringstream("0, 1}") >> poly);
     REQUIRE_THROWS(std::stringstream("{-0, 1}") >> poly);
+    // number right before the closing brace is not lost
+    REQUIRE(std::stringstream("{1,2}") >> poly);
+    REQUIRE(poly.value() == std::vector<uintmax_t>({1, 2}));
+    REQUIRE_THROWS(std::stringstream("{99999999999999999999999}") >> poly);
 }
 
 TEST_CASE("gfpoly operations work correctly", "[gfpoly]") {
@@ -296,3 +350,1332 @@ TEST_CASE("gfpoly operations work correctly", "[gfpoly]") {
         REQUIRE(poly == gfpoly(gf5));
     }
 }
+
+TEST_CASE("gf_static works the same way as gf", "[gf_static]") {
+    auto gf5 = make_gf<5>();
+    SECTION("method base() works") {
+        REQUIRE(gf5->base() == 5);
+        REQUIRE(gf5 == make_gf<5>());
+    }SECTION("method mul_inv() works") {
+        REQUIRE_THROWS(gf5->mul_inv(0));
+        REQUIRE(gf5->mul_inv(1) == 1);
+        REQUIRE(gf5->mul_inv(2) == 3);
+        REQUIRE(gf5->mul_inv(3) == 2);
+        REQUIRE(gf5->mul_inv(4) == 4);
+    }SECTION("gfn operations work") {
+        using num = basic_gfn<gf_static<5>>;
+        REQUIRE(num(gf5, 2) + num(gf5, 3) == 0);
+        REQUIRE(num(gf5, 2) - num(gf5, 3) == 4);
+        REQUIRE(num(gf5, 2) * num(gf5, 3) == 1);
+        REQUIRE(num(gf5, 2) / num(gf5, 3) == 4);
+        REQUIRE_THROWS(num(gf5, 2) / 0);
+    }SECTION("gfpoly operations work") {
+        using poly = basic_gfpoly<gf_static<5>>;
+        auto p = poly(gf5, {0, 1, 2, 3, 4});
+        REQUIRE(p * poly(gf5, {1, 2}) == poly(gf5, {0, 1, 4, 2, 0, 3}));
+        REQUIRE(p / poly(gf5, {1, 1, 1}) == poly(gf5, {4, 4, 4}));
+        REQUIRE(p % poly(gf5, {1, 1, 1}) == poly(gf5, {1, 3}));
+    }
+}
+
+TEST_CASE("checks give same results for gf and gf_static", "[gfcheck]") {
+    auto dynamic = make_gf(3);
+    auto fixed = make_gf<3>();
+    for (uintmax_t i = 0; i < 50; ++i) {
+        auto poly = gfpoly::random(dynamic, 2 + i % 7);
+        auto same = basic_gfpoly<gf_static<3>>(fixed, poly.value());
+        REQUIRE(is_irreducible_berlekamp(poly) == is_irreducible_berlekamp(same));
+        REQUIRE(is_irreducible_rabin(poly) == is_irreducible_rabin(same));
+        REQUIRE(is_irreducible_benor(poly) == is_irreducible_benor(same));
+        REQUIRE(is_primitive(poly) == is_primitive(same));
+    }
+}
+
+TEST_CASE("gf2poly operations work correctly", "[gf2poly]") {
+    auto gf2 = make_gf(2);
+    SECTION("packing works") {
+        auto poly = gfpoly(gf2, {1, 0, 1, 1});
+        auto packed = gf2poly(poly);
+        REQUIRE(packed.degree() == 3);
+        REQUIRE(packed == gf2poly({1, 0, 1, 1, 0}));
+        REQUIRE(packed.to_gfpoly(gf2) == poly);
+        REQUIRE_THROWS(gf2poly(gfpoly(make_gf(3), {1, 1})));
+    }SECTION("arithmetic matches gfpoly") {
+        for (uintmax_t i = 0; i < 20; ++i) {
+            auto a = gfpoly::random(gf2, 30 + i * 7);
+            auto b = gfpoly::random(gf2, 10 + i * 5);
+            auto pa = gf2poly(a), pb = gf2poly(b);
+            REQUIRE((pa + pb).to_gfpoly(gf2) == a + b);
+            REQUIRE((pa * pb).to_gfpoly(gf2) == a * b);
+            REQUIRE((pa / pb).to_gfpoly(gf2) == a / b);
+            REQUIRE((pa % pb).to_gfpoly(gf2) == a % b);
+            REQUIRE((pa << 70).to_gfpoly(gf2) == (a << 70));
+            REQUIRE(((pa << 70) >> 70) == pa);
+            REQUIRE(gcd(pa, pb).to_gfpoly(gf2) == gcd(a, b) / gcd(a, b)[gcd(a, b).degree()]);
+            REQUIRE(detail::x_pow_mod(1000 + i, pb).to_gfpoly(gf2)
+                        == detail::x_pow_mod(1000 + i, b));
+        }
+    }SECTION("irreducibility matches gfpoly") {
+        for (uintmax_t i = 0; i < 100; ++i) {
+            auto poly = gfpoly::random(gf2, 2 + i % 70);
+            REQUIRE(is_irreducible_berlekamp(gf2poly(poly)) == is_irreducible_berlekamp(poly));
+        }
+    }SECTION("selected kernels match portable ones") {
+        std::mt19937_64 gen(7);
+        std::vector<uint64_t> a(9), b(5), row(11), src(11);
+        for (uintmax_t i = 0; i < 200; ++i) {
+            const uint64_t x = (i < 4) ? ~uint64_t(0) >> i : gen(), y = (i < 4) ? ~uint64_t(0) : gen();
+            uint64_t hi = 0, hp = 0;
+            const auto lo = detail::clmul(x, y, hi);
+            REQUIRE(lo == detail::clmul_portable(x, y, hp));
+            REQUIRE(hi == hp);
+        }
+        for (auto &w : a) { w = gen(); }
+        for (auto &w : b) { w = gen(); }
+        std::vector<uint64_t> prod(a.size() + b.size(), 0), expect(prod);
+        detail::clmul_words(prod.data(), a.data(), a.size(), b.data(), b.size());
+        for (uintmax_t i = 0; i < a.size(); ++i) {
+            for (uintmax_t j = 0; j < b.size(); ++j) {
+                uint64_t hi = 0;
+                expect[i + j] ^= detail::clmul_portable(a[i], b[j], hi);
+                expect[i + j + 1] ^= hi;
+            }
+        }
+        REQUIRE(prod == expect);
+        for (uintmax_t len = 0; len <= row.size(); ++len) {
+            for (auto &w : row) { w = gen(); }
+            for (auto &w : src) { w = gen(); }
+            auto expect_row = row;
+            for (uintmax_t i = 0; i < len; ++i) {
+                expect_row[i] ^= src[i];
+            }
+            detail::xor_row(row.data(), src.data(), len);
+            REQUIRE(row == expect_row);
+        }
+    }
+}
+
+TEST_CASE("x_pow_mod and frobenius work correctly", "[gfcheck]") {
+    auto gf5 = make_gf(5);
+    auto mod = gfpoly(gf5, {2, 0, 3, 1, 4});
+    SECTION("x_pow_mod matches repeated multiplication") {
+        auto x = gfpoly(gf5, {0, 1});
+        auto res = gfpoly(gf5, 1);
+        for (uintmax_t i = 0; i < 200; ++i) {
+            REQUIRE(detail::x_pow_mod(i, mod) == res);
+            res = res * x % mod;
+        }
+    }SECTION("frobenius chain matches x_pow_mod") {
+        detail::frobenius<gf> frob(mod);
+        auto xpi = frob.x_pow_p();
+        uintmax_t pow = 5;
+        for (uintmax_t i = 1; i < 20; ++i, pow *= 5) {
+            REQUIRE(xpi == detail::x_pow_mod(pow, mod));
+            xpi = frob.apply(xpi);
+        }
+    }
+}
+
+TEST_CASE("checks find all irreducible and primitive polynomials", "[gfcheck]") {
+    // number of monic irreducible polynomials is (1/n) sum mu(d) P^(n/d),
+    // number of primitive is phi(P^n - 1) / n
+    auto count = [](uintmax_t P, uintmax_t n, auto check) {
+        auto field = make_gf(P);
+        uintmax_t total = 1, res = 0;
+        for (uintmax_t i = 0; i < n; ++i) {
+            total *= P;
+        }
+        for (uintmax_t index = 0; index < total; ++index) {
+            std::vector<uintmax_t> data(n + 1, 1);
+            for (uintmax_t i = 0, j = index; i < n; ++i, j /= P) {
+                data[i] = j % P;
+            }
+            res += check(gfpoly(field, data)) ? 1 : 0;
+        }
+        return res;
+    };
+    auto berlekamp = [](const gfpoly &p) { return is_irreducible_berlekamp(p); };
+    auto rabin = [](const gfpoly &p) { return is_irreducible_rabin(p); };
+    auto benor = [](const gfpoly &p) { return is_irreducible_benor(p); };
+    auto recommended = [](const gfpoly &p) { return is_irreducible(p); };
+    auto primitive = [](const gfpoly &p) { return is_primitive(p); };
+    SECTION("GF[2] degree 8") {
+        REQUIRE(count(2, 8, berlekamp) == 30);
+        REQUIRE(count(2, 8, rabin) == 30);
+        REQUIRE(count(2, 8, benor) == 30);
+        REQUIRE(count(2, 8, recommended) == 30);
+        REQUIRE(count(2, 8, primitive) == 16);
+    }SECTION("GF[3] degree 4") {
+        REQUIRE(count(3, 4, berlekamp) == 18);
+        REQUIRE(count(3, 4, rabin) == 18);
+        REQUIRE(count(3, 4, benor) == 18);
+        REQUIRE(count(3, 4, recommended) == 18);
+        REQUIRE(count(3, 4, primitive) == 8);
+    }SECTION("GF[5] degree 3") {
+        REQUIRE(count(5, 3, berlekamp) == 40);
+        REQUIRE(count(5, 3, rabin) == 40);
+        REQUIRE(count(5, 3, benor) == 40);
+        REQUIRE(count(5, 3, primitive) == 20);
+    }SECTION("GF[7] degree 4") {
+        REQUIRE(count(7, 4, berlekamp) == 588);
+        REQUIRE(count(7, 4, rabin) == 588);
+        REQUIRE(count(7, 4, benor) == 588);
+    }
+}
+
+TEST_CASE("biguint arithmetic works correctly", "[biguint]") {
+    using detail::biguint;
+    const auto m64 = biguint::power(2, 64) - 1;
+    const auto m128 = biguint::power(2, 128) - 1;
+    REQUIRE(m64.to_string() == "18446744073709551615");
+    REQUIRE(m128.to_string() == "340282366920938463463374607431768211455");
+    REQUIRE(m128 / m64 == biguint::power(2, 64) + 1);
+    REQUIRE(m128 % m64 == 0);
+    REQUIRE((m128 - 12345) % m64 == m64 - 12345);
+    REQUIRE(biguint::power(3, 100) / biguint::power(3, 60) == biguint::power(3, 40));
+    REQUIRE(biguint::power(7, 30) % biguint::power(2, 40) ==
+        biguint::power(7, 30) - biguint::power(7, 30) / biguint::power(2, 40) * biguint::power(2, 40));
+    REQUIRE(detail::is_prime(biguint::power(2, 127) - 1));
+    REQUIRE_FALSE(detail::is_prime(m128));
+    const std::vector<biguint> f128 = {3, 5, 17, 257, 641, 65537, 274177, 6700417, 67280421310721};
+    REQUIRE(detail::prime_divisors(m128) == f128);
+    REQUIRE(detail::primitive_factors(2, 128) == f128);
+    REQUIRE(detail::primitive_factors(3, 5) == std::vector<biguint>{11});
+
+    REQUIRE(biguint::parse("340282366920938463463374607431768211455") == m128);
+    REQUIRE_THROWS_AS(biguint::parse("12a"), std::invalid_argument);
+    REQUIRE_THROWS_AS(biguint::parse(""), std::invalid_argument);
+    // Montgomery product is a * b / 2^(32k) mod n
+    const auto n = biguint::power(3, 80) + 2;
+    detail::montgomery mont(n);
+    const auto a = biguint::power(7, 40) % n, b = biguint::power(5, 50) % n;
+    auto la = mont.to_limbs(a);
+    mont.mul(la, mont.to_limbs(b));
+    REQUIRE(detail::montgomery::from_limbs(la) * biguint::power(2, 32 * 4) % n == a * b % n);
+    REQUIRE(detail::pollard_brent(biguint(1000003) * biguint(998244353)) % 1000003 == 0);
+
+    // Phi_d(P) are factored one by one, so the result is the same as of plain factorization
+    for (uintmax_t d : {12, 30, 36}) {
+        REQUIRE(detail::factor_primitive_exponent(5, d) ==
+                detail::prime_divisors((biguint::power(5, d) - 1) / 4));
+    }
+    REQUIRE_THROWS_AS(register_prime_divisors({"1000004"}), std::invalid_argument);
+    REQUIRE_NOTHROW(register_prime_divisors({"1000003"}));
+    REQUIRE(detail::known_primes::instance().divisors(biguint(1000003) * 5) == std::vector<biguint>{1000003});
+}
+
+TEST_CASE("primitivity test works for big degrees", "[gfcheck]") {
+    auto gf2 = make_gf(2);
+    auto make = [&](const std::vector<uintmax_t> &taps) {
+        std::vector<uintmax_t> data(taps[0] + 1, 0);
+        for (auto t : taps) {
+            data[t] = 1;
+        }
+        return gfpoly(gf2, data);
+    };
+    REQUIRE(is_primitive(make({64, 4, 3, 1, 0})));
+    REQUIRE(is_primitive(make({64, 63, 61, 60, 0})));
+    REQUIRE(is_primitive(make({127, 1, 0})));
+    REQUIRE(is_primitive(make({128, 7, 2, 1, 0})));
+    REQUIRE(is_primitive(make({128, 29, 27, 2, 0})));
+    REQUIRE(is_primitive(make({128, 127, 126, 121, 0})));
+    REQUIRE(is_irreducible(make({64, 58, 39, 31, 0})));
+    REQUIRE_FALSE(is_primitive(make({64, 58, 39, 31, 0})));
+
+    // these have divisors out of Pollard's rho reach (2^128 + 1 divides 2^256 - 1),
+    // they are known primes
+    const std::vector<std::pair<uintmax_t, uintmax_t>> hard = {{2, 137}, {2, 256}, {2, 1024}, {3, 119}};
+    for (const auto &[P, n] : hard) {
+        auto rest = (detail::biguint::power(P, n) - 1) / (P - 1);
+        for (const auto &q : primitivity_context::cached(P, n).primes()) {
+            REQUIRE(detail::is_prime(q));
+            REQUIRE(rest % q == 0);
+            while (rest % q == 0) {
+                rest /= q;
+            }
+        }
+        REQUIRE(rest == 1);
+    }
+    const auto &ctx = primitivity_context::cached(2, 256);
+    REQUIRE(is_primitive(make({256, 10, 5, 2, 0})));
+    // the split of the context agrees with x^(r / q) != 1 computed one by one
+    const auto r = detail::biguint::power(2, 256) - 1;
+    unsigned primitive = 0, total = 0;
+    for (uint64_t index = 0; total < 6; ++index) {
+        const auto poly = random_indexed(gf2, 256, 11, index);
+        if (!is_irreducible(poly)) {
+            continue;
+        }
+        bool expected = true;
+        for (const auto &q : ctx.primes()) {
+            expected = expected && detail::x_pow_mod(r / q, poly).degree() > 0;
+        }
+        REQUIRE(is_primitive(poly) == expected);
+        primitive += expected;
+        ++total;
+    }
+    REQUIRE(primitive > 0);
+    REQUIRE(primitive < total);
+}
+
+TEST_CASE("primitivity context is shared by candidates of the same field and degree", "[gfcheck]") {
+    // r = 4095 = 3^2 * 5 * 7 * 13, so x^(r / q) are split over four primes,
+    // reducible candidates are tested too, phi(4095) / 12 of them are primitive
+    const auto &ctx = primitivity_context::cached(2, 12);
+    REQUIRE(&ctx == &primitivity_context::cached(2, 12));
+    REQUIRE(ctx.primes() == std::vector<detail::biguint>{3, 5, 7, 13});
+    const auto gf2 = make_gf(2);
+    uintmax_t found = 0;
+    for (uintmax_t index = 0; index < 4096; ++index) {
+        found += ctx.is_primitive(gfmod(make_monic(gf2, 12, index)));
+    }
+    REQUIRE(found == 144);
+    // GF[7] has primitive elements 3 and 5, phi(342) / 3 = 36
+    const auto gf7 = make_gf(7);
+    found = 0;
+    for (uintmax_t index = 0; index < 343; ++index) {
+        found += is_primitive_definition(make_monic(gf7, 3, index));
+    }
+    REQUIRE(found == 36);
+    REQUIRE_THROWS_AS(ctx.is_primitive(gfmod(make_monic(gf2, 8, 1))), std::invalid_argument);
+    REQUIRE_THROWS_AS(primitivity_context(3, 0), std::invalid_argument);
+
+    // cancelled factorization is not cached, next demand builds the context
+    {
+        std::atomic<bool> stop(true);
+        const stop_scope scope{stop_token(stop)};
+        REQUIRE_THROWS_AS(primitivity_context::cached(7, 45), operation_cancelled);
+    }
+    REQUIRE(primitivity_context::cached(7, 45).degree() == 45);
+
+    // factorization of (65521^13 - 1) / 65520 takes minutes, other contexts don't wait for it
+    std::atomic<bool> stop(false), cancelled(false), finished(false);
+    std::thread slow([&]() {
+        const stop_scope scope{stop_token(stop)};
+        try {
+            (void) primitivity_context::cached(65521, 13);
+        } catch (const operation_cancelled &) {
+            cancelled = true;
+        }
+        finished = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    REQUIRE(primitivity_context::cached(2, 20).primes() == std::vector<detail::biguint>{3, 5, 11, 31, 41});
+    REQUIRE_FALSE(finished);
+    stop = true;
+    slow.join();
+    REQUIRE(cancelled);
+}
+
+TEST_CASE("pipeline delivers every result exactly once", "[pipeline]") {
+    auto gf2 = make_gf(2);
+    for (unsigned threads : {1U, 2U, 4U}) {
+        multithread::polychecker ch(threads, 4, threads == 2 ? 0 : 16);
+        for (unsigned run = 0; run < 4; ++run) {
+            // polynomials of degree 8 are followed by ones of degree 9
+            uintmax_t index = 0;
+            auto input = [&]() -> gfpoly {
+                std::vector<uintmax_t> data(index < 256 ? 9 : 10, 0);
+                for (uintmax_t i = 0; i < 8; ++i) {
+                    data[i] = (index >> i) & 1U;
+                }
+                data.back() = 1;
+                ++index;
+                return gfpoly(gf2, data);
+            };
+            auto check = multithread::make_check_func(
+                multithread::irreducible_method::recommended,
+                multithread::primitive_method::nil);
+            std::vector<bool> seen(256, false);
+            uintmax_t total = 0, irreducible = 0;
+            auto callback = [&](const gfpoly &poly, const multithread::check_result &result) -> bool {
+                if (poly.degree() != 8) {
+                    return false;
+                }
+                uintmax_t i = 0;
+                for (uintmax_t j = 0; j < 8; ++j) {
+                    i |= poly[j] << j;
+                }
+                REQUIRE_FALSE(seen[i]);
+                seen[i] = true;
+                irreducible += result.irreducible ? 1 : 0;
+                return ++total == 256;
+            };
+            if (run % 2) {
+                ch.chain_batch(input, multithread::make_batch_check_func(
+                    multithread::irreducible_method::recommended,
+                    multithread::primitive_method::nil), callback);
+            } else {
+                ch.chain(input, check, callback);
+            }
+            REQUIRE(total == 256);
+            REQUIRE(irreducible == 30);
+        }
+    }
+}
+
+TEST_CASE("batch payload checks zero polynomial alone", "[pipeline]") {
+    auto gf2 = make_gf(2);
+    const auto fn = multithread::make_batch_check_func(
+        multithread::irreducible_method::recommended,
+        multithread::primitive_method::recommended);
+    std::vector<std::optional<multithread::check_result>> res(3);
+    REQUIRE_NOTHROW(fn({gfpoly(gf2, {1, 1, 1}), gfpoly(gf2), gfpoly(gf2, {1, 0, 1})}, res));
+    REQUIRE(res[0]->irreducible);
+    REQUIRE(res[0]->primitive);
+    REQUIRE_FALSE(res[1]->irreducible);
+    REQUIRE_FALSE(res[1]->primitive);
+    REQUIRE_FALSE(res[2]->irreducible);
+}
+
+TEST_CASE("enumerate finds polynomials in canonical order", "[gfenum]") {
+    auto gf3 = make_gf(3);
+    REQUIRE(monic_count(gf3, 4) == 81);
+    REQUIRE(make_monic(gf3, 3, 5) == gfpoly(gf3, {2, 1, 0, 1}));
+    REQUIRE_THROWS_AS(monic_count(gf3, 41), std::invalid_argument);
+
+    std::vector<gfpoly> expected;
+    for (uintmax_t i = 0; i < monic_count(gf3, 4); ++i) {
+        auto poly = make_monic(gf3, 4, i);
+        if (is_irreducible(poly)) {
+            expected.push_back(poly);
+        }
+    }
+    REQUIRE(expected.size() == 18);
+    for (unsigned threads : {1U, 3U}) {
+        REQUIRE(multithread::enumerate(gf3, 4, multithread::irreducible_method::rabin,
+                                       multithread::primitive_method::nil, threads) == expected);
+        REQUIRE(multithread::enumerate(gf3, 4, multithread::irreducible_method::nil,
+                                       multithread::primitive_method::recommended, threads).size() == 8);
+    }
+    REQUIRE(multithread::enumerate(make_gf(2), 8, [](const gfpoly &p) { return is_irreducible(p); }, 4).size() == 30);
+}
+
+TEST_CASE("gfpoly in-place kernels match operators", "[gfpoly]") {
+    auto gf7 = make_gf(7);
+    gfpoly prod(gf7), q(gf7), r(gf7);
+    for (uintmax_t i = 0; i < 50; ++i) {
+        auto a = gfpoly::random(gf7, 10 + i % 13), b = gfpoly::random(gf7, 1 + i % 7);
+        gfpoly::mul_into(prod, a, b);
+        REQUIRE(prod == a * b);
+        gfpoly::divrem_into(q, r, a, b);
+        REQUIRE(q * b + r == a);
+        REQUIRE((r.is_zero() || r.degree() < b.degree()));
+        auto c = a;
+        REQUIRE(c.rem_inplace(b) == r);
+        REQUIRE(a / b == q);
+        REQUIRE(a % b == r);
+    }
+    auto a = gfpoly(gf7, {1, 2, 3}), b = gfpoly(gf7, {4, 5});
+    swap(a, b);
+    REQUIRE(a == gfpoly(gf7, {4, 5}));
+    REQUIRE(b == gfpoly(gf7, {1, 2, 3}));
+}
+
+TEST_CASE("gcd, half-gcd and xgcd agree", "[gfcheck]") {
+    auto gf5 = make_gf(5);
+    const auto threshold = detail::hgcd_threshold;
+    for (uintmax_t i = 0; i < 60; ++i) {
+        auto common = gfpoly::random(gf5, i % 9);
+        auto a = gfpoly::random(gf5, 20 + i % 37) * common, b = gfpoly::random(gf5, 5 + i % 41) * common;
+        auto [g, s, t] = xgcd(a, b);
+        REQUIRE(s * a + t * b == g);
+        REQUIRE((a % g).is_zero());
+        REQUIRE((b % g).is_zero());
+        REQUIRE(g.degree() >= common.degree());
+        detail::hgcd_threshold = 1 + i % 4;
+        REQUIRE(gcd(a, b) == g);
+        detail::hgcd_threshold = threshold;
+        REQUIRE(gcd(b, a) == g);
+    }
+}
+
+TEST_CASE("multiplication and division tiers agree", "[gfpoly]") {
+    const auto karatsuba = detail::karatsuba_threshold, ntt = detail::ntt_threshold,
+        newton = detail::newton_threshold;
+    for (const uintmax_t base : {2U, 3U, 65521U, 2147483647U}) {
+        auto field = make_gf(base);
+        for (uintmax_t i = 0; i < 24; ++i) {
+            const auto a = gfpoly::random(field, 1 + i * 13 % 150), b = gfpoly::random(field, i * 7 % 90);
+            detail::karatsuba_threshold = detail::ntt_threshold = detail::newton_threshold = UINTMAX_MAX;
+            const auto prod = a * b, square = a * a;
+            const auto q = (prod + a) / b, r = (prod + a) % b;
+            const auto pow = detail::x_pow_mod(base * 7 + i, a);
+            detail::karatsuba_threshold = 2 + i % 5;
+            REQUIRE(a * b == prod);
+            REQUIRE(a * a == square);
+            detail::ntt_threshold = 1 + i % 3;
+            REQUIRE(a * b == prod);
+            REQUIRE(a * a == square);
+            detail::newton_threshold = 1 + i % 2;
+            REQUIRE((prod + a) / b == q);
+            REQUIRE((prod + a) % b == r);
+            REQUIRE(detail::x_pow_mod(base * 7 + i, a) == pow);
+            detail::karatsuba_threshold = karatsuba;
+            detail::ntt_threshold = ntt;
+            detail::newton_threshold = newton;
+        }
+    }
+}
+
+TEST_CASE("delayed reduction matches direct arithmetic", "[gfpoly]") {
+    for (const uintmax_t base : {3U, 65521U, 2147483647U, 4294967291U}) {
+        auto field = make_gf(base);
+        for (uintmax_t i = 0; i < 12; ++i) {
+            const auto a = gfpoly::random(field, 10 + i * 11), b = gfpoly::random(field, 5 + i * 7);
+            std::vector<uintmax_t> prod(a.size() + b.size() - 1, 0);
+            for (uintmax_t j = 0; j < a.size(); ++j) {
+                for (uintmax_t k = 0; k < b.size(); ++k) {
+                    prod[j + k] = field->add(prod[j + k], field->mul(a[j], b[k]));
+                }
+            }
+            REQUIRE(a * b == gfpoly(field, prod));
+            const auto u = a * b + gfpoly::random(field, i * 2);
+            const auto q = u / b, r = u % b;
+            REQUIRE(r.degree() < b.degree());
+            REQUIRE(q * b + r == u);
+        }
+        for (uintmax_t i = 0; i < 20; ++i) {
+            const auto poly = gfpoly::random(field, 2 + i % 9);
+            REQUIRE(is_irreducible_berlekamp(poly) == is_irreducible_rabin(poly));
+        }
+    }
+}
+
+TEST_CASE("gfmod operations match plain remainder", "[gfmod]") {
+    REQUIRE_THROWS_AS(gfmod(gfpoly(make_gf(3))), std::domain_error);
+    const auto newton = detail::newton_threshold;
+    for (const uintmax_t threshold : {newton, uintmax_t(3)}) {
+        detail::newton_threshold = threshold;
+        for (const uintmax_t base : {2U, 7U, 65521U}) {
+            auto field = make_gf(base);
+            for (uintmax_t i = 0; i < 10; ++i) {
+                const auto f = gfpoly::random(field, 1 + i * 9);
+                const gfmod mod(f);
+                REQUIRE(mod.modulus() == f / f[f.degree()]);
+                const auto a = gfpoly::random(field, i * 11) % f, b = gfpoly::random(field, i * 5);
+                REQUIRE(mod.mulmod(a, b) == a * b % f);
+                REQUIRE(mod.sqrmod(a) == a * a % f);
+                auto pow = gfpoly(field, 1);
+                for (uintmax_t k = 0; k < 13; ++k) {
+                    pow = pow * a % f;
+                }
+                REQUIRE(mod.powmod(a, 13) == pow);
+                REQUIRE(mod.powmod(a, detail::biguint(13)) == pow);
+                REQUIRE(mod.x_powmod(base * 5 + i) == detail::x_pow_mod(base * 5 + i, f));
+                REQUIRE(mod.x_powmod(detail::biguint::power(base, 30)) ==
+                        mod.powmod(gfpoly(field, {0, 1}), detail::biguint::power(base, 30)));
+            }
+        }
+    }
+    detail::newton_threshold = newton;
+}
+
+TEST_CASE("sieve rejects only reducible polynomials", "[gfcheck]") {
+    for (const uintmax_t base : {2U, 3U, 5U, 101U}) {
+        auto field = make_gf(base);
+        for (uintmax_t degree = 1; degree <= (base < 5 ? 7U : 3U); ++degree) {
+            for (uintmax_t index = 0, total = monic_count(field, degree); index < total;
+                 index += (base > 5) ? 97 : 1) {
+                const auto poly = make_monic(field, degree, index);
+                const auto irr = is_irreducible_benor(poly);
+                if (has_small_factor(poly)) {
+                    REQUIRE_FALSE(irr);
+                }
+                REQUIRE(is_irreducible_sieved(poly) == irr);
+                REQUIRE(multithread::check(poly, multithread::irreducible_method::sieve,
+                                           multithread::primitive_method::nil).irreducible == irr);
+            }
+        }
+    }
+    auto gf3 = make_gf(3);
+    // (x^2 + 1)(x^5 + 2x + 1) has no roots, so the product of small irreducibles is required
+    REQUIRE(has_small_factor(gfpoly(gf3, {1, 0, 1}) * gfpoly(gf3, {1, 2, 0, 0, 0, 1})));
+}
+
+TEST_CASE("gf_view works the same way as gf", "[gf_view]") {
+    auto gf7 = make_gf(7);
+    const gf_view view = field_view(gf7);
+    REQUIRE(sizeof(gfn_view) < sizeof(gfn));
+    REQUIRE(view == field_view(make_gf(7)));
+    REQUIRE(view != field_view(make_gf(5)));
+    for (uintmax_t a = 0; a < 7; ++a) {
+        for (uintmax_t b = 0; b < 7; ++b) {
+            const auto x = gfn_view(view, a), y = gfn_view(view, b);
+            REQUIRE((x + y).value() == (gfn(gf7, a) + gfn(gf7, b)).value());
+            REQUIRE((x - y).value() == (gfn(gf7, a) - gfn(gf7, b)).value());
+            REQUIRE((x * y).value() == (gfn(gf7, a) * gfn(gf7, b)).value());
+        }
+        auto p = gfn(gf7, 1);
+        for (uintmax_t e = 0; e < 20; ++e, p *= a) {
+            REQUIRE(pow(gfn_view(view, a), e) == p.value());
+        }
+    }
+    for (uintmax_t i = 0; i < 50; ++i) {
+        const auto poly = gfpoly::random(gf7, 2 + i % 7);
+        std::vector<uintmax_t> coef;
+        for (uintmax_t j = 0; j < poly.size(); ++j) {
+            coef.push_back(poly[j]);
+        }
+        const auto light = basic_gfpoly<gf_view>(view, coef);
+        REQUIRE(is_irreducible(light) == is_irreducible(poly));
+        REQUIRE(is_primitive(light) == is_primitive(poly));
+        REQUIRE((light * light).degree() == 2 * poly.degree());
+    }
+}
+
+TEST_CASE("random candidates are reproducible from a seed", "[gfpoly]") {
+    auto gf5 = make_gf(5);
+    const uintmax_t degree = 6, count = 200;
+    const auto batch = random_batch(gf5, degree, count, 42);
+    REQUIRE(batch.size() == count * (degree + 1));
+    REQUIRE(batch == random_batch(gf5, degree, count, 42));
+    REQUIRE(batch != random_batch(gf5, degree, count, 43));
+    // any sub-range is the same, so workers could generate disjoint ranges
+    const auto tail = random_batch(gf5, degree, count / 2, 42, count / 2);
+    REQUIRE(std::equal(tail.begin(), tail.end(), batch.begin() + (count / 2) * (degree + 1)));
+    std::vector<uintmax_t> hits(5, 0);
+    for (uintmax_t i = 0; i < count; ++i) {
+        const auto poly = random_indexed(gf5, degree, 42, i);
+        REQUIRE(poly.degree() == degree);
+        REQUIRE(poly[0] != 0);
+        for (uintmax_t j = 0; j <= degree; ++j) {
+            REQUIRE(poly[j] == batch[i * (degree + 1) + j]);
+        }
+        for (uintmax_t j = 1; j < degree; ++j) {
+            ++hits[poly[j]];
+        }
+    }
+    for (auto h : hits) {
+        REQUIRE(h > 0);
+    }
+    REQUIRE(random_indexed(gf5, 0, 42, 0) == gfpoly(gf5, {1}));
+
+    random_engine a(7), b(7);
+    REQUIRE(gfpoly::random(gf5, degree, a) == gfpoly::random(gf5, degree, b));
+    REQUIRE(gfn::random(gf5, a) == gfn::random(gf5, b).value());
+
+    // default generators are per thread
+    std::vector<std::thread> pool;
+    std::atomic<bool> valid(true);
+    for (int t = 0; t < 4; ++t) {
+        pool.emplace_back([&]() {
+            for (int i = 0; i < 1000; ++i) {
+                const auto poly = gfpoly::random(gf5, degree);
+                if (poly.degree() != degree || poly[0] == 0 || gfn::random(gf5).value() >= 5) {
+                    valid = false;
+                }
+            }
+        });
+    }
+    for (auto &t : pool) {
+        t.join();
+    }
+    REQUIRE(valid);
+}
+
+TEST_CASE("gfpoly_batch operations match single polynomials", "[gfbatch]") {
+    for (uintmax_t P : {2, 3, 7, 65521}) {
+        auto field = make_gf(P);
+        const uintmax_t degree = 9, count = 37;
+        const auto batch = gfpoly_batch::random(field, degree, count, P);
+        REQUIRE(batch.count() == count);
+        REQUIRE(batch.is_exact());
+        const auto polys = batch.rows();
+        REQUIRE(gfpoly_batch(field, degree, random_batch(field, degree, count, P)).rows() == polys);
+        REQUIRE(gfpoly_batch(field, polys).rows() == polys);
+
+        const auto g = gfpoly::random(field, 5);
+        const auto prod = batch.mul(g);
+        const auto xp = batch.x_pow_mod(P * P + 3);
+        const auto xbig = batch.x_pow_mod(detail::biguint::power(P, 4));
+        for (uintmax_t x = 0; x < std::min<uintmax_t>(P, 5); ++x) {
+            const auto val = batch.eval(x);
+            for (uintmax_t r = 0; r < count; ++r) {
+                gfn acc(field, 0), pw(field, 1);
+                for (uintmax_t j = 0; j <= degree; ++j, pw *= x) {
+                    acc += pw * polys[r][j];
+                }
+                REQUIRE(val[r] == acc.value());
+            }
+        }
+        for (uintmax_t r = 0; r < count; ++r) {
+            REQUIRE(prod.row(r) == polys[r] * g);
+            REQUIRE(xp.row(r) == detail::x_pow_mod(P * P + 3, polys[r]));
+            REQUIRE(xbig.row(r) == detail::x_pow_mod(detail::biguint::power(P, 4), polys[r]));
+        }
+
+        using multithread::irreducible_method;
+        using multithread::primitive_method;
+        for (auto m : {irreducible_method::berlekamp, irreducible_method::rabin, irreducible_method::benor}) {
+            const auto res = multithread::check(batch, m, primitive_method::nil);
+            for (uintmax_t r = 0; r < count; ++r) {
+                REQUIRE(res[r].irreducible == is_irreducible(polys[r]));
+                REQUIRE(res[r].primitive);
+            }
+        }
+    }
+    auto gf5 = make_gf(5);
+    REQUIRE(gfpoly_batch(gf5, {gfpoly(gf5, {1, 2}), gfpoly(gf5, {3})}).degree() == 1);
+    REQUIRE_FALSE(gfpoly_batch(gf5, {gfpoly(gf5, {1, 2}), gfpoly(gf5, {3})}).is_exact());
+    REQUIRE_THROWS(gfpoly_batch(gf5, {gfpoly(gf5, {1, 2}), gfpoly(gf5, {3})}).x_pow_mod(5));
+    REQUIRE_THROWS(gfpoly_batch(gf5, 2, std::vector<uintmax_t>(5, 1)));
+    const auto lin = gfpoly_batch(gf5, {gfpoly(gf5, {1, 2}), gfpoly(gf5, {3, 1})}).x_pow_mod(7);
+    REQUIRE(lin.row(0) == detail::x_pow_mod(7, gfpoly(gf5, {1, 2})));
+    REQUIRE(lin.row(1) == detail::x_pow_mod(7, gfpoly(gf5, {3, 1})));
+}
+
+TEST_CASE("distinct degree factorization", "[gfcheck]") {
+    for (uintmax_t P : {2, 3, 7}) {
+        auto field = make_gf(P);
+        for (uintmax_t i = 0; i < 60; ++i) {
+            // product of random factors, some of them repeated
+            std::vector<gfpoly> factors;
+            gfpoly poly(field, {1});
+            for (uintmax_t k = 0; k < 1 + i % 4; ++k) {
+                auto f = gfpoly::random(field, 1 + (i * 7 + k * 3) % 6);
+                for (; !is_irreducible(f); f = gfpoly::random(field, f.degree())) {}
+                const auto times = (i % 5 == 0 && k == 0) ? 2 : 1;
+                for (int t = 0; t < times; ++t) {
+                    poly *= f;
+                    factors.push_back(f);
+                }
+            }
+            std::vector<uintmax_t> degrees;
+            for (const auto &f : factors) {
+                degrees.push_back(f.degree());
+            }
+            std::sort(degrees.begin(), degrees.end());
+            REQUIRE(factor_degrees(poly) == degrees);
+
+            const auto parts = distinct_degree_factor(poly * gfn(field, P - 1));
+            gfpoly prod(field, {1});
+            for (std::size_t k = 0; k < parts.size(); ++k) {
+                REQUIRE(parts[k].factor[parts[k].factor.degree()] == 1);
+                REQUIRE(parts[k].factor.degree() % parts[k].degree == 0);
+                REQUIRE((k == 0 || parts[k - 1].degree < parts[k].degree));
+                prod *= parts[k].factor;
+            }
+            REQUIRE(prod == poly);
+            REQUIRE(is_irreducible_benor(poly) == (degrees.size() == 1));
+        }
+    }
+    auto gf3 = make_gf(3);
+    REQUIRE(distinct_degree_factor(gfpoly(gf3, {2})).empty());
+    REQUIRE(factor_degrees(gfpoly(gf3, {0, 0, 1})) == std::vector<uintmax_t>{1, 1});
+    REQUIRE_THROWS(distinct_degree_factor(gfpoly(gf3)));
+}
+
+TEST_CASE("tests split between threads give the same answers", "[gfcheck]") {
+    const auto threshold = detail::parallel_threshold;
+    detail::parallel_threshold = 8;
+    for (uintmax_t P : {3, 7, 65521}) {
+        auto field = make_gf(P);
+        for (uintmax_t i = 0; i < 30; ++i) {
+            auto poly = gfpoly::random(field, 8 + i % 9);
+            if (i % 3 == 0) {
+                for (; !is_irreducible(poly); poly = gfpoly::random(field, poly.degree())) {}
+            }
+            const auto expected = is_irreducible(poly);
+            for (unsigned threads : {2U, 3U}) {
+                REQUIRE(is_irreducible_berlekamp(poly, threads) == expected);
+                REQUIRE(is_irreducible_rabin(poly, threads) == expected);
+                REQUIRE(is_irreducible_benor(poly, threads) == expected);
+                REQUIRE(multithread::check(poly, multithread::irreducible_method::sieve,
+                                           multithread::primitive_method::nil, threads).irreducible == expected);
+            }
+        }
+    }
+    detail::parallel_threshold = threshold;
+
+    executor exec(4);
+    REQUIRE(exec.threads() == 4);
+    std::vector<uintmax_t> hits(1000, 0);
+    for (int round = 0; round < 20; ++round) {
+        exec.parallel_for(hits.size(), [&](uintmax_t begin, uintmax_t end) {
+            for (auto k = begin; k < end; ++k) {
+                ++hits[k];
+            }
+        });
+    }
+    REQUIRE(std::all_of(hits.begin(), hits.end(), [](uintmax_t h) { return h == 20; }));
+    REQUIRE_THROWS(exec.parallel_for(10, [](uintmax_t begin, uintmax_t) {
+        if (begin > 0) {
+            throw std::runtime_error("worker failure");
+        }
+    }));
+}
+
+TEST_CASE("pipeline cancels checks in flight and streams results", "[pipeline]") {
+    auto gf3 = make_gf(3);
+    // irreducible polynomial passes the early exits, so the tests reach their checkpoints
+    gfpoly irr(gf3);
+    for (uint64_t index = 0; !is_irreducible(irr = random_indexed(gf3, 40, 1, index)); ++index) {}
+    std::atomic<bool> flag(true);
+    {
+        const stop_scope scope{stop_token(flag)};
+        REQUIRE(this_stop_token().stop_requested());
+        REQUIRE_THROWS_AS(is_irreducible_rabin(irr), operation_cancelled);
+        REQUIRE_THROWS_AS(is_irreducible_berlekamp(irr), operation_cancelled);
+    }
+    REQUIRE_FALSE(this_stop_token().stop_requested());
+    REQUIRE_NOTHROW(is_irreducible_rabin(gfpoly::random(gf3, 40)));
+
+    for (unsigned threads : {1U, 3U}) {
+        // tasks are generated one by one, so finished one is handed out at once
+        multithread::pipeline<uintmax_t, uintmax_t> ch(threads, 1);
+        // every input except the first one is a check which never ends unless cancelled
+        std::atomic<uintmax_t> index(0);
+        auto input = [&]() { return index++; };
+        auto payload = [threads](const uintmax_t &in, std::optional<uintmax_t> &out) {
+            while (in > 0 && threads > 1) {
+                detail::throw_if_stopped();
+                std::this_thread::yield();
+            }
+            out.emplace(in * 2);
+        };
+        uintmax_t calls = 0;
+        ch.chain(input, payload, [&](const uintmax_t &in, const uintmax_t &out) {
+            ++calls;
+            REQUIRE(out == in * 2);
+            return true;
+        });
+        REQUIRE(calls == 1);
+
+        // results are pulled while workers keep processing inputs
+        std::atomic<uintmax_t> counter(0);
+        ch.stream([&]() { return counter++; }, [](const uintmax_t &in, std::optional<uintmax_t> &out) {
+            out.emplace(in + 1);
+        });
+        std::vector<bool> seen(100, false);
+        for (int i = 0; i < 50; ++i) {
+            const auto res = ch.next();
+            REQUIRE(res);
+            REQUIRE(res->second == res->first + 1);
+            REQUIRE(res->first < seen.size());
+            REQUIRE_FALSE(seen[res->first]);
+            seen[res->first] = true;
+        }
+        ch.stop(false);
+        uintmax_t rest = 0;
+        while (ch.next()) {
+            ++rest;
+        }
+        // tasks generated, but not started before stop are discarded
+        REQUIRE(50 + rest <= counter);
+        REQUIRE_FALSE(ch.next());
+    }
+}
+
+TEST_CASE("pipeline rethrows exceptions of input and payload", "[pipeline]") {
+    for (unsigned threads : {1U, 2U, 4U}) {
+        multithread::pipeline<int, int> ch(threads);
+        int index = 0;
+        auto input = [&]() -> int {
+            if (index == 20) {
+                throw std::runtime_error("input failure");
+            }
+            return index++;
+        };
+        auto payload = [](const int &in, std::optional<int> &out) {
+            out.emplace(in);
+        };
+        auto never = [](const int &, const int &) { return false; };
+        REQUIRE_THROWS_WITH(ch.chain(input, payload, never), "input failure");
+
+        index = 0;
+        REQUIRE_THROWS_WITH(ch.chain([&]() { return index++; }, [](const int &in, std::optional<int> &out) {
+            if (in == 20) {
+                throw std::runtime_error("payload failure");
+            }
+            out.emplace(in);
+        }, never), "payload failure");
+
+        index = 0;
+        REQUIRE_THROWS_WITH(ch.chain_batch([&]() { return index++; },
+                                           [](const std::vector<int> &, std::vector<std::optional<int>> &) {
+                                               throw std::runtime_error("batch failure");
+                                           }, never), "batch failure");
+
+        // pipeline stays usable after failed session
+        index = 0;
+        int calls = 0;
+        ch.chain([&]() { return index++; }, payload, [&](const int &in, const int &out) {
+            REQUIRE(in == out);
+            return ++calls == 10;
+        });
+        REQUIRE(calls == 10);
+
+        index = 0;
+        ch.stream(input, payload);
+        REQUIRE_THROWS_WITH([&]() { while (ch.next()) {} }(), "input failure");
+        REQUIRE_FALSE(ch.next());
+    }
+}
+
+TEST_CASE("chain requests one input per worker ahead", "[pipeline]") {
+    multithread::pipeline<int, int> ch(3);
+    std::atomic<int> index(0);
+    std::atomic<bool> release(false);
+    int ahead = 0;
+    std::thread timer([&]() {
+        // both workers are blocked in payload by then
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        ahead = index.load();
+        release.store(true);
+    });
+    ch.chain([&]() { return index++; }, [&](const int &in, std::optional<int> &out) {
+        while (!release.load()) {
+            std::this_thread::yield();
+        }
+        out.emplace(in);
+    }, [](const int &, const int &) { return true; });
+    timer.join();
+    REQUIRE(ahead <= 2);
+}
+
+TEST_CASE("gftable stores and finds polynomials", "[gftable]") {
+    const std::string path = "gftable_test.bin";
+    std::remove(path.c_str());
+    auto gf2 = make_gf(2), gf5 = make_gf(5), gf7 = make_gf(7);
+    // x^5 + x^2 + 1 is primitive over GF[2]
+    const gfpoly p2(gf2, {1, 0, 1, 0, 0, 1});
+    // 3 * (x^3 + 3x + 2) is irreducible over GF[5], stored monic
+    const gfpoly p5(gf5, {1, 4, 0, 3});
+    {
+        gftable table(path);
+        REQUIRE(table.size() == 0);
+        REQUIRE_FALSE(table.find(gf2, 5, gftable::irreducible));
+        table.append(p2, gftable::primitive);
+        table.append(p5, gftable::irreducible);
+        REQUIRE(table.size() == 2);
+        REQUIRE(table.find(gf2, 5, gftable::primitive) == p2);
+        REQUIRE(table.find(gf5, 3, gftable::irreducible) == gfpoly(gf5, {2, 3, 0, 1}));
+    }
+    {
+        gftable table(path);
+        REQUIRE(table.size() == 2);
+        // primitive polynomial is irreducible as well
+        REQUIRE(table.find(gf2, 5, gftable::irreducible) == p2);
+        REQUIRE(table.find(gf5, 3, gftable::irreducible) == gfpoly(gf5, {2, 3, 0, 1}));
+        REQUIRE_FALSE(table.find(gf5, 3, gftable::primitive));
+        REQUIRE_FALSE(table.find(gf7, 3, gftable::irreducible));
+
+        const auto found = table.find_or_search(gf7, 6, gftable::primitive, 2);
+        REQUIRE(found.degree() == 6);
+        REQUIRE(is_irreducible(found));
+        REQUIRE(is_primitive(found));
+        REQUIRE(table.size() == 3);
+        REQUIRE(table.find_or_search(gf7, 6, gftable::primitive, 2) == found);
+        REQUIRE(table.size() == 3);
+    }
+    {
+        const gftable table(path);
+        REQUIRE(table.size() == 3);
+        REQUIRE(table.find(gf2, 5, gftable::primitive) == p2);
+        REQUIRE(is_primitive(*table.find(gf7, 6, gftable::primitive)));
+    }
+    std::remove(path.c_str());
+    {
+        std::ofstream out(path, std::ios::binary);
+        out << "not a table at all";
+    }
+    REQUIRE_THROWS_AS(gftable(path), std::runtime_error);
+    std::remove(path.c_str());
+}
+
+TEST_CASE("gfpoly streams are read and written in bulk", "[gfio]") {
+    const auto saved = detail::io_buffer_size;
+    for (const std::size_t buffer : {std::size_t(16), saved}) {
+        // small buffer makes polynomials cross the refill boundary
+        detail::io_buffer_size = buffer;
+        for (const uintmax_t P : {2ULL, 3ULL, 5ULL, 65537ULL, 2305843009213693951ULL}) {
+            auto field = make_gf(P);
+            std::vector<gfpoly> polys{gfpoly(field)};
+            for (uintmax_t degree : {0, 1, 7, 63, 64, 200}) {
+                polys.emplace_back(gfpoly::random(field, degree));
+            }
+            for (const auto format : {gfpoly_format::text, gfpoly_format::binary}) {
+                std::stringstream ss;
+                {
+                    gfpoly_writer writer(ss, field, format);
+                    writer.write(polys);
+                }
+                gfpoly_reader reader(ss, field, format);
+                const auto first = reader.read(2);
+                REQUIRE(first.size() == 2);
+                const auto rest = reader.read();
+                REQUIRE(rest.size() == polys.size() - 2);
+                REQUIRE(first[0] == polys[0]);
+                REQUIRE(first[1] == polys[1]);
+                for (std::size_t i = 0; i < rest.size(); ++i) {
+                    REQUIRE(rest[i] == polys[i + 2]);
+                }
+                REQUIRE_FALSE(reader.next());
+            }
+        }
+    }
+    detail::io_buffer_size = saved;
+
+    auto gf5 = make_gf(5), gf7 = make_gf(7);
+    const gfpoly p(gf5, {1, 2, 3});
+    SECTION("text format is the one of stream operators") {
+        std::stringstream ss;
+        ss << p << "\n\n" << p << " {4,0, 1}";
+        gfpoly_reader reader(ss, gf5);
+        REQUIRE(reader.next() == p);
+        REQUIRE(reader.next() == p);
+        REQUIRE(reader.next() == gfpoly(gf5, {4, 0, 1}));
+        REQUIRE_FALSE(reader.next());
+
+        std::stringstream out;
+        {
+            gfpoly_writer writer(out, gf5);
+            writer.write(p);
+        }
+        gfpoly q(gf5);
+        REQUIRE(out >> q);
+        REQUIRE(q == p);
+    }SECTION("batches are written row by row") {
+        const auto batch = gfpoly_batch::random(gf5, 6, 10, 42, 0);
+        std::stringstream ss;
+        {
+            gfpoly_writer writer(ss, gf5, gfpoly_format::binary);
+            writer.write(batch);
+        }
+        gfpoly_reader reader(ss, gf5, gfpoly_format::binary);
+        REQUIRE(reader.read() == batch.rows());
+    }SECTION("malformed input is rejected") {
+        for (const char *text : {"{1, 2", "1, 2}", "{1, -2}", "{1, x}", "{1 {2}}"}) {
+            std::stringstream ss(text);
+            gfpoly_reader reader(ss, gf5);
+            REQUIRE_THROWS_AS(reader.read(), std::invalid_argument);
+        }
+        std::stringstream bad("not a binary stream");
+        REQUIRE_THROWS_AS(gfpoly_reader(bad, gf5, gfpoly_format::binary), std::invalid_argument);
+        std::stringstream ss;
+        {
+            gfpoly_writer writer(ss, gf5, gfpoly_format::binary);
+            writer.write(p);
+        }
+        REQUIRE_THROWS_AS(gfpoly_reader(ss, gf7, gfpoly_format::binary), std::invalid_argument);
+        // truncated polynomial
+        const auto data = ss.str();
+        std::stringstream cut(data.substr(0, data.size() - 1));
+        gfpoly_reader reader(cut, gf5, gfpoly_format::binary);
+        REQUIRE_THROWS_AS(reader.read(), std::invalid_argument);
+    }
+}
+
+TEST_CASE("polynomials are evaluated at many points and roots are found", "[gfeval]") {
+    auto gf7 = make_gf(7);
+    const gfpoly p(gf7, {3, 0, 2, 1});
+    REQUIRE(p.eval(0) == 3);
+    REQUIRE(p.eval(2) == (3 + 2 * 4 + 8) % 7);
+    REQUIRE(p.eval(9) == p.eval(2));
+    REQUIRE(p.eval(gfn(gf7, 2)) == gfn(gf7, p.eval(2)));
+    REQUIRE(gfpoly(gf7).eval(5) == 0);
+
+    const auto saved = detail::multipoint_threshold;
+    for (const uintmax_t threshold : {uintmax_t(1), uintmax_t(4), saved}) {
+        detail::multipoint_threshold = threshold;
+        for (const uintmax_t P : {2ULL, 65537ULL, 2305843009213693951ULL}) {
+            auto field = make_gf(P);
+            std::vector<uintmax_t> points;
+            for (uintmax_t i = 0; i < 300; ++i) {
+                points.push_back(gfn::random(field).value());
+            }
+            points.push_back(P + 1); // not reduced point
+            for (const uintmax_t degree : {0, 5, 100, 700}) {
+                const auto poly = gfpoly::random(field, degree);
+                const auto val = eval(poly, points);
+                REQUIRE(val.size() == points.size());
+                for (std::size_t i = 0; i < points.size(); ++i) {
+                    REQUIRE(val[i] == poly.eval(points[i]));
+                }
+            }
+        }
+    }
+    detail::multipoint_threshold = saved;
+
+    SECTION("roots are found without trying all the values") {
+        const auto saved_scan = detail::root_scan_max;
+        for (const uintmax_t scan : {uintmax_t(0), saved_scan}) {
+            detail::root_scan_max = scan;
+            for (const uintmax_t P : {2ULL, 5ULL, 65537ULL, 2305843009213693951ULL}) {
+                auto field = make_gf(P);
+                // product of (x - r) for the roots, repeated ones and an irreducible factor
+                std::vector<uintmax_t> expected;
+                gfpoly poly(field, 1);
+                for (uintmax_t i = 0; i < std::min<uintmax_t>(P, 20); ++i) {
+                    const auto r = (P > 20) ? gfn::random(field).value() : i * 3 % P;
+                    poly *= gfpoly(field, {field->neg(r), 1});
+                    if (i % 4 == 0) {
+                        poly *= gfpoly(field, {field->neg(r), 1});
+                    }
+                    expected.push_back(r);
+                }
+                std::sort(expected.begin(), expected.end());
+                expected.erase(std::unique(expected.begin(), expected.end()), expected.end());
+                REQUIRE(roots(poly) == expected);
+                REQUIRE(has_root(poly));
+                REQUIRE(root_product(poly).degree() == expected.size());
+
+                gfpoly irr(field);
+                do {
+                    irr = gfpoly::random(field, 4);
+                } while (!is_irreducible(irr));
+                REQUIRE(roots(poly * irr * 3) == expected);
+                REQUIRE(roots(irr).empty());
+                REQUIRE_FALSE(has_root(irr));
+            }
+        }
+        detail::root_scan_max = saved_scan;
+        REQUIRE(roots(gfpoly(gf7, 3)).empty());
+        REQUIRE_THROWS_AS(roots(gfpoly(gf7)), std::domain_error);
+    }
+}
+
+TEST_CASE("stats count operations and rejections", "[stats]") {
+    REQUIRE(stats_enabled);
+    auto gf3 = make_gf(3);
+    reset_stats();
+    const auto a = gfpoly::random(gf3, 20), b = gfpoly::random(gf3, 20);
+    const auto prod = a * b; // leading coefficients are non-zero
+    REQUIRE(stats()[counter::multiplications] == 1);
+    REQUIRE_FALSE(is_irreducible_rabin(prod));
+    auto s = stats();
+    REQUIRE(s[counter::remainders] > 0);
+    REQUIRE(s[counter::x_pow_steps] > 0);
+    REQUIRE(s[counter::gcd_steps] > 0);
+    REQUIRE(s[counter::checks] == 0);
+
+    reset_stats();
+    REQUIRE(stats()[counter::multiplications] == 0);
+    using multithread::irreducible_method;
+    using multithread::primitive_method;
+    REQUIRE_FALSE(multithread::check(gfpoly(gf3, {0, 1, 1}), irreducible_method::benor,
+                                     primitive_method::nil).irreducible);
+    // x^2 + 1 is irreducible over GF[3], but x is not primitive element
+    REQUIRE_FALSE(multithread::check(gfpoly(gf3, {1, 0, 1}), irreducible_method::recommended,
+                                     primitive_method::recommended).primitive);
+    REQUIRE_FALSE(multithread::check(prod * prod, irreducible_method::sieve,
+                                     primitive_method::nil).irreducible);
+    REQUIRE_FALSE(multithread::check(prod, irreducible_method::rabin,
+                                     primitive_method::nil).irreducible);
+    s = stats();
+    REQUIRE(s[counter::checks] == 4);
+    REQUIRE(s[counter::rejected_constant] == 1);
+    REQUIRE(s[counter::rejected_primitive] == 1);
+    REQUIRE(s[counter::rejected_sieve] + s[counter::rejected_benor] == 1);
+    REQUIRE(s[counter::rejected_rabin] == 1);
+    uint64_t histogram = 0;
+    for (const auto v : s.latency) {
+        histogram += v;
+    }
+    REQUIRE(histogram == 4);
+
+    SECTION("counters of pipeline workers are summed") {
+        reset_stats();
+        multithread::polychecker ch(3);
+        std::atomic<uint64_t> index(0);
+        uintmax_t done = 0;
+        ch.chain([&]() { return random_indexed(gf3, 12, 7, index++); },
+                 multithread::make_check_func(irreducible_method::recommended, primitive_method::nil),
+                 [&](const gfpoly &, const multithread::check_result &) { return ++done == 100; });
+        s = stats();
+        REQUIRE(s[counter::checks] >= 100);
+        REQUIRE(s[counter::pipeline_tasks] > 0);
+        REQUIRE(std::string(counter_name(counter::pipeline_wait_ns)) == "pipeline_wait_ns");
+    }
+}
+
+TEST_CASE("irreducibility test is chosen by cost table", "[gfcost]") {
+    using b = test_backend;
+    cost_table table({
+        {2, 64, b::packed_gf2, {100, 200, 300, 0}},
+        {3, 64, b::generic, {300, 100, 200, 50}},
+        {3, 512, b::generic, {300, 200, 100, 0}},
+    });
+    REQUIRE(table.pick(2, 16).test == irreducible_test::berlekamp);
+    REQUIRE_FALSE(table.pick(2, 16).sieve);
+    // nearest entry by base and degree, GF[2] has its own backend
+    REQUIRE(table.pick(5, 32).test == irreducible_test::rabin);
+    REQUIRE(table.pick(5, 32).sieve);
+    REQUIRE(table.pick(3, 1024).test == irreducible_test::benor);
+    REQUIRE_FALSE(is_irreducible(gfpoly(make_gf(3))));
+    REQUIRE_FALSE(is_irreducible(gfpoly(make_gf(2))));
+    REQUIRE_FALSE(table.pick(3, 1024).sieve);
+    // without entries of the same backend all of them are taken
+    REQUIRE(cost_table({{3, 64, b::generic, {300, 100, 200, 0}}}).pick(2, 64).test == irreducible_test::rabin);
+    REQUIRE(cost_table().pick(2, 64).test == irreducible_test::berlekamp);
+    REQUIRE(cost_table().pick(3, 64).test == irreducible_test::benor);
+    REQUIRE(test_backend_for(3, detail::ntt_threshold) == b::ntt);
+
+    std::stringstream ss;
+    ss << table;
+    cost_table read;
+    ss >> read;
+    REQUIRE(read.entries().size() == 3);
+    REQUIRE(read.entries()[1].ns[3] == 50);
+    REQUIRE(read.pick(5, 32).test == irreducible_test::rabin);
+    std::stringstream bad("3 64 gpu 1 2 3 4\n");
+    REQUIRE_THROWS_AS(bad >> read, std::invalid_argument);
+    REQUIRE_THROWS_AS(load_irreducible_costs("/nonexistent/costs.txt"), std::runtime_error);
+
+    SECTION("every choice finds the same polynomials") {
+        const auto gf3 = make_gf(3);
+        const auto original = irreducible_costs();
+        for (unsigned t = 0; t < irreducible_test_count; ++t) {
+            std::array<double, irreducible_test_count> ns{300, 300, 300, 300};
+            ns[t] = 100;
+            set_irreducible_costs(cost_table({{2, 8, b::packed_gf2, ns}, {3, 8, b::generic, ns}}));
+            uintmax_t found2 = 0, found3 = 0, checked = 0;
+            for (uintmax_t index = 0; index < 256; ++index) {
+                found2 += is_irreducible(make_monic(make_gf(2), 8, index));
+                if (index < 81) {
+                    const auto poly = make_monic(gf3, 4, index);
+                    found3 += is_irreducible(poly);
+                    checked += multithread::check(poly, multithread::irreducible_method::recommended,
+                                                  multithread::primitive_method::nil).irreducible;
+                }
+            }
+            REQUIRE(found2 == 30);
+            REQUIRE(found3 == 18);
+            REQUIRE(checked == 18);
+        }
+        set_irreducible_costs(original);
+        REQUIRE(irreducible_costs().entries().size() == cost_table::builtin().entries().size());
+    }
+}
+
+TEST_CASE("extension fields match polynomial arithmetic", "[gfext]") {
+    const auto gf2 = make_gf(2), gf3 = make_gf(3);
+    REQUIRE_THROWS(make_gfext(gfpoly(gf2, {1, 0, 1}))); // (x + 1)^2
+    REQUIRE_THROWS(make_gfext(gfpoly(gf3, 2)));
+    REQUIRE_THROWS(make_gfext(gfpoly(gf3, std::vector<uintmax_t>(41, 1))));
+    std::vector<uintmax_t> wide(64, 0);
+    wide[0] = wide[1] = wide[63] = 1;
+    REQUIRE_THROWS(make_gfext(gfpoly(gf2, wide), gfext_arithmetic::reduction));
+
+    // every operation on residues is the one on polynomials modulo f
+    for (const auto &f : {gfpoly(gf2, {1, 1, 0, 0, 1}), gfpoly(gf3, {2, 1, 0, 2}),
+                          gfpoly(make_gf(5), {2, 1, 1}), gfpoly(gf3, {2, 1})}) {
+        const auto tables = make_gfext(f, gfext_arithmetic::tables);
+        const auto direct = make_gfext(f, gfext_arithmetic::reduction);
+        REQUIRE(tables == direct);
+        REQUIRE(tables->characteristic() == f.base());
+        REQUIRE(tables->degree() == f.degree());
+        REQUIRE(tables->modulus() == f * f.field()->mul_inv(f[f.degree()]));
+        for (uintmax_t a = 0; a < tables->base(); ++a) {
+            const auto pa = tables->unpack(a);
+            REQUIRE(tables->pack(pa) == a);
+            REQUIRE(tables->neg(a) == tables->pack(-pa));
+            REQUIRE(direct->neg(a) == tables->neg(a));
+            if (a) {
+                REQUIRE(tables->mul(a, tables->mul_inv(a)) == 1);
+                REQUIRE(direct->mul_inv(a) == tables->mul_inv(a));
+            }
+            for (uintmax_t b = 0; b < tables->base(); ++b) {
+                const auto pb = tables->unpack(b);
+                REQUIRE(tables->add(a, b) == tables->pack(pa + pb));
+                REQUIRE(tables->sub(a, b) == tables->pack(pa - pb));
+                REQUIRE(tables->mul(a, b) == tables->pack(pa * pb));
+                REQUIRE(direct->add(a, b) == tables->add(a, b));
+                REQUIRE(direct->sub(a, b) == tables->sub(a, b));
+                REQUIRE(direct->mul(a, b) == tables->mul(a, b));
+            }
+        }
+        REQUIRE_THROWS(tables->mul_inv(0));
+        REQUIRE_THROWS(direct->mul_inv(tables->base()));
+    }
+    REQUIRE(make_gfext(gfpoly(gf2, {1, 1, 1})) != make_gfext(gfpoly(gf2, {1, 1, 0, 1})));
+    REQUIRE(make_gfext(gfpoly(gf2, {1, 1, 0, 1})) != make_gfext(gfpoly(gf2, {1, 0, 1, 1})));
+
+    SECTION("large fields use reduction") {
+        for (const auto &[P, k] : {std::make_pair(2ULL, 61ULL), std::make_pair(65521ULL, 3ULL)}) {
+            const auto field = make_gf(P);
+            gfpoly f(field);
+            do {
+                f = gfpoly::random(field, k);
+            } while (!is_irreducible(f));
+            const auto ext = make_gfext(f);
+            for (uintmax_t i = 0; i < 200; ++i) {
+                const auto a = gfextn::random(ext), b = gfextn::random(ext);
+                const auto pa = ext->unpack(a.value()), pb = ext->unpack(b.value());
+                REQUIRE((a + b).value() == ext->pack(pa + pb));
+                REQUIRE((a - b).value() == ext->pack(pa - pb));
+                REQUIRE((a * b).value() == ext->pack(pa * pb));
+                if (b) {
+                    REQUIRE(a / b * b == a);
+                }
+            }
+            // multiplicative group has P^k - 1 elements
+            const auto g = gfextn::random(ext);
+            REQUIRE((g.is_zero() || pow(g, ext->base() - 1) == 1));
+        }
+    }
+}
+
+TEST_CASE("checks work over extension fields", "[gfext]") {
+    // the same counts as over prime fields with P^k elements
+    auto count = [](const gfext &field, uintmax_t n, auto check) {
+        uintmax_t total = 1, res = 0;
+        for (uintmax_t i = 0; i < n; ++i) {
+            total *= field->base();
+        }
+        for (uintmax_t index = 0; index < total; ++index) {
+            res += check(make_monic(field, n, index)) ? 1 : 0;
+        }
+        return res;
+    };
+    auto berlekamp = [](const gfextpoly &p) { return is_irreducible_berlekamp(p); };
+    auto rabin = [](const gfextpoly &p) { return is_irreducible_rabin(p); };
+    auto benor = [](const gfextpoly &p) { return is_irreducible_benor(p); };
+    auto recommended = [](const gfextpoly &p) { return is_irreducible(p); };
+    auto sieved = [](const gfextpoly &p) { return is_irreducible_sieved(p); };
+    auto primitive = [](const gfextpoly &p) { return is_primitive(p); };
+    const auto gf4 = make_gfext(gfpoly(make_gf(2), {1, 1, 1}));
+    const auto gf8 = make_gfext(gfpoly(make_gf(2), {1, 1, 0, 1}), gfext_arithmetic::reduction);
+    const auto gf9 = make_gfext(gfpoly(make_gf(3), {2, 2, 1}));
+    SECTION("GF[4] degree 4") {
+        REQUIRE(count(gf4, 4, berlekamp) == 60);
+        REQUIRE(count(gf4, 4, rabin) == 60);
+        REQUIRE(count(gf4, 4, benor) == 60);
+        REQUIRE(count(gf4, 4, recommended) == 60);
+        REQUIRE(count(gf4, 4, sieved) == 60);
+        REQUIRE(count(gf4, 4, primitive) == 32);
+    }SECTION("GF[8] degree 2") {
+        REQUIRE(count(gf8, 2, berlekamp) == 28);
+        REQUIRE(count(gf8, 2, benor) == 28);
+        REQUIRE(count(gf8, 2, primitive) == 18);
+    }SECTION("GF[9] degree 3") {
+        REQUIRE(count(gf9, 3, berlekamp) == 240);
+        REQUIRE(count(gf9, 3, rabin) == 240);
+        REQUIRE(count(gf9, 3, primitive) == 96);
+    }SECTION("derivative uses characteristic") {
+        REQUIRE(detail::derivative(gfextpoly(gf9, {0, 0, 0, 5})).is_zero());
+        REQUIRE(detail::derivative(gfextpoly(gf9, {0, 0, 0, 0, 5})) == gfextpoly(gf9, {0, 0, 0, 5}));
+        REQUIRE(detail::derivative(gfextpoly(gf4, {0, 0, 3, 2})) == gfextpoly(gf4, {0, 0, 2}));
+    }SECTION("roots are found in large fields") {
+        for (const auto &[P, k] : {std::make_pair(2ULL, 8ULL), std::make_pair(3ULL, 4ULL)}) {
+            const auto field = make_gf(P);
+            gfpoly f(field);
+            do {
+                f = gfpoly::random(field, k);
+            } while (!is_irreducible(f));
+            const auto ext = make_gfext(f);
+            REQUIRE(ext->base() > detail::root_scan_max);
+            std::vector<uintmax_t> expected;
+            gfextpoly poly(ext, 1);
+            for (uintmax_t i = 0; i < 10; ++i) {
+                const auto r = gfextn::random(ext).value();
+                poly *= gfextpoly(ext, {ext->neg(r), 1});
+                expected.push_back(r);
+            }
+            std::sort(expected.begin(), expected.end());
+            expected.erase(std::unique(expected.begin(), expected.end()), expected.end());
+            REQUIRE(roots(poly) == expected);
+        }
+    }
+}